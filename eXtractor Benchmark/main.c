@@ -0,0 +1,526 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <errno.h>
+#include <limits.h>
+#include <getopt.h>
+#include <time.h>
+
+#include "render.h"
+#include "parallel.h"
+#include "paletteindex.h"
+#include "tileformat.h"
+#include "datasource.h"
+#include "ZX Spectrum.h"
+#include "Degas.h"
+#include "Commodore 64.h"
+
+/*
+ Times every decoder kernel over the pictures bundled with the source and over large
+ synthetic buffers, and reports the speed of each as MB/s of source data and ns per pixel.
+ Results are listed in a fixed order, one per line of the JSON output, so the output of
+ two commits can be compared with diff. A bundled picture taken for the wrong format
+ fails the run, --list included, which is how ctest checks the detectors.
+ */
+
+#define SYNTHETIC_LENGTH (16L << 20)
+#define SYNTHETIC_SIZE 2048         // Width and height of the synthetic images
+#define TRIALS 5
+
+typedef enum {
+    BenchmarkRender,
+    BenchmarkPaletteScan
+} BenchmarkKind;
+
+typedef struct {
+    char name[96];
+    char input[64];             // File of the corpus, or synthetic
+    BenchmarkKind kind;
+    RenderGeometry geometry;
+    RenderLookup lookup;
+    const uint8_t *bytes;
+    DataSource *source;         // Only used by the palette scan
+    long length;                // Source bytes read by one run
+    long pixels;                // Pixels written by one run
+    double seconds;             // Fastest run
+} Benchmark;
+
+typedef struct {
+    Benchmark *benchmarks;
+    int count;
+    int capacity;
+} Suite;
+
+typedef struct {
+    char *name;
+    uint8_t *bytes;
+    long length;
+} CorpusFile;
+
+static struct {
+    const char *root;
+    const char *output;
+    const char *filter;
+    double minimum;             // Seconds spent on each trial
+    bool list;
+} options;
+
+static Suite suite;
+static RenderPalette palette;
+
+// MARK: - Private Functions
+
+static void usage(const char *command) {
+    printf("Usage: %s [options]\n\n", command);
+    printf("Options:\n");
+    printf("  -r, --root <dir>          Source directory holding Pictures, default is %s.\n", SOURCE_DIR);
+    printf("  -o, --output <file>       Write the results as JSON, - for standard output.\n");
+    printf("  -f, --filter <text>       Only run benchmarks whose name contains the text.\n");
+    printf("  -t, --time <seconds>      Time spent on each of the %d trials, default is 0.1.\n", TRIALS);
+    printf("  -l, --list                List the benchmarks without running them.\n");
+    printf("      --help                Display this help.\n");
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static bool loadFile(const char *path, CorpusFile *file) {
+    DataSource *source = openDataSource(path);
+    if (source == NULL) return false;
+    
+    file->length = dataSourceLength(source);
+    file->bytes = malloc(file->length > 0 ? file->length : 1);
+    if (file->bytes && file->length > 0) memcpy(file->bytes, dataSourceBytes(source, 0, file->length), file->length);
+    closeDataSource(source);
+    return file->bytes != NULL;
+}
+
+static Benchmark *addBenchmark(BenchmarkKind kind, const char *kernel, const char *input) {
+    if (suite.count == suite.capacity) {
+        suite.capacity = suite.capacity ? suite.capacity * 2 : 64;
+        suite.benchmarks = realloc(suite.benchmarks, suite.capacity * sizeof(Benchmark));
+        if (suite.benchmarks == NULL) {
+            fprintf(stderr, "error: out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    Benchmark *benchmark = &suite.benchmarks[suite.count++];
+    memset(benchmark, 0, sizeof(Benchmark));
+    benchmark->kind = kind;
+    snprintf(benchmark->name, sizeof(benchmark->name), "%s/%s", kernel, input);
+    snprintf(benchmark->input, sizeof(benchmark->input), "%s", input);
+    return benchmark;
+}
+
+// Name of the kernel renderToPixelData picks for the geometry.
+static void kernelName(const RenderGeometry *geometry, char *name, size_t length) {
+    if (geometry->layout == RenderLayoutZXScreen) {
+        snprintf(name, length, "zxscreen");
+    } else if (geometry->layout == RenderLayoutC64Hires) {
+        snprintf(name, length, "c64hires");
+    } else if (geometry->layout == RenderLayoutC64Multicolor) {
+        snprintf(name, length, "c64multicolor");
+    } else if (tileFormatBits(geometry->layout) > 0) {
+        static const char *names[] = {
+            [RenderLayoutGameBoyTiles] = "gameboy",
+            [RenderLayoutNESTiles] = "nes",
+            [RenderLayoutSNES4BitTiles] = "snes4",
+            [RenderLayoutSNES8BitTiles] = "snes8",
+            [RenderLayoutMasterSystemTiles] = "sms"
+        };
+        snprintf(name, length, "tiles-%s", names[geometry->layout]);
+    } else if (geometry->planeCount > 1) {
+        snprintf(name, length, "planar%d-%d%s%s", geometry->bitsPerPixel, geometry->planeCount,
+                 geometry->alphaPlane ? "-alpha" : "", geometry->maskPlane ? "-mask" : "");
+    } else {
+        snprintf(name, length, "packed%d%s", geometry->bitsPerPixel, geometry->alphaPlane ? "-alpha" : "");
+    }
+}
+
+static void addRender(const RenderGeometry *geometry, const uint8_t *bytes, long available, const char *input) {
+    char kernel[48];
+    
+    if (isValidGeometry(geometry) == false || bytesPerImage(geometry) > available) {
+        fprintf(stderr, "warning: %s: too short for %dx%d\n", input, geometry->width, geometry->height);
+        return;
+    }
+    
+    kernelName(geometry, kernel, sizeof(kernel));
+    Benchmark *benchmark = addBenchmark(BenchmarkRender, kernel, input);
+    benchmark->geometry = *geometry;
+    benchmark->bytes = bytes;
+    benchmark->length = bytesPerImage(geometry);
+    benchmark->pixels = (long)geometry->width * geometry->height;
+    buildLookup(&benchmark->lookup, geometry, &palette);
+}
+
+static RenderGeometry makeGeometry(int width, int height, int bitsPerPixel, int planeCount) {
+    return (RenderGeometry){
+        .width = width,
+        .height = height,
+        .bitsPerPixel = bitsPerPixel,
+        .planeCount = planeCount,
+        .bigEndian = true,
+        .pixelFormat = RenderPixelFormatRGB555,
+        .tileWidth = 1,
+        .tileHeight = 1
+    };
+}
+
+// Geometry of an uncompressed Windows bitmap, rows are stored bottom up but decode the same.
+static bool bitmapGeometry(const CorpusFile *file, RenderGeometry *geometry, long *offset) {
+    const uint8_t *b = file->bytes;
+    if (file->length < 54 || b[0] != 'B' || b[1] != 'M') return false;
+    
+    *offset = b[10] | b[11] << 8 | b[12] << 16 | (long)b[13] << 24;
+    int width = b[18] | b[19] << 8 | b[20] << 16 | b[21] << 24;
+    int height = b[22] | b[23] << 8 | b[24] << 16 | b[25] << 24;
+    *geometry = makeGeometry(width, height < 0 ? -height : height, b[28] | b[29] << 8, 1);
+    geometry->bigEndian = false;
+    return true;
+}
+
+/*
+ Each picture is claimed by the detector of its own format and no other, as the app tries
+ them in turn. Degas files have no signature, so every other picture must be turned down.
+ */
+static bool isCorpusRecognised(const CorpusFile *file, const char *name) {
+    bool degas = isDegasFormat(file->bytes, (long unsigned int)file->length);
+    
+    if (strstr(name, ".PI1")) {
+        if (degas == false) fprintf(stderr, "error: %s: not taken for a Degas file\n", name);
+        return degas;
+    }
+    if (degas) {
+        fprintf(stderr, "error: %s: taken for a Degas file\n", name);
+        return false;
+    }
+    if (strstr(name, ".scr") && isZXSpectrumFormat(file->bytes, (long unsigned int)file->length) == false) {
+        fprintf(stderr, "error: %s: not taken for a ZX Spectrum screen\n", name);
+        return false;
+    }
+    return true;
+}
+
+static void addCorpus(CorpusFile *file, const char *name) {
+    RenderGeometry geometry;
+    long offset = 0;
+    
+    if (strstr(name, ".NEO")) {
+        geometry = makeGeometry(320, 200, 16, 4);
+        addRender(&geometry, file->bytes + 128, file->length - 128, name);
+    } else if (strstr(name, ".PI1")) {
+        geometry = makeGeometry(320, 200, 16, 4);
+        addRender(&geometry, file->bytes + 34, file->length - 34, name);
+    } else if (strstr(name, ".scr")) {
+        geometry = makeGeometry(256, 192, 1, 1);
+        addRender(&geometry, file->bytes, file->length, name);
+        
+        if (isZXSpectrumFormat(file->bytes, file->length)) {
+            geometry.layout = RenderLayoutZXScreen;
+            addRender(&geometry, file->bytes, file->length, name);
+        }
+    } else if (strstr(name, ".bmp")) {
+        if (bitmapGeometry(file, &geometry, &offset)) addRender(&geometry, file->bytes + offset, file->length - offset, name);
+    } else if (strstr(name, ".raw")) {
+        // The picture shown at launch, 32-bit pixels.
+        geometry = makeGeometry(256, 192, 32, 1);
+        addRender(&geometry, file->bytes, file->length, name);
+    }
+}
+
+static void addSynthetic(const uint8_t *bytes, DataSource *source) {
+    static const int packed[] = {1, 2, 4, 8, 16, 24, 32};
+    RenderGeometry geometry;
+    
+    for (int i = 0; i < (int)(sizeof(packed) / sizeof(packed[0])); i++) {
+        geometry = makeGeometry(SYNTHETIC_SIZE, SYNTHETIC_SIZE, packed[i], 1);
+        addRender(&geometry, bytes, SYNTHETIC_LENGTH, "synthetic");
+    }
+    
+    geometry = makeGeometry(SYNTHETIC_SIZE, SYNTHETIC_SIZE, 8, 4);
+    addRender(&geometry, bytes, SYNTHETIC_LENGTH, "synthetic");
+    geometry.alphaPlane = true;
+    addRender(&geometry, bytes, SYNTHETIC_LENGTH, "synthetic");
+    
+    geometry = makeGeometry(SYNTHETIC_SIZE, SYNTHETIC_SIZE, 16, 4);
+    addRender(&geometry, bytes, SYNTHETIC_LENGTH, "synthetic");
+    geometry.alphaPlane = true;
+    addRender(&geometry, bytes, SYNTHETIC_LENGTH, "synthetic");
+    geometry.alphaPlane = false;
+    geometry.maskPlane = true;
+    addRender(&geometry, bytes, SYNTHETIC_LENGTH, "synthetic");
+    
+    geometry = makeGeometry(SYNTHETIC_SIZE, SYNTHETIC_SIZE, 16, 8);
+    addRender(&geometry, bytes, SYNTHETIC_LENGTH, "synthetic");
+    
+    // As many stacked screens as there are pixels in the other synthetic images.
+    geometry = makeGeometry(ZX_SCREEN_WIDTH, SYNTHETIC_SIZE * SYNTHETIC_SIZE / ZX_SCREEN_WIDTH / ZX_SCREEN_HEIGHT * ZX_SCREEN_HEIGHT, 1, 1);
+    geometry.layout = RenderLayoutZXScreen;
+    addRender(&geometry, bytes, SYNTHETIC_LENGTH, "synthetic");
+    
+    geometry = makeGeometry(C64_BITMAP_WIDTH, SYNTHETIC_SIZE * SYNTHETIC_SIZE / C64_BITMAP_WIDTH / C64_BITMAP_HEIGHT * C64_BITMAP_HEIGHT, 1, 1);
+    geometry.layout = RenderLayoutC64Hires;
+    addRender(&geometry, bytes, SYNTHETIC_LENGTH, "synthetic");
+    
+    geometry = makeGeometry(C64_MULTICOLOR_WIDTH, SYNTHETIC_SIZE * SYNTHETIC_SIZE / C64_BITMAP_WIDTH / C64_BITMAP_HEIGHT * C64_BITMAP_HEIGHT, 1, 1);
+    geometry.layout = RenderLayoutC64Multicolor;
+    addRender(&geometry, bytes, SYNTHETIC_LENGTH, "synthetic");
+    
+    static const RenderLayout tileLayouts[] = {
+        RenderLayoutGameBoyTiles, RenderLayoutNESTiles, RenderLayoutSNES4BitTiles,
+        RenderLayoutSNES8BitTiles, RenderLayoutMasterSystemTiles
+    };
+    for (size_t i = 0; i < sizeof(tileLayouts) / sizeof(tileLayouts[0]); i++) {
+        geometry = makeGeometry(SYNTHETIC_SIZE, SYNTHETIC_SIZE, tileFormatBits(tileLayouts[i]), 1);
+        geometry.layout = tileLayouts[i];
+        addRender(&geometry, bytes, SYNTHETIC_LENGTH, "synthetic");
+    }
+    
+    Benchmark *benchmark = addBenchmark(BenchmarkPaletteScan, "palettescan", "synthetic");
+    benchmark->source = source;
+    benchmark->length = SYNTHETIC_LENGTH;
+}
+
+static void run(Benchmark *benchmark, uint32_t *pixel) {
+    switch (benchmark->kind) {
+        case BenchmarkRender:
+            renderToPixelData(&benchmark->geometry, &palette, &benchmark->lookup, benchmark->bytes, pixel, benchmark->geometry.width);
+            break;
+            
+        case BenchmarkPaletteScan:
+            closePaletteIndex(createPaletteIndex(benchmark->source, PaletteFormatAtariST | PaletteFormatAtariSTE | PaletteFormatNext));
+            break;
+    }
+}
+
+/*
+ Runs the benchmark as often as fits in each trial, once beforehand to warm the caches,
+ and keeps the time of a single run from the fastest trial.
+ */
+static void measure(Benchmark *benchmark, uint32_t *pixel) {
+    run(benchmark, pixel);
+    benchmark->seconds = 0;
+    
+    for (int trial = 0; trial < TRIALS; trial++) {
+        long runs = 0;
+        double start = now();
+        double elapsed;
+        
+        do {
+            run(benchmark, pixel);
+            runs++;
+            elapsed = now() - start;
+        } while (elapsed < options.minimum);
+        
+        if (benchmark->seconds == 0 || elapsed / runs < benchmark->seconds) benchmark->seconds = elapsed / runs;
+    }
+}
+
+static double megabytesPerSecond(const Benchmark *benchmark) {
+    return (double)benchmark->length / benchmark->seconds / 1e6;
+}
+
+static double nanosecondsPerPixel(const Benchmark *benchmark) {
+    return benchmark->seconds * 1e9 / (double)benchmark->pixels;
+}
+
+static bool writeJSON(FILE *fp) {
+    fprintf(fp, "{\n  \"threads\": %d,\n  \"benchmarks\": [\n", parallelThreadCount());
+    
+    for (int i = 0; i < suite.count; i++) {
+        const Benchmark *benchmark = &suite.benchmarks[i];
+        
+        fprintf(fp, "    {\"name\": \"%s\", \"bytes\": %ld, \"pixels\": %ld, \"seconds\": %.9f, \"MBps\": %.1f, ",
+                benchmark->name, benchmark->length, benchmark->pixels, benchmark->seconds, megabytesPerSecond(benchmark));
+        if (benchmark->pixels) {
+            fprintf(fp, "\"nsPerPixel\": %.3f}", nanosecondsPerPixel(benchmark));
+        } else {
+            fprintf(fp, "\"nsPerPixel\": null}");
+        }
+        fprintf(fp, "%s\n", i + 1 < suite.count ? "," : "");
+    }
+    
+    fprintf(fp, "  ]\n}\n");
+    return ferror(fp) == 0;
+}
+
+// MARK: - Main
+
+int main(int argc, char *argv[]) {
+    static const struct option longOptions[] = {
+        {"root",        required_argument,  NULL, 'r'},
+        {"output",      required_argument,  NULL, 'o'},
+        {"filter",      required_argument,  NULL, 'f'},
+        {"time",        required_argument,  NULL, 't'},
+        {"list",        no_argument,        NULL, 'l'},
+        {"help",        no_argument,        NULL, 'H'},
+        {NULL, 0, NULL, 0}
+    };
+    static const char *corpus[] = {
+        "Pictures/NEOchrome/BULL.NEO",
+        "Pictures/NEOchrome/MEDUSABL.NEO",
+        "Pictures/NEOchrome/NOFIRE.NEO",
+        "Pictures/NEOchrome/TSTART.NEO",
+        "Pictures/NEOchrome/TUTBW.NEO",
+        "Pictures/NEOchrome/WATRFALL.NEO",
+        "Pictures/Degas/OCEAN.PI1",
+        "Pictures/ZX Spectrum/Example.scr",
+        "Pictures/ZX Spectrum/Test.scr",
+        "Pictures/Bitmap/Load Runner.bmp",
+        "eXtractor/App Resources/eXtractor.raw"
+    };
+    const int corpusCount = (int)(sizeof(corpus) / sizeof(corpus[0]));
+    int unrecognised = 0;
+    CorpusFile files[sizeof(corpus) / sizeof(corpus[0])];
+    int opt;
+    
+    options.root = SOURCE_DIR;
+    options.minimum = 0.1;
+    
+    while ((opt = getopt_long(argc, argv, "r:o:f:t:l", longOptions, NULL)) != -1) {
+        switch (opt) {
+            case 'r':
+                options.root = optarg;
+                break;
+                
+            case 'o':
+                options.output = optarg;
+                break;
+                
+            case 'f':
+                options.filter = optarg;
+                break;
+                
+            case 't':
+                options.minimum = strtod(optarg, NULL);
+                break;
+                
+            case 'l':
+                options.list = true;
+                break;
+                
+            case 'H':
+                usage(argv[0]);
+                return EXIT_SUCCESS;
+                
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    
+    defaultPalette(&palette);
+    
+    // Random bytes, the same for every run so results stay comparable.
+    DataSource *source = createDataSource(SYNTHETIC_LENGTH);
+    uint8_t *synthetic = source ? beginDataSourceWrite(source, 0, SYNTHETIC_LENGTH) : NULL;
+    if (synthetic == NULL) {
+        fprintf(stderr, "error: out of memory\n");
+        return EXIT_FAILURE;
+    }
+    uint32_t seed = 1;
+    for (long i = 0; i < SYNTHETIC_LENGTH; i++) {
+        seed = seed * 1664525 + 1013904223;
+        synthetic[i] = seed >> 24;
+    }
+    endDataSourceWrite(source, 0, SYNTHETIC_LENGTH);
+    
+    uint8_t *bytes = malloc(SYNTHETIC_LENGTH);
+    if (bytes == NULL) return EXIT_FAILURE;
+    memcpy(bytes, dataSourceBytes(source, 0, SYNTHETIC_LENGTH), SYNTHETIC_LENGTH);
+    
+    for (int i = 0; i < corpusCount; i++) {
+        char path[PATH_MAX];
+        const char *name = strrchr(corpus[i], '/') + 1;
+        
+        snprintf(path, sizeof(path), "%s/%s", options.root, corpus[i]);
+        files[i].name = strdup(name);
+        files[i].bytes = NULL;
+        if (loadFile(path, &files[i]) == false) {
+            fprintf(stderr, "warning: %s: %s\n", path, strerror(errno));
+            continue;
+        }
+        if (isCorpusRecognised(&files[i], name) == false) unrecognised++;
+        addCorpus(&files[i], name);
+    }
+    addSynthetic(bytes, source);
+    
+    long largest = 0;
+    int kept = 0;
+    for (int i = 0; i < suite.count; i++) {
+        Benchmark *benchmark = &suite.benchmarks[i];
+        if (options.filter && strstr(benchmark->name, options.filter) == NULL) continue;
+        if (benchmark->pixels > largest) largest = benchmark->pixels;
+        suite.benchmarks[kept++] = *benchmark;
+    }
+    suite.count = kept;
+    
+    uint32_t *pixel = malloc((size_t)(largest ? largest : 1) * sizeof(uint32_t));
+    if (pixel == NULL) {
+        fprintf(stderr, "error: out of memory\n");
+        return EXIT_FAILURE;
+    }
+    
+    if (options.list == false) printf("%-40s %12s %12s\n", "benchmark", "MB/s", "ns/pixel");
+    for (int i = 0; i < suite.count; i++) {
+        Benchmark *benchmark = &suite.benchmarks[i];
+        
+        if (options.list) {
+            printf("%s\n", benchmark->name);
+            continue;
+        }
+        
+        measure(benchmark, pixel);
+        printf("%-40s %12.1f ", benchmark->name, megabytesPerSecond(benchmark));
+        if (benchmark->pixels) {
+            printf("%12.3f\n", nanosecondsPerPixel(benchmark));
+        } else {
+            printf("%12s\n", "-");
+        }
+        fflush(stdout);
+    }
+    
+    int status = unrecognised > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    if (options.output && options.list == false) {
+        FILE *fp = strcmp(options.output, "-") == 0 ? stdout : fopen(options.output, "w");
+        if (fp == NULL || writeJSON(fp) == false) {
+            fprintf(stderr, "error: %s: unable to write\n", options.output);
+            status = EXIT_FAILURE;
+        }
+        if (fp && fp != stdout) fclose(fp);
+    }
+    
+    for (int i = 0; i < corpusCount; i++) {
+        free(files[i].name);
+        free(files[i].bytes);
+    }
+    free(suite.benchmarks);
+    free(pixel);
+    free(bytes);
+    closeDataSource(source);
+    return status;
+}
@@ -0,0 +1,88 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "ACT.h"
+
+// ZX Spectrum NEXT :- R2 R1 R0 G2 G1 G0 B2 B1  xx xx xx xx xx xx xx B0 (le)
+static uint32_t colorFrom9BitNextRgb(const uint8_t *rgb) {
+    /*
+     3 bits in red green and blue channels give us 8 values.
+     When scaled to the 0–255 range we get:
+     */
+    static const uint32_t tbl[] = {0, 36, 72, 109, 145, 182, 218, 255};
+    
+    uint32_t r = (rgb[0] & 0b11100000) >> 5;
+    uint32_t g = (rgb[0] & 0b00011100) >> 2;
+    uint32_t b = ((rgb[0] & 0b00000011) << 1) | (rgb[1] & 1);
+    
+    return tbl[r] | tbl[g] << 8 | tbl[b] << 16 | 0xFF000000;
+}
+
+bool loadPaletteWithContentsOfFile(const char *path, RenderPalette *palette) {
+    uint8_t data[1024];
+    size_t length;
+    
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) return false;
+    length = fread(data, 1, sizeof(data), fp);
+    fclose(fp);
+    
+    if (length >= 768) { // ACT
+        const uint8_t *byte = data;
+        
+        if (length == 772) {
+            palette->colorCount = (int)data[768] << 8 | data[769];
+            palette->transparentIndex = (int)data[770] << 8 | data[771];
+            if (palette->colorCount < 1 || palette->colorCount > 256) palette->colorCount = 256;
+        } else {
+            palette->colorCount = 256;
+            palette->transparentIndex = 0xFFFF;
+        }
+        
+        for (int c = 0; c < palette->colorCount; c++) {
+            palette->rgb[c] = (uint32_t)byte[2] << 16 | (uint32_t)byte[1] << 8 | (uint32_t)byte[0] | 0xFF000000;
+            byte += 3;
+        }
+        return true;
+    }
+    
+    if (length >= 2 && length <= 512) { // NPL
+        const uint8_t *byte = data;
+        
+        palette->colorCount = (int)length / 2;
+        palette->transparentIndex = 227; // Default
+        
+        for (int c = 0; c < palette->colorCount; c++) {
+            uint32_t color = colorFrom9BitNextRgb(byte);
+            
+            palette->rgb[c] = color;
+            if (color == 0xFFFF00FF) {
+                palette->transparentIndex = c;
+            }
+            
+            byte += 2;
+        }
+        return true;
+    }
+    
+    return false;
+}
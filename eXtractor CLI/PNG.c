@@ -0,0 +1,263 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "PNG.h"
+
+#include <zlib.h>
+
+static void putUInt32(uint8_t *bytes, uint32_t value) {
+    bytes[0] = value >> 24;
+    bytes[1] = value >> 16;
+    bytes[2] = value >> 8;
+    bytes[3] = value;
+}
+
+static bool writeChunk(FILE *fp, const char *type, const uint8_t *data, uint32_t length) {
+    uint8_t header[8];
+    uint8_t footer[4];
+    
+    putUInt32(header, length);
+    memcpy(header + 4, type, 4);
+    
+    uLong crc = crc32(0, header + 4, 4);
+    if (length) crc = crc32(crc, data, length);
+    putUInt32(footer, (uint32_t)crc);
+    
+    if (fwrite(header, 1, 8, fp) != 8) return false;
+    if (length && fwrite(data, 1, length, fp) != length) return false;
+    return fwrite(footer, 1, 4, fp) == 4;
+}
+
+typedef struct {
+    uint32_t color[512];
+    int16_t index[512];         // -1 for an empty slot
+    uint32_t palette[256];
+    int count;
+} ColorTable;
+
+// Index of the color, added when new, -1 once the table holds 256 other colors.
+static int colorIndex(ColorTable *table, uint32_t color) {
+    uint32_t slot = (color * 0x9E3779B1u) >> 23;
+    
+    while (table->index[slot] >= 0) {
+        if (table->color[slot] == color) return table->index[slot];
+        slot = (slot + 1) & 511;
+    }
+    if (table->count == 256) return -1;
+    
+    table->color[slot] = color;
+    table->index[slot] = (int16_t)table->count;
+    table->palette[table->count] = color;
+    return table->count++;
+}
+
+// Returns false when the image has more than 256 colors.
+static bool buildColorTable(ColorTable *table, const uint32_t *pixel, int width, int height, long stride) {
+    memset(table->index, 0xFF, sizeof(table->index));
+    table->count = 0;
+    
+    for (int r = 0; r < height; r++) {
+        const uint32_t *src = pixel + r * stride;
+        uint32_t last = ~src[0];
+        
+        for (int c = 0; c < width; c++) {
+            if (src[c] == last) continue;
+            last = src[c];
+            if (colorIndex(table, last) < 0) return false;
+        }
+    }
+    return true;
+}
+
+static bool writePaletteChunks(FILE *fp, const ColorTable *table) {
+    uint8_t plte[256 * 3];
+    uint8_t trns[256];
+    int opaque = 0;     // Entries up to the last translucent one need an alpha value
+    
+    for (int i = 0; i < table->count; i++) {
+        uint32_t rgba = table->palette[i];
+        plte[i * 3] = rgba;
+        plte[i * 3 + 1] = rgba >> 8;
+        plte[i * 3 + 2] = rgba >> 16;
+        trns[i] = rgba >> 24;
+        if (trns[i] != 0xFF) opaque = i + 1;
+    }
+    
+    if (writeChunk(fp, "PLTE", plte, (uint32_t)table->count * 3) == false) return false;
+    return opaque == 0 || writeChunk(fp, "tRNS", trns, (uint32_t)opaque);
+}
+
+static int paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+/*
+ Filters the row with every filter type, each candidate starting with its type byte, and
+ returns the type whose bytes, taken as signed, sum to the least, the heuristic libpng uses.
+ */
+static int filterRow(const uint8_t *row, const uint8_t *above, size_t length, uint8_t *candidate[5]) {
+    unsigned long sum[5] = {0, 0, 0, 0, 0};
+    
+    for (size_t i = 0; i < length; i++) {
+        int x = row[i];
+        int a = i >= 4 ? row[i - 4] : 0;
+        int b = above[i];
+        int c = i >= 4 ? above[i - 4] : 0;
+        uint8_t filtered[5] = {
+            (uint8_t)x,
+            (uint8_t)(x - a),
+            (uint8_t)(x - b),
+            (uint8_t)(x - ((a + b) >> 1)),
+            (uint8_t)(x - paeth(a, b, c))
+        };
+        
+        for (int type = 0; type < 5; type++) {
+            candidate[type][i + 1] = filtered[type];
+            sum[type] += (unsigned long)abs((int8_t)filtered[type]);
+        }
+    }
+    
+    int best = 0;
+    for (int type = 0; type < 5; type++) {
+        candidate[type][0] = type;
+        if (sum[type] < sum[best]) best = type;
+    }
+    return best;
+}
+
+// Compresses the input and writes every full output buffer as an IDAT chunk.
+static bool deflateToChunks(FILE *fp, z_stream *stream, uint8_t *buffer, uInt bufferLength, int flush) {
+    do {
+        int status = deflate(stream, flush);
+        if (status == Z_STREAM_ERROR) return false;
+        
+        if (stream->avail_out == 0 || (flush == Z_FINISH && stream->avail_out < bufferLength)) {
+            if (writeChunk(fp, "IDAT", buffer, bufferLength - stream->avail_out) == false) return false;
+            stream->next_out = buffer;
+            stream->avail_out = bufferLength;
+        }
+        if (flush == Z_FINISH && status == Z_STREAM_END) return true;
+    } while (stream->avail_in > 0 || flush == Z_FINISH);
+    
+    return true;
+}
+
+bool writePNG(const char *path, const uint32_t *pixel, int width, int height, long stride, int level) {
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    const uInt bufferLength = 1 << 16;
+    
+    ColorTable *table = malloc(sizeof(ColorTable));
+    uint8_t *rows = calloc(2, (size_t)width * 4);
+    uint8_t *filtered = malloc(((size_t)width * 4 + 1) * 5);
+    uint8_t *buffer = malloc(bufferLength);
+    z_stream stream = {0};
+    FILE *fp = NULL;
+    bool success = false;
+    
+    if (table == NULL || rows == NULL || filtered == NULL || buffer == NULL) goto cleanup;
+    
+    /*
+     Images of up to 256 colors are written as palette indices, which leaves a quarter of
+     the bytes to compress, and are better left unfiltered. Others are 8-bit RGBA with the
+     filter of each row picked by its smallest sum of differences.
+     */
+    bool indexed = buildColorTable(table, pixel, width, height, stride);
+    size_t rowLength = indexed ? (size_t)width : (size_t)width * 4;
+    
+    if (deflateInit2(&stream, level, Z_DEFLATED, 15, 8, indexed ? Z_DEFAULT_STRATEGY : Z_FILTERED) != Z_OK) goto cleanup;
+    stream.next_out = buffer;
+    stream.avail_out = bufferLength;
+    
+    fp = fopen(path, "wb");
+    if (fp == NULL) goto finish;
+    
+    uint8_t ihdr[13];
+    putUInt32(ihdr, width);
+    putUInt32(ihdr + 4, height);
+    ihdr[8] = 8;                    // Bit depth
+    ihdr[9] = indexed ? 3 : 6;      // Color type indexed or RGBA
+    ihdr[10] = 0;                   // Compression method
+    ihdr[11] = 0;                   // Filter method
+    ihdr[12] = 0;                   // Interlace method
+    
+    if (fwrite(signature, 1, 8, fp) != 8 || writeChunk(fp, "IHDR", ihdr, sizeof(ihdr)) == false) goto finish;
+    if (indexed && writePaletteChunks(fp, table) == false) goto finish;
+    
+    uint8_t *candidate[5];
+    for (int type = 0; type < 5; type++) {
+        candidate[type] = filtered + type * (rowLength + 1);
+    }
+    
+    // Rows are filtered and compressed one at a time, the IDAT chunks written as the output fills.
+    for (int r = 0; r < height; r++) {
+        uint8_t *row = rows + (r & 1) * rowLength;
+        const uint8_t *above = rows + ((r & 1) ^ 1) * rowLength;
+        const uint32_t *src = pixel + r * stride;
+        int type = 0;
+        
+        if (indexed) {
+            candidate[0][0] = 0;
+            for (int c = 0; c < width; c++) {
+                candidate[0][c + 1] = (uint8_t)colorIndex(table, src[c]);
+            }
+        } else {
+            for (int c = 0; c < width; c++) {
+                uint32_t rgba = src[c];
+                row[c * 4] = rgba;
+                row[c * 4 + 1] = rgba >> 8;
+                row[c * 4 + 2] = rgba >> 16;
+                row[c * 4 + 3] = rgba >> 24;
+            }
+            
+            // Filtering gains nothing when the rows are stored uncompressed.
+            if (level == 0) {
+                candidate[0][0] = 0;
+                memcpy(candidate[0] + 1, row, rowLength);
+            } else {
+                type = filterRow(row, above, rowLength, candidate);
+            }
+        }
+        
+        stream.next_in = candidate[type];
+        stream.avail_in = (uInt)rowLength + 1;
+        if (deflateToChunks(fp, &stream, buffer, bufferLength, Z_NO_FLUSH) == false) goto finish;
+    }
+    
+    success = deflateToChunks(fp, &stream, buffer, bufferLength, Z_FINISH)
+        && writeChunk(fp, "IEND", NULL, 0);
+    
+finish:
+    deflateEnd(&stream);
+    if (fp && fclose(fp) != 0) success = false;
+    
+cleanup:
+    free(table);
+    free(rows);
+    free(filtered);
+    free(buffer);
+    return success;
+}
@@ -0,0 +1,57 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef PNG_h
+#define PNG_h
+
+#include "common.h"
+
+/* Set up for C function definitions, even when using C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /*
+     Writes 32-bit [A7...0 B7...0 G7...0 R7...0] pixels as a PNG file, of 8-bit palette
+     indices when there are no more than 256 colors, else of 8-bit RGBA.
+     
+     Rows are filtered and compressed one at a time, RGBA rows using the filter type that
+     leaves the smallest differences, so only a few rows are held in memory whatever the
+     image size.
+     
+     Parameters
+     stride
+     Distance in pixels between two source rows.
+     level
+     zlib compression level, 0 to 9, or Z_DEFAULT_COMPRESSION.
+     
+     Return Value
+     true if the file was written.
+     */
+    bool writePNG(const char *path, const uint32_t *pixel, int width, int height, long stride, int level);
+
+/* Ends C function definitions when using C++ */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PNG_h */
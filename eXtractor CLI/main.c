@@ -0,0 +1,960 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <errno.h>
+#include <limits.h>
+#include <strings.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "render.h"
+#include "detect.h"
+#include "datasource.h"
+#include "trace.h"
+#include "tilemap.h"
+#include "tileformat.h"
+#include "ACT.h"
+#include "PNG.h"
+
+typedef enum {
+    ManifestNone,
+    ManifestJSON,
+    ManifestCSV
+} Manifest;
+
+typedef struct {
+    char *path;             // Source file
+    char *name;             // Output name, relative to the output directory, without extension
+    long frames;            // Images found in the file
+    long images;            // Frames, or tiles of every frame when splitting, to write
+    uint32_t *atlas;        // Every image packed into one sheet, only when writing an atlas
+    atomic_long pending;    // Tasks of the file still running
+    atomic_bool failed;
+} Job;
+
+typedef struct {
+    size_t job;
+    long first;             // First image of the job
+    long count;
+} Task;
+
+typedef struct {
+    Job *jobs;
+    size_t count;
+    size_t capacity;
+    Task *tasks;
+    size_t taskCount;
+    size_t taskCapacity;
+    atomic_size_t next;
+    atomic_size_t written;
+    atomic_size_t failed;
+} Queue;
+
+typedef struct {
+    RenderGeometry geometry;
+    RenderPalette palette;
+    RenderLookup lookup;    // Shared by every worker, built once the palette and geometry are known
+    long offset;
+    bool tilemap;           // Images are levels, maps of the tiles at the offset
+    RenderTilemap map;      // Entries of each level, sized by the geometry in whole tiles
+    long mapOffset;         // Offset of the first map in each file
+    long frames;            // Number of consecutive images to extract, 0 for as many as fit
+    bool split;             // Write every tile of each image on its own
+    bool atlas;             // Pack the images of each file into one sheet
+    long columns;           // Cells per row of the atlas, 0 for a square sheet
+    Manifest manifest;
+    int level;              // zlib compression level
+    const char *output;
+    const char *trace;      // Chrome trace of the run, when set
+    const char *extension;
+    bool verbose;
+    bool detect;            // List the likely layouts of each file instead of extracting
+} Options;
+
+static Options options;
+static Queue queue;
+
+// MARK: - Private Functions
+
+static void usage(const char *command) {
+    printf("Usage: %s [options] <file or directory>...\n\n", command);
+    printf("Options:\n");
+    printf("  -o, --output <dir>        Output directory, default is the current directory.\n");
+    printf("  -O, --offset <bytes>      Offset of the first image in each file.\n");
+    printf("  -w, --width <pixels>      Image width.\n");
+    printf("  -h, --height <pixels>     Image height.\n");
+    printf("  -p, --planes <count>      1 for packed pixels, 2 to 8 for planar.\n");
+    printf("  -b, --bits <bits>         Bits per pixel, or bits per plane (8/16) when planar.\n");
+    printf("  -e, --endian <big|little> Byte order of 16-bit planes and pixels, default is big.\n");
+    printf("  -P, --palette <file>      Photoshop ACT or ZX Spectrum NEXT NPL palette.\n");
+    printf("  -f, --format <format>     16-bit pixel format: rgb555, rgb565, rgba555, argb555,\n");
+    printf("                            bgr555, bgr565, rgb444 or argb4444.\n");
+    printf("  -t, --tile <w>x<h>        Tile size.\n");
+    printf("  -g, --padding <bytes>     Bytes skipped after each tile, or pixel group when not tiled.\n");
+    printf("  -a, --alpha               Alpha plane, or alpha channel for packed pixels.\n");
+    printf("  -m, --mask                Mask plane.\n");
+    printf("  -S, --zx-screen           ZX Spectrum screens of 6912 bytes, 256 pixels wide and\n");
+    printf("                            192 high, or several stacked when --height allows.\n");
+    printf("  -C, --c64 <hires|multicolor>\n");
+    printf("                            Commodore 64 bitmaps followed by screen RAM, 320 pixels\n");
+    printf("                            wide, or by screen RAM, color RAM and background as in\n");
+    printf("                            Koala files, 160 wide, stacked like --zx-screen.\n");
+    printf("  -K, --console <gameboy|nes|snes4|snes8|sms>\n");
+    printf("                            8 by 8 console tiles of Game Boy, NES, SNES 4 or 8 bits\n");
+    printf("                            per pixel, or Master System bitplanes, a row of tiles\n");
+    printf("                            for every 8 lines. Mega Drive tiles are --bits 4 --tile 8x8.\n");
+    printf("  -L, --tilemap <format>:<offset>\n");
+    printf("                            Draw the maps of tile indices at offset against the tiles\n");
+    printf("                            at --offset, laid out as the other options describe. The\n");
+    printf("                            format is 8bit, 16bit, snes, megadrive, x16 or next, the\n");
+    printf("                            width and height of each map are those of the image.\n");
+    printf("  -n, --frames <count>      Consecutive images to extract from each file, 0 for all.\n");
+    printf("  -s, --split               Write every tile of each image on its own, needs --tile.\n");
+    printf("  -A, --atlas <columns>     Pack the images, or tiles, of each file into one sheet of\n");
+    printf("                            the given number of columns, 0 for a square sheet.\n");
+    printf("  -M, --manifest <json|csv> List the place, size and source offset of every image,\n");
+    printf("                            written next to the images, default is json with --atlas.\n");
+    printf("  -z, --level <0-9>         PNG compression level, default is 6.\n");
+    printf("  -x, --extension <ext>     Only extract files with the given extension.\n");
+    printf("  -j, --jobs <count>        Number of worker threads, default is one per core.\n");
+    printf("  -d, --detect              List the most likely layouts of each file, from the offset,\n");
+    printf("                            instead of extracting.\n");
+    printf("  -T, --trace <file>        Write the time spent decoding and encoding as a Chrome trace.\n");
+    printf("  -v, --verbose             List every file written.\n");
+    printf("      --help                Display this help.\n");
+}
+
+static bool hasExtension(const char *path, const char *extension) {
+    const char *dot = strrchr(path, '.');
+    if (extension == NULL) return true;
+    if (*extension == '.') extension++;
+    return dot != NULL && strcasecmp(dot + 1, extension) == 0;
+}
+
+static void addJob(const char *path, const char *name) {
+    if (queue.count == queue.capacity) {
+        queue.capacity = queue.capacity ? queue.capacity * 2 : 256;
+        queue.jobs = realloc(queue.jobs, queue.capacity * sizeof(Job));
+        if (queue.jobs == NULL) {
+            fprintf(stderr, "error: out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    memset(&queue.jobs[queue.count], 0, sizeof(Job));
+    queue.jobs[queue.count].path = strdup(path);
+    queue.jobs[queue.count].name = strdup(name);
+    queue.count++;
+}
+
+static void addTask(size_t job, long first, long count) {
+    if (queue.taskCount == queue.taskCapacity) {
+        queue.taskCapacity = queue.taskCapacity ? queue.taskCapacity * 2 : 256;
+        queue.tasks = realloc(queue.tasks, queue.taskCapacity * sizeof(Task));
+        if (queue.tasks == NULL) {
+            fprintf(stderr, "error: out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    queue.tasks[queue.taskCount++] = (Task){.job = job, .first = first, .count = count};
+}
+
+static void addPath(const char *path, const char *name) {
+    struct stat st;
+    
+    if (stat(path, &st) != 0) {
+        fprintf(stderr, "warning: %s: %s\n", path, strerror(errno));
+        return;
+    }
+    
+    if (S_ISREG(st.st_mode)) {
+        if (hasExtension(path, options.extension)) addJob(path, name);
+        return;
+    }
+    
+    if (!S_ISDIR(st.st_mode)) return;
+    
+    DIR *dir = opendir(path);
+    if (dir == NULL) {
+        fprintf(stderr, "warning: %s: %s\n", path, strerror(errno));
+        return;
+    }
+    
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        
+        char childPath[PATH_MAX];
+        char childName[PATH_MAX];
+        snprintf(childPath, sizeof(childPath), "%s/%s", path, entry->d_name);
+        if (*name) {
+            snprintf(childName, sizeof(childName), "%s/%s", name, entry->d_name);
+        } else {
+            snprintf(childName, sizeof(childName), "%s", entry->d_name);
+        }
+        addPath(childPath, childName);
+    }
+    closedir(dir);
+}
+
+static bool makeDirectories(char *path) {
+    for (char *p = path + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+            *p = '/';
+            return false;
+        }
+        *p = '/';
+    }
+    return true;
+}
+
+// Images written for every frame, each of its tiles when splitting.
+static long imagesPerFrame(void) {
+    const RenderGeometry *geometry = &options.geometry;
+    if (options.split == false) return 1;
+    return (long)(geometry->width / geometry->tileWidth) * (geometry->height / geometry->tileHeight);
+}
+
+static int imageWidth(void) {
+    return options.split ? options.geometry.tileWidth : options.geometry.width;
+}
+
+static int imageHeight(void) {
+    return options.split ? options.geometry.tileHeight : options.geometry.height;
+}
+
+static long atlasColumns(const Job *job) {
+    long columns = 1;
+    
+    if (options.columns > 0) return options.columns < job->images ? options.columns : job->images;
+    while (columns * columns < job->images) columns++;
+    return columns;
+}
+
+// Source bytes of each frame, the entries of a map when drawing tilemaps.
+static long frameBytes(void) {
+    return options.tilemap ? bytesPerTilemap(&options.map) : bytesPerImage(&options.geometry);
+}
+
+static long frameOffset(void) {
+    return options.tilemap ? options.mapOffset : options.offset;
+}
+
+// Offset in the file of the first byte of the image, tiles being stored one after the other, or of its map entry.
+static long imageOffset(long index) {
+    const RenderGeometry *geometry = &options.geometry;
+    long perFrame = imagesPerFrame();
+    long offset = frameOffset() + index / perFrame * frameBytes();
+    
+    if (options.split && options.tilemap) {
+        offset += index % perFrame * options.map.bytesPerEntry;
+    } else if (options.split) {
+        RenderGeometry tile = *geometry;
+        tile.width = geometry->tileWidth;
+        tile.height = geometry->tileHeight;
+        offset += index % perFrame * bytesPerImage(&tile);
+    }
+    return offset;
+}
+
+// PNG file of the image, numbered by frame, and by tile within the frame when splitting.
+static void imageName(const char *prefix, const Job *job, long index, char *name, size_t length) {
+    long perFrame = imagesPerFrame();
+    
+    if (job->images == 1) {
+        snprintf(name, length, "%s.png", prefix);
+    } else if (options.split && job->frames > 1) {
+        snprintf(name, length, "%s-%04ld-%04ld.png", prefix, index / perFrame, index % perFrame);
+    } else {
+        snprintf(name, length, "%s-%04ld.png", prefix, index);
+    }
+}
+
+static void putJSONString(FILE *fp, const char *string) {
+    fputc('"', fp);
+    for (; *string; string++) {
+        if (*string == '"' || *string == '\\') fputc('\\', fp);
+        fputc(*string, fp);
+    }
+    fputc('"', fp);
+}
+
+static void putCSVString(FILE *fp, const char *string) {
+    fputc('"', fp);
+    for (; *string; string++) {
+        if (*string == '"') fputc('"', fp);
+        fputc(*string, fp);
+    }
+    fputc('"', fp);
+}
+
+/*
+ Lists every image of the file, the PNG holding it, its place within that PNG and the
+ offset of its bytes in the source, as name.json or name.csv in the output directory.
+ */
+static bool writeManifest(const Job *job) {
+    char path[PATH_MAX];
+    char name[PATH_MAX];
+    const char *prefix = strrchr(job->name, '/') ? strrchr(job->name, '/') + 1 : job->name;
+    int width = imageWidth();
+    int height = imageHeight();
+    long columns = options.atlas ? atlasColumns(job) : 1;
+    bool json = options.manifest == ManifestJSON;
+    
+    snprintf(path, sizeof(path), "%s/%s.%s", options.output, job->name, json ? "json" : "csv");
+    if (makeDirectories(path) == false) return false;
+    
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL) return false;
+    
+    if (json) {
+        fprintf(fp, "{\n  \"source\": ");
+        putJSONString(fp, job->path);
+        fprintf(fp, ",\n  \"images\": [\n");
+    } else {
+        fprintf(fp, "file,x,y,width,height,offset\n");
+    }
+    
+    for (long i = 0; i < job->images; i++) {
+        long x = options.atlas ? i % columns * width : 0;
+        long y = options.atlas ? i / columns * height : 0;
+        
+        if (options.atlas) {
+            snprintf(name, sizeof(name), "%s.png", prefix);
+        } else {
+            imageName(prefix, job, i, name, sizeof(name));
+        }
+        
+        if (json) {
+            fprintf(fp, "    {\"file\": ");
+            putJSONString(fp, name);
+            fprintf(fp, ", \"x\": %ld, \"y\": %ld, \"width\": %d, \"height\": %d, \"offset\": %ld}%s\n", x, y, width, height, imageOffset(i), i + 1 < job->images ? "," : "");
+        } else {
+            putCSVString(fp, name);
+            fprintf(fp, ",%ld,%ld,%d,%d,%ld\n", x, y, width, height, imageOffset(i));
+        }
+    }
+    
+    if (json) fprintf(fp, "  ]\n}\n");
+    
+    bool success = ferror(fp) == 0;
+    if (fclose(fp) != 0) success = false;
+    return success;
+}
+
+/*
+ Works out how many images the file holds and splits them into tasks, small enough for
+ every thread to share the images of a single large file.
+ */
+static void planJob(size_t index, long jobs) {
+    const RenderGeometry *geometry = &options.geometry;
+    Job *job = &queue.jobs[index];
+    long size = frameBytes();
+    long offset = frameOffset();
+    struct stat st;
+    
+    if (stat(job->path, &st) != 0) {
+        fprintf(stderr, "warning: %s: %s\n", job->path, strerror(errno));
+        atomic_fetch_add(&queue.failed, 1);
+        return;
+    }
+    
+    long length = (long)st.st_size;
+    if (offset + size > length) {
+        fprintf(stderr, "warning: %s: %ld bytes needed at offset %ld, file is only %ld bytes\n", job->path, size, offset, length);
+        atomic_fetch_add(&queue.failed, 1);
+        return;
+    }
+    if (options.tilemap && options.offset + bytesPerTile(geometry) > length) {
+        fprintf(stderr, "warning: %s: no tiles at offset %ld, file is only %ld bytes\n", job->path, options.offset, length);
+        atomic_fetch_add(&queue.failed, 1);
+        return;
+    }
+    
+    long frames = (length - offset) / size;
+    if (options.frames > 0 && options.frames < frames) frames = options.frames;
+    job->frames = frames;
+    job->images = frames * imagesPerFrame();
+    if (job->images < 1) return;
+    
+    if (options.atlas) {
+        long columns = atlasColumns(job);
+        long rows = (job->images + columns - 1) / columns;
+        job->atlas = calloc((size_t)(columns * imageWidth()) * (size_t)(rows * imageHeight()), sizeof(uint32_t));
+        if (job->atlas == NULL) {
+            fprintf(stderr, "warning: %s: atlas of %ld images is too large\n", job->path, job->images);
+            atomic_fetch_add(&queue.failed, 1);
+            return;
+        }
+    }
+    
+    long chunk = job->images / (jobs * 4);
+    if (chunk < 1) chunk = 1;
+    if (chunk > 256) chunk = 256;
+    
+    long tasks = 0;
+    for (long first = 0; first < job->images; first += chunk, tasks++) {
+        addTask(index, first, first + chunk < job->images ? chunk : job->images - first);
+    }
+    atomic_init(&job->pending, tasks);
+    atomic_init(&job->failed, false);
+}
+
+// Run by the thread finishing the last task of the file.
+static void finishJob(Job *job) {
+    int width = imageWidth();
+    int height = imageHeight();
+    
+    if (job->atlas) {
+        char path[PATH_MAX];
+        long columns = atlasColumns(job);
+        long rows = (job->images + columns - 1) / columns;
+        
+        snprintf(path, sizeof(path), "%s/%s.png", options.output, job->name);
+        uint64_t start = traceBegin();
+        if (atomic_load(&job->failed)) {
+            fprintf(stderr, "warning: %s: incomplete, atlas not written\n", path);
+        } else if (makeDirectories(path) == false || writePNG(path, job->atlas, (int)(columns * width), (int)(rows * height), columns * width, options.level) == false) {
+            fprintf(stderr, "warning: %s: unable to write\n", path);
+            atomic_fetch_add(&queue.failed, 1);
+        } else {
+            atomic_fetch_add(&queue.written, job->images);
+            traceAdd(TraceCounterPixelsWritten, columns * width * rows * height);
+            if (options.verbose) printf("%s\n", path);
+        }
+        traceEnd("write atlas", start);
+        
+        free(job->atlas);
+        job->atlas = NULL;
+    }
+    
+    if (options.manifest != ManifestNone && writeManifest(job) == false) {
+        fprintf(stderr, "warning: %s/%s: unable to write manifest\n", options.output, job->name);
+        atomic_fetch_add(&queue.failed, 1);
+    }
+}
+
+static void runTask(const Task *task, uint32_t *pixel) {
+    const RenderGeometry *geometry = &options.geometry;
+    Job *job = &queue.jobs[task->job];
+    DataSource *source = openDataSource(job->path);
+    RenderTileset *tileset = NULL;
+    long size = frameBytes();
+    long offset = frameOffset();
+    long perFrame = imagesPerFrame();
+    long across = geometry->width / imageWidth();
+    int width = imageWidth();
+    int height = imageHeight();
+    long columns = job->atlas ? atlasColumns(job) : 0;
+    long frame = -1;
+    char prefix[PATH_MAX];
+    
+    snprintf(prefix, sizeof(prefix), "%s/%s", options.output, job->name);
+    
+    if (source == NULL) {
+        fprintf(stderr, "warning: %s: %s\n", job->path, strerror(errno));
+        atomic_fetch_add(&queue.failed, task->count);
+        atomic_store(&job->failed, true);
+    } else {
+        long first = offset + task->first / perFrame * size;
+        long last = offset + ((task->first + task->count - 1) / perFrame + 1) * size;
+        adviseDataSource(source, DataSourceAccessSequential, first, last - first);
+    }
+    
+    if (source && options.tilemap) {
+        // Every tile the maps are able to index, decoded once for all the maps of the task.
+        long tileBytes = bytesPerTile(geometry);
+        long count = (dataSourceLength(source) - options.offset) / tileBytes;
+        if (count > (long)options.map.indexMask + 1) count = (long)options.map.indexMask + 1;
+        
+        const uint8_t *bytes = dataSourceBytes(source, options.offset, count * tileBytes);
+        tileset = bytes ? createTileset(geometry, &options.palette, bytes, count) : NULL;
+        if (tileset == NULL) {
+            fprintf(stderr, "warning: %s: unable to decode the tiles at offset %ld\n", job->path, options.offset);
+            atomic_fetch_add(&queue.failed, task->count);
+            atomic_store(&job->failed, true);
+            closeDataSource(source);
+            source = NULL;
+        }
+    }
+    
+    for (long i = task->first; source && i < task->first + task->count; i++) {
+        if (i / perFrame != frame) {
+            frame = i / perFrame;
+            const uint8_t *bytes = dataSourceBytes(source, offset + frame * size, size);
+            if (bytes == NULL) {
+                fprintf(stderr, "warning: %s: file is shorter than expected\n", job->path);
+                atomic_fetch_add(&queue.failed, task->first + task->count - i);
+                atomic_store(&job->failed, true);
+                break;
+            }
+            uint64_t start = traceBegin();
+            if (tileset) {
+                renderTilemapRegion(tileset, &options.map, &options.palette, bytes, 0, 0, geometry->width, geometry->height, pixel, geometry->width);
+            } else {
+                memset(pixel, 0, (size_t)geometry->width * geometry->height * sizeof(uint32_t));
+                renderToPixelData(geometry, &options.palette, &options.lookup, bytes, pixel, geometry->width);
+                traceAdd(TraceCounterBytesDecoded, size);
+            }
+            traceEnd("decode", start);
+        }
+        
+        long tile = i % perFrame;
+        const uint32_t *image = pixel + tile / across * height * geometry->width + tile % across * width;
+        
+        if (job->atlas) {
+            uint32_t *cell = job->atlas + i / columns * height * columns * width + i % columns * width;
+            for (int r = 0; r < height; r++) {
+                memcpy(cell + r * columns * width, image + r * geometry->width, (size_t)width * sizeof(uint32_t));
+            }
+            continue;
+        }
+        
+        char path[PATH_MAX];
+        imageName(prefix, job, i, path, sizeof(path));
+        
+        uint64_t start = traceBegin();
+        bool success = makeDirectories(path) && writePNG(path, image, width, height, geometry->width, options.level);
+        traceEnd("write png", start);
+        traceAdd(TraceCounterPixelsWritten, (long)width * height);
+        
+        if (success == false) {
+            fprintf(stderr, "warning: %s: unable to write\n", path);
+            atomic_fetch_add(&queue.failed, 1);
+            atomic_store(&job->failed, true);
+            continue;
+        }
+        
+        atomic_fetch_add(&queue.written, 1);
+        if (options.verbose) printf("%s\n", path);
+    }
+    
+    closeTileset(tileset);
+    closeDataSource(source);
+    traceCounters();
+    if (atomic_fetch_sub(&job->pending, 1) == 1) finishJob(job);
+}
+
+static bool detect(const Job *job) {
+    DataSource *source = openDataSource(job->path);
+    RenderHypothesis hypotheses[8];
+    
+    if (source == NULL) {
+        fprintf(stderr, "warning: %s: %s\n", job->path, strerror(errno));
+        return false;
+    }
+    
+    // Only a sample from the start and one from the middle are read.
+    int count = detectGeometry(source, options.offset, hypotheses, 8);
+    
+    printf("%s:\n", job->path);
+    if (count == 0) printf("  no row structure found\n");
+    for (int i = 0; i < count; i++) {
+        const RenderGeometry *geometry = &hypotheses[i].geometry;
+        printf("  --width %d --height %d --planes %d --bits %d", geometry->width, geometry->height, geometry->planeCount, geometry->bitsPerPixel);
+        if (geometry->padding) printf(" --padding %d", geometry->padding);
+        printf("  (%.3f)\n", hypotheses[i].score);
+    }
+    
+    closeDataSource(source);
+    return true;
+}
+
+static void *worker(void *arg) {
+    uint32_t *pixel = malloc((size_t)options.geometry.width * options.geometry.height * sizeof(uint32_t));
+    if (pixel == NULL) return NULL;
+    
+    for (;;) {
+        size_t index = atomic_fetch_add(&queue.next, 1);
+        if (index >= queue.taskCount) break;
+        runTask(&queue.tasks[index], pixel);
+    }
+    
+    free(pixel);
+    return NULL;
+}
+
+static bool parseTileSize(const char *arg, int *width, int *height) {
+    return sscanf(arg, "%dx%d", width, height) == 2 && *width > 0 && *height > 0;
+}
+
+static bool parseTilemap(const char *arg, RenderTilemap *map, long *offset) {
+    static const struct {
+        const char *name;
+        RenderTilemapFormat format;
+    } formats[] = {
+        {"8bit", RenderTilemap8Bit},
+        {"16bit", RenderTilemap16Bit},
+        {"snes", RenderTilemapSNES},
+        {"megadrive", RenderTilemapMegaDrive},
+        {"x16", RenderTilemapCommanderX16},
+        {"next", RenderTilemapSpectrumNext}
+    };
+    const char *colon = strchr(arg, ':');
+    
+    if (colon == NULL || colon[1] == '\0') return false;
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        if (strncasecmp(arg, formats[i].name, (size_t)(colon - arg)) == 0 && formats[i].name[colon - arg] == '\0') {
+            setTilemapFormat(map, formats[i].format);
+            *offset = strtol(colon + 1, NULL, 0);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parseConsole(const char *arg, RenderLayout *layout) {
+    if (strcasecmp(arg, "gameboy") == 0) *layout = RenderLayoutGameBoyTiles;
+    else if (strcasecmp(arg, "nes") == 0) *layout = RenderLayoutNESTiles;
+    else if (strcasecmp(arg, "snes4") == 0) *layout = RenderLayoutSNES4BitTiles;
+    else if (strcasecmp(arg, "snes8") == 0) *layout = RenderLayoutSNES8BitTiles;
+    else if (strcasecmp(arg, "sms") == 0) *layout = RenderLayoutMasterSystemTiles;
+    else return false;
+    return true;
+}
+
+static bool parsePixelFormat(const char *arg, RenderPixelFormat *pixelFormat) {
+    if (strcasecmp(arg, "rgb555") == 0) *pixelFormat = RenderPixelFormatRGB555;
+    else if (strcasecmp(arg, "rgb565") == 0) *pixelFormat = RenderPixelFormatRGB565;
+    else if (strcasecmp(arg, "rgba555") == 0) *pixelFormat = RenderPixelFormatRGBA555;
+    else if (strcasecmp(arg, "argb555") == 0) *pixelFormat = RenderPixelFormatARGB555;
+    else if (strcasecmp(arg, "bgr555") == 0) *pixelFormat = RenderPixelFormatBGR555;
+    else if (strcasecmp(arg, "bgr565") == 0) *pixelFormat = RenderPixelFormatBGR565;
+    else if (strcasecmp(arg, "rgb444") == 0) *pixelFormat = RenderPixelFormatRGB444;
+    else if (strcasecmp(arg, "argb4444") == 0) *pixelFormat = RenderPixelFormatARGB4444;
+    else return false;
+    return true;
+}
+
+// MARK: - Main
+
+int main(int argc, char *argv[]) {
+    static const struct option longOptions[] = {
+        {"output",      required_argument,  NULL, 'o'},
+        {"offset",      required_argument,  NULL, 'O'},
+        {"width",       required_argument,  NULL, 'w'},
+        {"height",      required_argument,  NULL, 'h'},
+        {"planes",      required_argument,  NULL, 'p'},
+        {"bits",        required_argument,  NULL, 'b'},
+        {"endian",      required_argument,  NULL, 'e'},
+        {"palette",     required_argument,  NULL, 'P'},
+        {"format",      required_argument,  NULL, 'f'},
+        {"tile",        required_argument,  NULL, 't'},
+        {"padding",     required_argument,  NULL, 'g'},
+        {"alpha",       no_argument,        NULL, 'a'},
+        {"mask",        no_argument,        NULL, 'm'},
+        {"zx-screen",   no_argument,        NULL, 'S'},
+        {"c64",         required_argument,  NULL, 'C'},
+        {"console",     required_argument,  NULL, 'K'},
+        {"tilemap",     required_argument,  NULL, 'L'},
+        {"frames",      required_argument,  NULL, 'n'},
+        {"split",       no_argument,        NULL, 's'},
+        {"atlas",       required_argument,  NULL, 'A'},
+        {"manifest",    required_argument,  NULL, 'M'},
+        {"level",       required_argument,  NULL, 'z'},
+        {"extension",   required_argument,  NULL, 'x'},
+        {"jobs",        required_argument,  NULL, 'j'},
+        {"detect",      no_argument,        NULL, 'd'},
+        {"trace",       required_argument,  NULL, 'T'},
+        {"verbose",     no_argument,        NULL, 'v'},
+        {"help",        no_argument,        NULL, 'H'},
+        {NULL, 0, NULL, 0}
+    };
+    
+    RenderGeometry *geometry = &options.geometry;
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    int opt;
+    
+    *geometry = (RenderGeometry){
+        .width = 320,
+        .height = 200,
+        .bitsPerPixel = 8,
+        .planeCount = 1,
+        .bigEndian = true,
+        .pixelFormat = RenderPixelFormatRGB555,
+        .tileWidth = 1,
+        .tileHeight = 1
+    };
+    defaultPalette(&options.palette);
+    options.output = ".";
+    options.frames = 1;
+    options.level = 6;
+    
+    while ((opt = getopt_long(argc, argv, "o:O:w:h:p:b:e:P:f:t:g:amSC:K:L:n:sA:M:z:x:j:dT:v", longOptions, NULL)) != -1) {
+        switch (opt) {
+            case 'o':
+                options.output = optarg;
+                break;
+                
+            case 'O':
+                options.offset = strtol(optarg, NULL, 0);
+                break;
+                
+            case 'w':
+                geometry->width = (int)strtol(optarg, NULL, 0);
+                break;
+                
+            case 'h':
+                geometry->height = (int)strtol(optarg, NULL, 0);
+                break;
+                
+            case 'p':
+                geometry->planeCount = (int)strtol(optarg, NULL, 0);
+                break;
+                
+            case 'b':
+                geometry->bitsPerPixel = (int)strtol(optarg, NULL, 0);
+                break;
+                
+            case 'e':
+                geometry->bigEndian = strcasecmp(optarg, "little") != 0;
+                break;
+                
+            case 'P':
+                if (loadPaletteWithContentsOfFile(optarg, &options.palette) == false) {
+                    fprintf(stderr, "error: %s: not a palette file\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+                
+            case 'f':
+                if (parsePixelFormat(optarg, &geometry->pixelFormat) == false) {
+                    fprintf(stderr, "error: unknown pixel format '%s'\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+                
+            case 't':
+                if (parseTileSize(optarg, &geometry->tileWidth, &geometry->tileHeight) == false) {
+                    fprintf(stderr, "error: invalid tile size '%s'\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+                
+            case 'g':
+                geometry->padding = (int)strtol(optarg, NULL, 0);
+                break;
+                
+            case 'a':
+                geometry->alphaPlane = true;
+                geometry->maskPlane = false;
+                break;
+                
+            case 'm':
+                geometry->maskPlane = true;
+                geometry->alphaPlane = false;
+                break;
+                
+            case 'S':
+                geometry->layout = RenderLayoutZXScreen;
+                break;
+                
+            case 'C':
+                if (strcasecmp(optarg, "hires") == 0) geometry->layout = RenderLayoutC64Hires;
+                else if (strcasecmp(optarg, "multicolor") == 0) geometry->layout = RenderLayoutC64Multicolor;
+                else {
+                    fprintf(stderr, "error: unknown C64 bitmap '%s'\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+                
+            case 'K':
+                if (parseConsole(optarg, &geometry->layout) == false) {
+                    fprintf(stderr, "error: unknown console tiles '%s'\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+                
+            case 'L':
+                if (parseTilemap(optarg, &options.map, &options.mapOffset) == false) {
+                    fprintf(stderr, "error: invalid tilemap '%s'\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                options.tilemap = true;
+                break;
+                
+            case 'n':
+                options.frames = strtol(optarg, NULL, 0);
+                break;
+                
+            case 's':
+                options.split = true;
+                break;
+                
+            case 'A':
+                options.atlas = true;
+                options.columns = strtol(optarg, NULL, 0);
+                break;
+                
+            case 'M':
+                if (strcasecmp(optarg, "json") == 0) options.manifest = ManifestJSON;
+                else if (strcasecmp(optarg, "csv") == 0) options.manifest = ManifestCSV;
+                else {
+                    fprintf(stderr, "error: unknown manifest format '%s'\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+                
+            case 'z':
+                options.level = (int)strtol(optarg, NULL, 0);
+                if (options.level < 0 || options.level > 9) {
+                    fprintf(stderr, "error: compression level must be 0 to 9\n");
+                    return EXIT_FAILURE;
+                }
+                break;
+                
+            case 'x':
+                options.extension = optarg;
+                break;
+                
+            case 'j':
+                jobs = strtol(optarg, NULL, 0);
+                break;
+                
+            case 'd':
+                options.detect = true;
+                break;
+                
+            case 'T':
+                options.trace = optarg;
+                break;
+                
+            case 'v':
+                options.verbose = true;
+                break;
+                
+            case 'H':
+                usage(argv[0]);
+                return EXIT_SUCCESS;
+                
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    
+    if (optind >= argc) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    
+    if (geometry->planeCount < 1) geometry->planeCount = 1;
+    
+    int pictureWidth, pictureHeight;
+    long pictureBytes;
+    if (pictureSize(geometry, &pictureWidth, &pictureHeight, &pictureBytes)) {
+        geometry->width = pictureWidth;
+        geometry->height = geometry->height < pictureHeight ? pictureHeight : geometry->height / pictureHeight * pictureHeight;
+    }
+    if (tileFormatBits(geometry->layout) > 0) {
+        // Whole rows of 8 by 8 tiles, at least one.
+        geometry->planeCount = 1;
+        geometry->bitsPerPixel = tileFormatBits(geometry->layout);
+        geometry->alphaPlane = false;
+        geometry->maskPlane = false;
+        geometry->tileWidth = TILE_FORMAT_SIZE;
+        geometry->tileHeight = TILE_FORMAT_SIZE;
+        geometry->width = geometry->width < TILE_FORMAT_SIZE ? TILE_FORMAT_SIZE : geometry->width / TILE_FORMAT_SIZE * TILE_FORMAT_SIZE;
+        geometry->height = geometry->height < TILE_FORMAT_SIZE ? TILE_FORMAT_SIZE : geometry->height / TILE_FORMAT_SIZE * TILE_FORMAT_SIZE;
+    }
+    if (options.tilemap) {
+        // Levels of whole tiles, at least one.
+        if (geometry->tileWidth < 2 || geometry->tileHeight < 2 || (geometry->layout != RenderLayoutLinear && tileFormatBits(geometry->layout) == 0)) {
+            fprintf(stderr, "error: --tilemap needs a tile size\n");
+            return EXIT_FAILURE;
+        }
+        options.map.width = geometry->width < geometry->tileWidth ? 1 : geometry->width / geometry->tileWidth;
+        options.map.height = geometry->height < geometry->tileHeight ? 1 : geometry->height / geometry->tileHeight;
+        geometry->width = options.map.width * geometry->tileWidth;
+        geometry->height = options.map.height * geometry->tileHeight;
+    }
+    if (isValidGeometry(geometry) == false || bytesPerImage(geometry) < 1) {
+        fprintf(stderr, "error: unsupported geometry %dx%d, %d plane(s) of %d bit(s)\n", geometry->width, geometry->height, geometry->planeCount, geometry->bitsPerPixel);
+        return EXIT_FAILURE;
+    }
+    if (options.split && geometry->tileWidth == 1 && geometry->tileHeight == 1) {
+        fprintf(stderr, "error: --split needs a tile size\n");
+        return EXIT_FAILURE;
+    }
+    if (options.atlas && options.manifest == ManifestNone) options.manifest = ManifestJSON;
+    buildLookup(&options.lookup, geometry, &options.palette);
+    
+    for (int i = optind; i < argc; i++) {
+        const char *path = argv[i];
+        const char *name = strrchr(path, '/');
+        struct stat st;
+        
+        // Files keep their own name, directories are mirrored into the output directory.
+        if (stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+            addPath(path, "");
+        } else {
+            addPath(path, name ? name + 1 : path);
+        }
+    }
+    
+    if (options.detect) {
+        // One file at a time, the detector already runs on every core.
+        for (size_t i = 0; i < queue.count; i++) {
+            if (detect(&queue.jobs[i]) == false) atomic_fetch_add(&queue.failed, 1);
+        }
+    } else {
+        if (jobs < 1) jobs = 1;
+        if (options.trace) setTracing(true);
+        for (size_t i = 0; i < queue.count; i++) {
+            planJob(i, jobs);
+        }
+        if ((size_t)jobs > queue.taskCount) jobs = queue.taskCount ? (long)queue.taskCount : 1;
+        
+        pthread_t *threads = malloc(jobs * sizeof(pthread_t));
+        for (long i = 0; i < jobs; i++) {
+            pthread_create(&threads[i], NULL, worker, NULL);
+        }
+        for (long i = 0; i < jobs; i++) {
+            pthread_join(threads[i], NULL);
+        }
+        free(threads);
+        
+        if (options.trace && writeTrace(options.trace) == false) {
+            fprintf(stderr, "warning: %s: unable to write trace\n", options.trace);
+        }
+        
+        printf("%zu image(s) written from %zu file(s)", (size_t)queue.written, queue.count);
+        if (queue.failed) printf(", %zu failed", (size_t)queue.failed);
+        printf("\n");
+    }
+    
+    for (size_t i = 0; i < queue.count; i++) {
+        free(queue.jobs[i].path);
+        free(queue.jobs[i].name);
+    }
+    free(queue.jobs);
+    free(queue.tasks);
+    
+    return queue.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
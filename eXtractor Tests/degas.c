@@ -0,0 +1,166 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "Degas.h"
+
+/*
+ Checks PackBits against hand made runs and damaged data, and unpacks DEGAS Elite pictures
+ packed here from known images.
+ */
+
+static void unpackRuns(void) {
+    const uint8_t src[] = {
+        2, 'a', 'b', 'c',       // Literal run of three bytes
+        0x80,                   // No-op
+        0xFD, 'x',              // Four repeats
+        0x80, 0x80,
+        0, 'z'                  // Literal run of one byte
+    };
+    uint8_t dst[8] = {0};
+    
+    expect(unpackBits(src, sizeof(src), dst, sizeof(dst)) == (long)sizeof(src));
+    expect(memcmp(dst, "abcxxxxz", 8) == 0);
+    
+    // Stops as soon as dst is full, whatever follows.
+    expect(unpackBits(src, sizeof(src), dst, 3) == 4);
+    
+    // The longest runs either way.
+    uint8_t runs[2 + 129];
+    uint8_t out[257];
+    runs[0] = 0x81;
+    runs[1] = 0x55;
+    runs[2] = 127;
+    for (int i = 0; i < 128; i++) runs[3 + i] = (uint8_t)i;
+    expect(unpackBits(runs, sizeof(runs), out, 128 + 128) == (long)sizeof(runs));
+    expect(out[0] == 0x55 && out[127] == 0x55 && out[128] == 0 && out[255] == 127);
+}
+
+static void unpackDamaged(void) {
+    uint8_t dst[16];
+    
+    // Source ends inside a literal run, before the byte to repeat, and before dst is full.
+    const uint8_t literal[] = {3, 'a', 'b'};
+    const uint8_t repeat[] = {0xFE};
+    const uint8_t shortRun[] = {1, 'a', 'b'};
+    const uint8_t noOps[] = {0x80, 0x80};
+    expect(unpackBits(literal, sizeof(literal), dst, sizeof(dst)) == -1);
+    expect(unpackBits(repeat, sizeof(repeat), dst, sizeof(dst)) == -1);
+    expect(unpackBits(shortRun, sizeof(shortRun), dst, sizeof(dst)) == -1);
+    expect(unpackBits(noOps, sizeof(noOps), dst, sizeof(dst)) == -1);
+    
+    // Runs longer than the room left in dst.
+    const uint8_t longLiteral[] = {4, 'a', 'b', 'c', 'd', 'e'};
+    const uint8_t longRepeat[] = {0, 'a', 0xFC, 'b'};
+    expect(unpackBits(longLiteral, sizeof(longLiteral), dst, 4) == -1);
+    expect(unpackBits(longRepeat, sizeof(longRepeat), dst, 4) == -1);
+}
+
+/* PackBits as DEGAS Elite writes it, repeats of three or more bytes and literals between. */
+static long packBits(const uint8_t *src, long length, uint8_t *dst) {
+    long o = 0;
+    
+    for (long i = 0; i < length;) {
+        long repeat = 1;
+        while (i + repeat < length && repeat < 128 && src[i + repeat] == src[i]) repeat++;
+        if (repeat >= 3) {
+            dst[o++] = (uint8_t)(1 - repeat);
+            dst[o++] = src[i];
+            i += repeat;
+            continue;
+        }
+        
+        long literal = 0;
+        while (i + literal < length && literal < 128) {
+            if (i + literal + 2 < length && src[i + literal] == src[i + literal + 1] && src[i + literal] == src[i + literal + 2]) break;
+            literal++;
+        }
+        dst[o++] = (uint8_t)(literal - 1);
+        memcpy(dst + o, src + i, literal);
+        o += literal;
+        i += literal;
+    }
+    return o;
+}
+
+/* Packs an ST screen as a PC1, PC2 or PC3 file, each plane of a line on its own, and unpacks it again. */
+static void unpackPicture(uint32_t *state, int resolution) {
+    const int planeCount = 4 >> resolution;
+    const int lineBytes = 160, planeBytes = lineBytes / planeCount;
+    uint8_t *screen = malloc(DEGAS_IMAGE_BYTES);
+    uint8_t *file = malloc(sizeof(Degas) + DEGAS_IMAGE_BYTES * 2 + sizeof(DegasAnimation));
+    uint8_t *image = malloc(DEGAS_IMAGE_BYTES);
+    expect(screen != NULL && file != NULL && image != NULL);
+    if (screen == NULL || file == NULL || image == NULL) goto cleanup;
+    
+    // Runs of a random length, so both kinds of PackBits run are used.
+    for (long i = 0; i < DEGAS_IMAGE_BYTES;) {
+        uint8_t value = (uint8_t)nextRandom(state);
+        long run = nextRandom(state) % 2 ? 1 : nextRandom(state) % 24 + 1;
+        while (run-- > 0 && i < DEGAS_IMAGE_BYTES) screen[i++] = value;
+    }
+    
+    memset(file, 0, sizeof(Degas));
+    file[0] = 0x80;
+    file[1] = (uint8_t)resolution;
+    long length = sizeof(Degas);
+    
+    for (int line = 0; line < DEGAS_IMAGE_BYTES / lineBytes; line++) {
+        for (int p = 0; p < planeCount; p++) {
+            uint8_t plane[160];
+            for (int w = 0; w < planeBytes; w += 2) {
+                plane[w] = screen[line * lineBytes + w * planeCount + p * 2];
+                plane[w + 1] = screen[line * lineBytes + w * planeCount + p * 2 + 1];
+            }
+            length += packBits(plane, planeBytes, file + length);
+        }
+    }
+    memset(file + length, 0, sizeof(DegasAnimation));
+    length += sizeof(DegasAnimation);
+    
+    expect(isDegasFormat(file, length));
+    expect(isDegasCompressed(file));
+    expect(degasAnimationOffset(file, length) == length - (long)sizeof(DegasAnimation));
+    expect(unpackDegas(file, length, image));
+    expect(memcmp(image, screen, DEGAS_IMAGE_BYTES) == 0);
+    
+    // Cut short, it no longer fills the screen.
+    expect(isDegasFormat(file, length - sizeof(DegasAnimation) - 2) == false);
+    expect(unpackDegas(file, length - sizeof(DegasAnimation) - 2, image) == false);
+    
+cleanup:
+    free(screen);
+    free(file);
+    free(image);
+}
+
+int main(void) {
+    uint32_t state = 1;
+    
+    unpackRuns();
+    unpackDamaged();
+    for (int resolution = 0; resolution <= 2; resolution++) unpackPicture(&state, resolution);
+    return failures;
+}
@@ -0,0 +1,78 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <stdlib.h>
+
+#include "test.h"
+#include "search.h"
+
+/*
+ Hides sprites in random data and checks searchImage finds them where they were put.
+ */
+
+#define SOURCE_LENGTH (1L << 20)
+
+static bool hasMatch(const RenderMatch *matches, int count, long offset, int width, int bitsPerPixel) {
+    for (int i = 0; i < count; i++) {
+        if (matches[i].offset == offset && matches[i].geometry.width == width &&
+            matches[i].geometry.bitsPerPixel == bitsPerPixel && matches[i].geometry.planeCount == 1) return true;
+    }
+    return false;
+}
+
+/* A 1-bit sprite with fewer than four whole bytes a row, stored in a 320 pixel wide screen. */
+static void findNarrowSprite(uint32_t *state, int width, int height) {
+    DataSource *source = createDataSource(SOURCE_LENGTH);
+    uint32_t *pixel = malloc(sizeof(uint32_t) * width * height);
+    expect(source != NULL && pixel != NULL);
+    if (source == NULL || pixel == NULL) return;
+    
+    uint8_t *bytes = beginDataSourceWrite(source, 0, SOURCE_LENGTH);
+    for (long i = 0; i < SOURCE_LENGTH; i++) bytes[i] = (uint8_t)nextRandom(state);
+    
+    const long offset = 123457, stride = 40;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            bool set = bytes[offset + y * stride + x / 8] >> (7 - x % 8) & 1;
+            pixel[y * width + x] = set ? 0xFFFFFFFF : 0xFF000000;
+        }
+    }
+    endDataSourceWrite(source, 0, SOURCE_LENGTH);
+    
+    RenderPalette palette = {.colorCount = 2, .rgb = {0x000000, 0xFFFFFF}};
+    RenderMatch matches[16];
+    int count = searchImage(source, pixel, width, height, &palette, matches, 16);
+    expect(count >= 1);
+    expect(hasMatch(matches, count, offset, (int)stride * 8, 1));
+    
+    free(pixel);
+    closeDataSource(source);
+}
+
+int main(void) {
+    uint32_t state = 1;
+    
+    findNarrowSprite(&state, 16, 16);
+    findNarrowSprite(&state, 24, 21);
+    findNarrowSprite(&state, 31, 16);
+    return failures;
+}
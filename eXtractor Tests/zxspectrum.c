@@ -0,0 +1,386 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "ZX Snapshot.h"
+#include "ZX Tape.h"
+
+/*
+ Builds .SNA, .Z80, .TAP and .TZX files around known memory and data, and checks they
+ unpack and index back to it.
+ */
+
+#define SNA_HEADER_BYTES 27
+#define Z80_HEADER_BYTES 30
+
+static uint8_t file[ZX_BANK_COUNT * ZX_BANK_BYTES * 2];
+static long fileLength;
+
+static void put(const void *bytes, long length) {
+    memcpy(file + fileLength, bytes, length);
+    fileLength += length;
+}
+
+static void putByte(uint8_t value) {
+    file[fileLength++] = value;
+}
+
+static void putLittleEndian(long value, int count) {
+    for (int i = 0; i < count; i++) putByte((uint8_t)(value >> i * 8));
+}
+
+/* Banks of runs and lone ED bytes, each bank starting with its own number. */
+static void fillBanks(uint32_t *state, uint8_t banks[ZX_BANK_COUNT][ZX_BANK_BYTES]) {
+    for (int b = 0; b < ZX_BANK_COUNT; b++) {
+        for (long i = 0; i < ZX_BANK_BYTES;) {
+            uint8_t value = nextRandom(state) % 4 ? (uint8_t)nextRandom(state) : 0xED;
+            long run = nextRandom(state) % 2 ? 1 : nextRandom(state) % 300 + 1;
+            while (run-- > 0 && i < ZX_BANK_BYTES) banks[b][i++] = value;
+        }
+        banks[b][0] = (uint8_t)b;
+    }
+}
+
+/* .Z80 packing, runs of five or more, or of two or more ED bytes, and never a run right after a lone ED. */
+static void putZ80Packed(const uint8_t *bytes, long length) {
+    for (long i = 0; i < length;) {
+        long run = 1;
+        while (i + run < length && run < 255 && bytes[i + run] == bytes[i]) run++;
+        
+        if (run >= 5 || (bytes[i] == 0xED && run >= 2)) {
+            put("\xED\xED", 2);
+            putByte((uint8_t)run);
+            putByte(bytes[i]);
+            i += run;
+        } else if (bytes[i] == 0xED) {
+            putByte(0xED);
+            i++;
+            if (i < length) putByte(bytes[i++]);
+        } else {
+            putByte(bytes[i++]);
+        }
+    }
+}
+
+static void unpackRuns(void) {
+    uint8_t bytes[ZX_BANK_BYTES];
+    
+    const uint8_t runs[] = {1, 0xED, 0xED, 5, 0xAA, 2, 0xED, 0xED, 0, 0x33, 0xED, 0xED, 2, 0xED};
+    const uint8_t expected[] = {1, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 2, 0xED, 0xED};
+    expect(unpackZ80(runs, sizeof(runs), bytes, sizeof(expected)) == (long)sizeof(runs));
+    expect(memcmp(bytes, expected, sizeof(expected)) == 0);
+    
+    // A lone ED is itself, even as the last byte.
+    const uint8_t lone[] = {0xED, 0x01, 0xED};
+    expect(unpackZ80(lone, sizeof(lone), bytes, 3) == 3);
+    expect(bytes[0] == 0xED && bytes[1] == 0x01 && bytes[2] == 0xED);
+    
+    // A run cut short by the end of the packed data.
+    const uint8_t truncated[] = {0x01, 0xED, 0xED, 0x05};
+    expect(unpackZ80(truncated, sizeof(truncated), bytes, 6) == -1);
+    expect(unpackZ80(truncated, 3, bytes, 6) == -1);
+    
+    // Runs filling all but 64 bytes of a bank, then one run past its end.
+    uint8_t overflow[65 * 4];
+    for (int i = 0; i < 65; i++) memcpy(overflow + i * 4, "\xED\xED\xFF\x00", 4);
+    overflow[64 * 4 + 2] = 65;
+    expect(unpackZ80(overflow, 64 * 4, bytes, ZX_BANK_BYTES) == -1);
+    expect(unpackZ80(overflow, sizeof(overflow), bytes, ZX_BANK_BYTES) == -1);
+    overflow[64 * 4 + 2] = 64;
+    expect(unpackZ80(overflow, sizeof(overflow), bytes, ZX_BANK_BYTES) == (long)sizeof(overflow));
+}
+
+static void putSnaHeader(uint8_t border) {
+    fileLength = 0;
+    for (int i = 0; i < SNA_HEADER_BYTES; i++) putByte(0);
+    file[25] = 1;
+    file[26] = border;
+}
+
+static void readSna(uint8_t banks[ZX_BANK_COUNT][ZX_BANK_BYTES]) {
+    putSnaHeader(3);
+    put(banks[5], ZX_BANK_BYTES);
+    put(banks[2], ZX_BANK_BYTES);
+    put(banks[0], ZX_BANK_BYTES);
+    expect(fileLength == 49179);
+    
+    ZXSnapshot *snapshot = createZXSnapshot(file, fileLength);
+    expect(snapshot != NULL);
+    if (snapshot != NULL) {
+        expect(snapshot->is128K == false && snapshot->border == 3);
+        expect(snapshot->present[0] && snapshot->present[2] && snapshot->present[5] && snapshot->present[1] == false);
+        expect(memcmp(snapshot->bank[5], banks[5], ZX_BANK_BYTES) == 0);
+        expect(memcmp(snapshot->bank[0], banks[0], ZX_BANK_BYTES) == 0);
+        closeZXSnapshot(snapshot);
+    }
+    
+    // 128K, the paged bank is stored with the 48K, and again with the others when it is 2 or 5.
+    const int paged[] = {0, 2, 5, 7};
+    for (int p = 0; p < 4; p++) {
+        putSnaHeader(1);
+        put(banks[5], ZX_BANK_BYTES);
+        put(banks[2], ZX_BANK_BYTES);
+        put(banks[paged[p]], ZX_BANK_BYTES);
+        putLittleEndian(0x8000, 2);
+        putByte((uint8_t)(paged[p] | 8));
+        putByte(0);
+        for (int b = 0; b < ZX_BANK_COUNT; b++) {
+            if (b != 5 && b != 2 && b != paged[p]) put(banks[b], ZX_BANK_BYTES);
+        }
+        expect(fileLength == (paged[p] == 2 || paged[p] == 5 ? 147487 : 131103));
+        
+        ZXSnapshot *snapshot = createZXSnapshot(file, fileLength);
+        expect(snapshot != NULL);
+        if (snapshot == NULL) continue;
+        
+        expect(snapshot->is128K && snapshot->pagedBank == paged[p] && snapshot->shadowScreen);
+        for (int b = 0; b < ZX_BANK_COUNT; b++) {
+            expect(snapshot->present[b]);
+            expect(memcmp(snapshot->bank[b], banks[b], ZX_BANK_BYTES) == 0);
+        }
+        closeZXSnapshot(snapshot);
+    }
+}
+
+static void putZ80Header(long pc, uint8_t flags) {
+    fileLength = 0;
+    for (int i = 0; i < Z80_HEADER_BYTES; i++) putByte(0);
+    file[6] = (uint8_t)pc;
+    file[7] = (uint8_t)(pc >> 8);
+    file[12] = flags;
+}
+
+static void readZ80(uint8_t banks[ZX_BANK_COUNT][ZX_BANK_BYTES]) {
+    uint8_t memory[3 * ZX_BANK_BYTES];
+    memcpy(memory, banks[5], ZX_BANK_BYTES);
+    memcpy(memory + ZX_BANK_BYTES, banks[2], ZX_BANK_BYTES);
+    memcpy(memory + 2 * ZX_BANK_BYTES, banks[0], ZX_BANK_BYTES);
+    uint8_t view[3 * ZX_BANK_BYTES];
+    
+    // Version 1, the 48K packed as one block and closed by the end marker.
+    putZ80Header(0x8000, 0x20 | 6 << 1);
+    putZ80Packed(memory, sizeof(memory));
+    put("\x00\xED\xED\x00", 4);
+    expect(isZXZ80Format(file, fileLength));
+    expect(isZXZ80Format(file, fileLength - 1) == false);
+    
+    ZXSnapshot *snapshot = createZXSnapshot(file, fileLength);
+    expect(snapshot != NULL);
+    if (snapshot != NULL) {
+        expect(snapshot->is128K == false && snapshot->border == 6);
+        copyZXSnapshotView(snapshot, ZXSnapshotView48K, view);
+        expect(memcmp(view, memory, sizeof(memory)) == 0);
+        closeZXSnapshot(snapshot);
+    }
+    
+    // Version 3, a 48K machine stores 0x4000 as page 8, 0x8000 as page 4 and 0xC000 as page 5.
+    putZ80Header(0, 0);
+    putLittleEndian(54, 2);
+    for (int i = 0; i < 54; i++) putByte(0);
+    
+    putLittleEndian(0xFFFF, 2);
+    putByte(8);
+    put(banks[5], ZX_BANK_BYTES);
+    
+    const int pages[2] = {4, 5}, stored[2] = {2, 0};
+    for (int i = 0; i < 2; i++) {
+        long block = fileLength;
+        putLittleEndian(0, 2);
+        putByte((uint8_t)pages[i]);
+        putZ80Packed(banks[stored[i]], ZX_BANK_BYTES);
+        long packed = fileLength - block - 3;
+        file[block] = (uint8_t)packed;
+        file[block + 1] = (uint8_t)(packed >> 8);
+    }
+    
+    // A ROM page is skipped.
+    putLittleEndian(4, 2);
+    putByte(0);
+    put("\xED\xED\xFF\x00", 4);
+    expect(isZXZ80Format(file, fileLength));
+    
+    snapshot = createZXSnapshot(file, fileLength);
+    expect(snapshot != NULL);
+    if (snapshot != NULL) {
+        expect(snapshot->is128K == false);
+        expect(snapshot->present[5] && snapshot->present[2] && snapshot->present[0] && snapshot->present[3] == false);
+        copyZXSnapshotView(snapshot, ZXSnapshotView48K, view);
+        expect(memcmp(view, memory, sizeof(memory)) == 0);
+        closeZXSnapshot(snapshot);
+    }
+    
+    // Longer than any machine's memory.
+    expect(isZXZ80Format(file, ZX_Z80_MAX_BYTES + 1) == false);
+    
+    // A block running past the end of the file.
+    file[Z80_HEADER_BYTES + 2 + 54]++;
+    expect(isZXZ80Format(file, fileLength) == false);
+}
+
+/* A standard speed block with its flag and checksum, as a .TAP or a TZX block 0x10 holds it. */
+static void putTapBlock(uint8_t flag, const uint8_t *data, long length) {
+    uint8_t checksum = flag;
+    for (long i = 0; i < length; i++) checksum ^= data[i];
+    putLittleEndian(length + 2, 2);
+    putByte(flag);
+    put(data, length);
+    putByte(checksum);
+}
+
+static void putHeader(uint8_t type, const char *name, long length) {
+    uint8_t header[17] = {type};
+    memset(header + 1, ' ', 10);
+    memcpy(header + 1, name, strlen(name));
+    header[11] = (uint8_t)length;
+    header[12] = (uint8_t)(length >> 8);
+    putTapBlock(0x00, header, sizeof(header));
+}
+
+static void indexTap(void) {
+    uint8_t screen[6912];
+    for (int i = 0; i < 6912; i++) screen[i] = (uint8_t)(i * 7);
+    
+    fileLength = 0;
+    putHeader(3, "screen", sizeof(screen));
+    putTapBlock(0xFF, screen, sizeof(screen));
+    putTapBlock(0xFF, (const uint8_t *)"loose", 5);
+    expect(isZXTapeFormat(file, fileLength) == false);
+    expect(isZXTapFormat(file, fileLength));
+    expect(isZXTapFormat(file, fileLength - 1) == false);
+    
+    // Walked from a copy of the first three bytes of each block alone.
+    long offset = 0, blocks = 0;
+    while (offset >= 0 && offset + 2 <= fileLength) {
+        uint8_t block[3] = {0};
+        memcpy(block, file + offset, fileLength - offset < 3 ? 2 : 3);
+        offset = nextZXTapBlock(block, offset, fileLength);
+        blocks++;
+    }
+    expect(offset == fileLength && blocks == 3);
+    expect(nextZXTapBlock(file, 0, 20) == -1);
+    
+    ZXTapeIndex *index = createZXTapeIndex(file, fileLength);
+    expect(index != NULL);
+    if (index == NULL) return;
+    
+    expect(index->count == 2 && index->viewLength == 6912 + 5);
+    if (index->count == 2) {
+        expect(index->blocks[0].offset == 2 + 19 + 2 + 1 && index->blocks[0].length == 6912);
+        expect(index->blocks[0].flag == 0xFF && index->blocks[0].type == 3 && strcmp(index->blocks[0].name, "screen    ") == 0);
+        expect(index->blocks[1].viewOffset == 6912 && index->blocks[1].type == 0xFF && index->blocks[1].name[0] == 0);
+    }
+    
+    compactZXTape(index, file);
+    expect(memcmp(file, screen, sizeof(screen)) == 0 && memcmp(file + 6912, "loose", 5) == 0);
+    closeZXTapeIndex(index);
+    
+    // The first block has to be a header or data.
+    fileLength = 0;
+    putTapBlock(0x42, screen, 10);
+    expect(isZXTapFormat(file, fileLength) == false);
+}
+
+/* Every kind of block a TZX file can hold, only the data blocks between them indexed. */
+static void indexTzx(void) {
+    const uint8_t data[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    
+    fileLength = 0;
+    put("ZXTape!\x1A\x01\x14", 10);
+    
+    putByte(0x21); putByte(4); put("Game", 4);                      // Group start
+    putByte(0x30); putByte(3); put("abc", 3);                       // Text description
+    putByte(0x10); putLittleEndian(1000, 2);                        // Standard speed data
+    putHeader(3, "code", sizeof(data));
+    putByte(0x10); putLittleEndian(1000, 2);
+    putTapBlock(0xFF, data, sizeof(data));
+    putByte(0x22);                                                  // Group end
+    putByte(0x28); putLittleEndian(5, 2); put("\x01\x00\x00\x01x", 5);  // Select
+    putByte(0x32); putLittleEndian(4, 2); put("\x01\x00\x01y", 4);  // Archive info
+    putByte(0x35); put("0123456789abcdef", 16); putLittleEndian(3, 4); put("xyz", 3);  // Custom info
+    putByte(0x31); putByte(5); putByte(2); put("hi", 2);            // Message
+    putByte(0x33); putByte(1); put("\x00\x01\x00", 3);              // Hardware type
+    putByte(0x12); putLittleEndian(2168, 2); putLittleEndian(3223, 2);  // Pure tone
+    putByte(0x13); putByte(2); putLittleEndian(667, 2); putLittleEndian(735, 2);  // Pulse sequence
+    putByte(0x20); putLittleEndian(0, 2);                           // Pause
+    putByte(0x24); putLittleEndian(2, 2);                           // Loop start
+    putByte(0x25);                                                  // Loop end
+    putByte(0x23); putLittleEndian(1, 2);                           // Jump
+    putByte(0x26); putLittleEndian(1, 2); putLittleEndian(1, 2);    // Call sequence
+    putByte(0x27);                                                  // Return from sequence
+    putByte(0x2A); putLittleEndian(0, 4);                           // Stop if 48K
+    putByte(0x2B); putLittleEndian(1, 4); putByte(1);               // Set signal level
+    putByte(0x34); putLittleEndian(0, 8);                           // Emulation info
+    putByte(0x5A); put("XTape!\x1A\x01\x14", 9);                    // Glue
+    putByte(0x15); putLittleEndian(79, 2); putLittleEndian(0, 2); putByte(8); putLittleEndian(2, 3); put("\x0F\xF0", 2);  // Direct recording
+    putByte(0x18); putLittleEndian(2, 4); put("\x00\x00", 2);       // CSW recording
+    putByte(0x19); putLittleEndian(1, 4); putByte(0);               // Generalized data
+    putByte(0x40); putByte(0); putLittleEndian(2, 3); put("\x00\x00", 2);  // Snapshot
+    
+    // Pure data with a flag and checksum loses them, turbo speed data without a valid checksum keeps every byte.
+    long pure = fileLength;
+    putByte(0x14); putLittleEndian(855, 2); putLittleEndian(1710, 2); putByte(8); putLittleEndian(0, 2);
+    putLittleEndian(sizeof(data) + 2, 3); putByte(0xFF); put(data, sizeof(data)); putByte(0xFF ^ 1 ^ 2 ^ 3 ^ 4 ^ 5 ^ 6 ^ 7 ^ 8);
+    long turbo = fileLength;
+    putByte(0x11);
+    for (int i = 0; i < 15; i++) putByte(0);
+    putLittleEndian(sizeof(data), 3); put(data, sizeof(data));
+    
+    // A block running past the end of the file ends the index.
+    putByte(0x30); putByte(200); put("cut", 3);
+    
+    expect(isZXTapeFormat(file, fileLength));
+    ZXTapeIndex *index = createZXTapeIndex(file, fileLength);
+    expect(index != NULL);
+    if (index == NULL) return;
+    
+    expect(index->count == 3 && index->viewLength == 3 * sizeof(data));
+    if (index->count == 3) {
+        expect(index->blocks[0].blockId == 0x10 && index->blocks[0].flag == 0xFF && index->blocks[0].type == 3);
+        expect(strcmp(index->blocks[0].name, "code      ") == 0);
+        expect(index->blocks[1].blockId == 0x14 && index->blocks[1].offset == pure + 1 + 10 + 1 && index->blocks[1].flag == 0xFF);
+        expect(index->blocks[2].blockId == 0x11 && index->blocks[2].offset == turbo + 1 + 18 && index->blocks[2].flag == 0);
+        expect(index->blocks[2].length == (long)sizeof(data) && index->blocks[2].viewOffset == 2 * (long)sizeof(data));
+    }
+    expect(zxTapeBlockAtViewOffset(index, 0) == 0);
+    expect(zxTapeBlockAtViewOffset(index, 2 * sizeof(data) - 1) == 1);
+    expect(zxTapeBlockAtViewOffset(index, 3 * sizeof(data)) == -1);
+    
+    compactZXTape(index, file);
+    for (int i = 0; i < 3; i++) expect(memcmp(file + i * sizeof(data), data, sizeof(data)) == 0);
+    closeZXTapeIndex(index);
+}
+
+int main(void) {
+    static uint8_t banks[ZX_BANK_COUNT][ZX_BANK_BYTES];
+    uint32_t state = 1;
+    
+    fillBanks(&state, banks);
+    unpackRuns();
+    readSna(banks);
+    readZ80(banks);
+    indexTap();
+    indexTzx();
+    return failures;
+}
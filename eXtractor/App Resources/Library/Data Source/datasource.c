@@ -0,0 +1,300 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "datasource.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define WINDOW_SIZE (1L << 20)          // Minimum number of bytes read at once by pread
+#define OVERLAY_PAGE_SIZE (1L << 16)
+#define GROWTH_LIMIT (64L << 20)        // Address space reserved past the end of a mapped file
+
+struct DataSource {
+    int fd;                     // -1 when not backed by a file
+    long length;
+    long fileLength;
+    long usedLength;            // Longest the source has been, bytes beyond it are still zero
+    
+    // Mapped, copy-on-write. Reserves mapLength bytes of address space.
+    uint8_t *map;
+    long mapLength;
+    
+    // pread fallback, used when map is NULL.
+    uint8_t *window;
+    long windowOffset;
+    long windowLength;
+    long windowCapacity;
+    uint8_t **pages;            // Overlay of written pages, NULL where unchanged
+    long pageCount;
+};
+
+// MARK: - Private Functions
+
+static long roundToPage(long length) {
+    long page = sysconf(_SC_PAGESIZE);
+    return (length + page - 1) / page * page;
+}
+
+/*
+ Maps the file privately in front of zero filled anonymous memory, so the source can
+ grow by up to GROWTH_LIMIT bytes without moving.
+ */
+static bool mapSource(DataSource *source, long length) {
+    long fileBytes = roundToPage(source->fileLength);
+    long reserved = roundToPage(length > source->fileLength ? length : source->fileLength) + GROWTH_LIMIT;
+    
+    uint8_t *base = mmap(NULL, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (base == MAP_FAILED) return false;
+    
+    if (fileBytes > 0 && mmap(base, fileBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, source->fd, 0) == MAP_FAILED) {
+        munmap(base, reserved);
+        return false;
+    }
+    
+    source->map = base;
+    source->mapLength = reserved;
+    return true;
+}
+
+// Reads from the file, zero filling anything beyond its end.
+static void readFile(const DataSource *source, long offset, uint8_t *bytes, long length) {
+    long n = 0;
+    
+    if (source->fd >= 0) {
+        while (n < length && offset + n < source->fileLength) {
+            ssize_t r = pread(source->fd, bytes + n, length - n, offset + n);
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) break;
+            n += r;
+        }
+    }
+    memset(bytes + n, 0, length - n);
+}
+
+static bool reserveWindow(DataSource *source, long capacity) {
+    if (capacity <= source->windowCapacity) return true;
+    
+    uint8_t *window = realloc(source->window, capacity);
+    if (!window) return false;
+    
+    source->window = window;
+    source->windowCapacity = capacity;
+    return true;
+}
+
+static bool reservePages(DataSource *source, long count) {
+    if (count <= source->pageCount) return true;
+    
+    uint8_t **pages = realloc(source->pages, count * sizeof(uint8_t *));
+    if (!pages) return false;
+    
+    memset(pages + source->pageCount, 0, (count - source->pageCount) * sizeof(uint8_t *));
+    source->pages = pages;
+    source->pageCount = count;
+    return true;
+}
+
+static const uint8_t *fillWindow(DataSource *source, long offset, long length) {
+    long capacity = length > WINDOW_SIZE ? length : WINDOW_SIZE;
+    if (reserveWindow(source, capacity) == false) return NULL;
+    
+    source->windowOffset = offset;
+    source->windowLength = source->length - offset < capacity ? source->length - offset : capacity;
+    readFile(source, offset, source->window, source->windowLength);
+    
+    // Written pages take the place of the file.
+    long end = offset + source->windowLength;
+    for (long p = offset / OVERLAY_PAGE_SIZE; p < source->pageCount && p * OVERLAY_PAGE_SIZE < end; p++) {
+        if (!source->pages[p]) continue;
+        
+        long from = p * OVERLAY_PAGE_SIZE > offset ? p * OVERLAY_PAGE_SIZE : offset;
+        long to = (p + 1) * OVERLAY_PAGE_SIZE < end ? (p + 1) * OVERLAY_PAGE_SIZE : end;
+        memcpy(source->window + from - offset, source->pages[p] + from - p * OVERLAY_PAGE_SIZE, to - from);
+    }
+    
+    return source->window;
+}
+
+static DataSource *newDataSource(int fd, long fileLength) {
+    DataSource *source = calloc(1, sizeof(DataSource));
+    if (!source) return NULL;
+    
+    source->fd = fd;
+    source->fileLength = fileLength;
+    source->length = fileLength;
+    source->usedLength = fileLength;
+    return source;
+}
+
+// MARK: - Public Functions
+
+DataSource *openDataSource(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+    if (S_ISREG(st.st_mode) == false) {
+        close(fd);
+        errno = EINVAL;
+        return NULL;
+    }
+    
+    DataSource *source = newDataSource(fd, (long)st.st_size);
+    if (!source) {
+        close(fd);
+        return NULL;
+    }
+    
+    // Falls back to pread windows on filesystems that can't be mapped.
+    mapSource(source, source->fileLength);
+    return source;
+}
+
+DataSource *createDataSource(long length) {
+    DataSource *source = newDataSource(-1, 0);
+    if (!source) return NULL;
+    
+    mapSource(source, length);
+    source->length = length;
+    source->usedLength = length;
+    return source;
+}
+
+void closeDataSource(DataSource *source) {
+    if (!source) return;
+    
+    if (source->map) munmap(source->map, source->mapLength);
+    for (long p = 0; p < source->pageCount; p++) {
+        free(source->pages[p]);
+    }
+    free(source->pages);
+    free(source->window);
+    if (source->fd >= 0) close(source->fd);
+    free(source);
+}
+
+long dataSourceLength(const DataSource *source) {
+    return source->length;
+}
+
+bool setDataSourceLength(DataSource *source, long length) {
+    if (length < 0) return false;
+    
+    if (source->map) {
+        if (length > source->mapLength) return false;
+    } else {
+        source->windowLength = 0;
+    }
+    
+    // Bytes that were cut off, and perhaps written to, read as zero once grown back.
+    long old = source->length;
+    long end = length < source->usedLength ? length : source->usedLength;
+    source->length = length;
+    for (long offset = old; offset < end; offset += WINDOW_SIZE) {
+        long count = end - offset < WINDOW_SIZE ? end - offset : WINDOW_SIZE;
+        uint8_t *bytes = beginDataSourceWrite(source, offset, count);
+        if (!bytes) break;
+        memset(bytes, 0, count);
+        endDataSourceWrite(source, offset, count);
+    }
+    if (length > source->usedLength) source->usedLength = length;
+    return true;
+}
+
+const uint8_t *dataSourceBytes(DataSource *source, long offset, long length) {
+    if (offset < 0 || length < 0 || offset + length > source->length) return NULL;
+    
+    if (source->map) return source->map + offset;
+    
+    if (offset >= source->windowOffset && offset + length <= source->windowOffset + source->windowLength) {
+        return source->window + offset - source->windowOffset;
+    }
+    
+    return fillWindow(source, offset, length);
+}
+
+uint8_t *beginDataSourceWrite(DataSource *source, long offset, long length) {
+    // Both the private mapping and the window are ours to write to.
+    return (uint8_t *)dataSourceBytes(source, offset, length);
+}
+
+void endDataSourceWrite(DataSource *source, long offset, long length) {
+    if (source->map || length <= 0) return;
+    
+    long last = (offset + length - 1) / OVERLAY_PAGE_SIZE;
+    if (reservePages(source, last + 1) == false) return;
+    
+    for (long p = offset / OVERLAY_PAGE_SIZE; p <= last; p++) {
+        if (!source->pages[p]) {
+            source->pages[p] = malloc(OVERLAY_PAGE_SIZE);
+            if (!source->pages[p]) return;
+            readFile(source, p * OVERLAY_PAGE_SIZE, source->pages[p], OVERLAY_PAGE_SIZE);
+        }
+        
+        long from = p * OVERLAY_PAGE_SIZE > offset ? p * OVERLAY_PAGE_SIZE : offset;
+        long to = (p + 1) * OVERLAY_PAGE_SIZE < offset + length ? (p + 1) * OVERLAY_PAGE_SIZE : offset + length;
+        memcpy(source->pages[p] + from - p * OVERLAY_PAGE_SIZE, source->window + from - source->windowOffset, to - from);
+    }
+}
+
+void adviseDataSource(DataSource *source, DataSourceAccess access, long offset, long length) {
+    if (length <= 0 || offset + length > source->length) length = source->length - offset;
+    if (offset < 0 || length <= 0) return;
+    
+    if (source->map) {
+        long page = sysconf(_SC_PAGESIZE);
+        long start = offset / page * page;
+        int advice = MADV_NORMAL;
+        
+        if (access == DataSourceAccessSequential) advice = MADV_SEQUENTIAL;
+        if (access == DataSourceAccessRandom) advice = MADV_RANDOM;
+        if (access == DataSourceAccessWillNeed) advice = MADV_WILLNEED;
+        madvise(source->map + start, offset + length - start, advice);
+        return;
+    }
+    
+    if (source->fd < 0) return;
+    
+#ifdef POSIX_FADV_NORMAL
+    int advice = POSIX_FADV_NORMAL;
+    
+    if (access == DataSourceAccessSequential) advice = POSIX_FADV_SEQUENTIAL;
+    if (access == DataSourceAccessRandom) advice = POSIX_FADV_RANDOM;
+    if (access == DataSourceAccessWillNeed) advice = POSIX_FADV_WILLNEED;
+    posix_fadvise(source->fd, offset, length, advice);
+#elif defined(F_RDAHEAD)
+    if (access == DataSourceAccessWillNeed) {
+        struct radvisory advisory = {.ra_offset = offset, .ra_count = (int)length};
+        fcntl(source->fd, F_RDADVISE, &advisory);
+    } else {
+        fcntl(source->fd, F_RDAHEAD, access == DataSourceAccessRandom ? 0 : 1);
+    }
+#endif
+}
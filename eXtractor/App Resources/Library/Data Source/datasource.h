@@ -0,0 +1,100 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef datasource_h
+#define datasource_h
+
+#include "common.h"
+
+/*
+ Read-only view of a file that is paged in on demand instead of being copied into memory.
+ 
+ Files are mapped privately, so writes land in copy-on-write pages and never reach the
+ file. When a file cannot be mapped, bytes are read with pread into a window and written
+ bytes are kept in an overlay of private pages.
+ 
+ A DataSource is not thread safe, each thread should open its own.
+ */
+
+typedef struct DataSource DataSource;
+
+typedef enum {
+    DataSourceAccessNormal,
+    DataSourceAccessSequential,
+    DataSourceAccessRandom,
+    DataSourceAccessWillNeed
+} DataSourceAccess;
+
+
+/* Set up for C function definitions, even when using C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /*
+     Opens the file at path, returns NULL and sets errno on failure.
+     */
+    DataSource *openDataSource(const char *path);
+    
+    /*
+     Creates a source of length bytes, all zero, that is not backed by a file.
+     */
+    DataSource *createDataSource(long length);
+    
+    void closeDataSource(DataSource *source);
+    
+    long dataSourceLength(const DataSource *source);
+    
+    /*
+     Changes the length of the source. Bytes beyond the end of the file read as zero, as do
+     bytes cut off by an earlier call once the source grows over them again.
+     Returns false if the source could not be grown.
+     */
+    bool setDataSourceLength(DataSource *source, long length);
+    
+    /*
+     Returns length readable bytes starting at offset, or NULL when the range is out of bounds.
+     
+     The pointer is only valid until the next call on the source, as it may point into the
+     pread window rather than the mapping.
+     */
+    const uint8_t *dataSourceBytes(DataSource *source, long offset, long length);
+    
+    /*
+     Returns length writable bytes starting at offset, or NULL when the range is out of bounds.
+     The changes are kept once endDataSourceWrite is called for the same range, with no
+     other calls on the source in between.
+     */
+    uint8_t *beginDataSourceWrite(DataSource *source, long offset, long length);
+    void endDataSourceWrite(DataSource *source, long offset, long length);
+    
+    /*
+     Hints how a range of the source is about to be read, a length of zero means up to the end.
+     */
+    void adviseDataSource(DataSource *source, DataSourceAccess access, long offset, long length);
+
+/* Ends C function definitions when using C++ */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* datasource_h */
@@ -0,0 +1,146 @@
+/*
+Copyright © 2022 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "Commodore 64.h"
+
+#define CELL_COLUMNS    40
+#define CELL_ROWS       25
+
+/*
+ Each bitmap byte expanded to 8 masks, 0xff for a set bit, in display order, so a cell
+ row is selected between its two colors without a branch.
+ */
+#define BIT(b, n)   ((b) & (0x80 >> (n)) ? 0xff : 0x00)
+#define BITS(b)     { BIT(b, 0), BIT(b, 1), BIT(b, 2), BIT(b, 3), BIT(b, 4), BIT(b, 5), BIT(b, 6), BIT(b, 7) }
+#define BYTE4(f, b) f(b), f(b + 1), f(b + 2), f(b + 3)
+#define BYTE16(f, b) BYTE4(f, b), BYTE4(f, b + 4), BYTE4(f, b + 8), BYTE4(f, b + 12)
+#define BYTE64(f, b) BYTE16(f, b), BYTE16(f, b + 16), BYTE16(f, b + 32), BYTE16(f, b + 48)
+#define BYTE256(f)  BYTE64(f, 0), BYTE64(f, 64), BYTE64(f, 128), BYTE64(f, 192)
+
+static const uint8_t bitMask[256][8] = { BYTE256(BITS) };
+
+/*
+ Each bitmap byte split into its 4 bit pairs in display order, the color source of each
+ double width pixel, 0 background, 1 and 2 the high and low nibble of screen RAM, 3 color RAM.
+ */
+#define PAIR(b, n)  ((b) >> (6 - 2 * (n)) & 3)
+#define PAIRS(b)    { PAIR(b, 0), PAIR(b, 1), PAIR(b, 2), PAIR(b, 3) }
+
+static const uint8_t bitPairs[256][4] = { BYTE256(PAIRS) };
+
+static bool hasLoadAddress(const uint8_t *bytes, uint16_t address) {
+    return bytes[0] == (address & 0xff) && bytes[1] == address >> 8;
+}
+
+bool isKoalaFormat(const void *rawData, long unsigned int length) {
+    return length == KOALA_BYTES && hasLoadAddress(rawData, KOALA_LOAD_ADDRESS);
+}
+
+bool isArtStudioFormat(const void *rawData, long unsigned int length) {
+    return length == ART_STUDIO_BYTES && hasLoadAddress(rawData, ART_STUDIO_LOAD_ADDRESS);
+}
+
+/*
+ Bitmaps are cell ordered, so the 8 rows of a cell are decoded together, with the colors
+ of the cell looked up once.
+ */
+void c64HiresToIndices(const uint8_t *bytes, int x, int width, uint8_t *index, long stride) {
+    for (int cellRow = 0; cellRow < CELL_ROWS; cellRow++) {
+        for (int c = 0; c < width; c += 8) {
+            int cell = cellRow * CELL_COLUMNS + (x + c) / 8;
+            const uint8_t *data = bytes + cell * 8;
+            uint8_t ink = bytes[C64_BITMAP_BYTES + cell] >> 4;
+            uint8_t paper = bytes[C64_BITMAP_BYTES + cell] & 0x0f;
+            uint8_t *row = index + cellRow * 8 * stride + c;
+            
+            for (int r = 0; r < 8; r++, row += stride) {
+                const uint8_t *mask = bitMask[data[r]];
+                for (int i = 0; i < 8; i++) {
+                    row[i] = (ink & mask[i]) | (paper & ~mask[i]);
+                }
+            }
+        }
+    }
+}
+
+void c64HiresToPixelData(const uint8_t *bytes, const uint32_t *colors, int x, int width, uint32_t *pixel, long stride) {
+    for (int cellRow = 0; cellRow < CELL_ROWS; cellRow++) {
+        for (int c = 0; c < width; c += 8) {
+            int cell = cellRow * CELL_COLUMNS + (x + c) / 8;
+            const uint8_t *data = bytes + cell * 8;
+            const uint32_t source[2] = { colors[bytes[C64_BITMAP_BYTES + cell] & 0x0f], colors[bytes[C64_BITMAP_BYTES + cell] >> 4] };
+            uint32_t *row = pixel + cellRow * 8 * stride + c;
+            
+            // Indexed by the bit rather than branching on it, as bitmaps are rarely predictable.
+            for (int r = 0; r < 8; r++, row += stride) {
+                const uint8_t *mask = bitMask[data[r]];
+                for (int i = 0; i < 8; i++) {
+                    row[i] = source[mask[i] & 1];
+                }
+            }
+        }
+    }
+}
+
+void c64MulticolorToIndices(const uint8_t *bytes, int x, int width, uint8_t *index, long stride) {
+    const uint8_t *screen = bytes + C64_BITMAP_BYTES;
+    const uint8_t *color = screen + C64_CELL_COUNT;
+    uint8_t background = color[C64_CELL_COUNT] & 0x0f;
+    
+    for (int cellRow = 0; cellRow < CELL_ROWS; cellRow++) {
+        for (int c = 0; c < width; c += 4) {
+            int cell = cellRow * CELL_COLUMNS + (x + c) / 4;
+            const uint8_t *data = bytes + cell * 8;
+            const uint8_t source[4] = { background, screen[cell] >> 4, screen[cell] & 0x0f, color[cell] & 0x0f };
+            uint8_t *row = index + cellRow * 8 * stride + c;
+            
+            for (int r = 0; r < 8; r++, row += stride) {
+                const uint8_t *pairs = bitPairs[data[r]];
+                for (int i = 0; i < 4; i++) {
+                    row[i] = source[pairs[i]];
+                }
+            }
+        }
+    }
+}
+
+void c64MulticolorToPixelData(const uint8_t *bytes, const uint32_t *colors, int x, int width, uint32_t *pixel, long stride) {
+    const uint8_t *screen = bytes + C64_BITMAP_BYTES;
+    const uint8_t *color = screen + C64_CELL_COUNT;
+    uint32_t background = colors[color[C64_CELL_COUNT] & 0x0f];
+    
+    for (int cellRow = 0; cellRow < CELL_ROWS; cellRow++) {
+        for (int c = 0; c < width; c += 4) {
+            int cell = cellRow * CELL_COLUMNS + (x + c) / 4;
+            const uint8_t *data = bytes + cell * 8;
+            const uint32_t source[4] = { background, colors[screen[cell] >> 4], colors[screen[cell] & 0x0f], colors[color[cell] & 0x0f] };
+            uint32_t *row = pixel + cellRow * 8 * stride + c;
+            
+            for (int r = 0; r < 8; r++, row += stride) {
+                const uint8_t *pairs = bitPairs[data[r]];
+                for (int i = 0; i < 4; i++) {
+                    row[i] = source[pairs[i]];
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,98 @@
+/*
+Copyright © 2022 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#ifndef Commodore_64_h
+#define Commodore_64_h
+
+#include "common.h"
+
+#define C64_BITMAP_WIDTH        320
+#define C64_BITMAP_HEIGHT       200
+#define C64_MULTICOLOR_WIDTH    160     // Pixels twice as wide as they are high
+#define C64_BITMAP_BYTES        8000    // 8 bytes a cell, cells in rows of 40
+#define C64_CELL_COUNT          1000    // Bytes of screen RAM, and of color RAM
+#define C64_HIRES_BYTES         (C64_BITMAP_BYTES + C64_CELL_COUNT)
+#define C64_MULTICOLOR_BYTES    (C64_BITMAP_BYTES + 2 * C64_CELL_COUNT + 1)
+
+#define KOALA_BYTES             (2 + C64_MULTICOLOR_BYTES)
+#define KOALA_LOAD_ADDRESS      0x6000
+#define ART_STUDIO_BYTES        (2 + C64_HIRES_BYTES + 7)   // Then the border color and 6 unused bytes
+#define ART_STUDIO_LOAD_ADDRESS 0x2000
+
+/*
+ Bitmaps are decoded straight from the memory they were saved from, wherever they are
+ stored, as the color number of each pixel, 0 to 15.
+ 
+ A hires bitmap is the bitmap followed by screen RAM, whose high nibble colors the set
+ pixels of each cell and low nibble the clear ones, as saved by Art Studio.
+ 
+ A multicolor bitmap is the bitmap, screen RAM, color RAM and the background color, as
+ saved by Koala Painter. Each pair of bits takes its color from the background, the high
+ or low nibble of screen RAM, or color RAM.
+ */
+
+/* Set up for C function definitions, even when using C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /*
+     Koala Painter files are 10003 bytes, loaded at 0x6000.
+     */
+    bool isKoalaFormat(const void *rawData, long unsigned int length);
+    
+    /*
+     Art Studio files are 9009 bytes, loaded at 0x2000.
+     */
+    bool isArtStudioFormat(const void *rawData, long unsigned int length);
+    
+    /*
+     Decodes the columns x to x + width, multiples of 8, of every row of a hires bitmap
+     into color numbers, addressed as index[row * stride + column - x].
+     */
+    void c64HiresToIndices(const uint8_t *bytes, int x, int width, uint8_t *index, long stride);
+    
+    /*
+     Decodes the columns x to x + width, multiples of 8, of every row of a hires bitmap
+     into the pixels of the 16 colors.
+     */
+    void c64HiresToPixelData(const uint8_t *bytes, const uint32_t *colors, int x, int width, uint32_t *pixel, long stride);
+    
+    /*
+     Decodes the columns x to x + width, multiples of 4, of every row of a multicolor bitmap
+     into color numbers, one for each double width pixel.
+     */
+    void c64MulticolorToIndices(const uint8_t *bytes, int x, int width, uint8_t *index, long stride);
+    
+    /*
+     Decodes the columns x to x + width, multiples of 4, of every row of a multicolor bitmap
+     into the pixels of the 16 colors, one for each double width pixel.
+     */
+    void c64MulticolorToPixelData(const uint8_t *bytes, const uint32_t *colors, int x, int width, uint32_t *pixel, long stride);
+
+/* Ends C function definitions when using C++ */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* Commodore_64_h */
@@ -22,48 +22,109 @@ THE SOFTWARE.
 
 #include "Degas.h"
 
+/*
+ Unpacks the lines of a compressed image, which must fill DEGAS_IMAGE_BYTES exactly
+ and leave no more than the color animation at the end of the file.
+ */
+static bool unpackDegasLines(const void *rawData, long unsigned int length, uint8_t *lines) {
+    long packedLength = (long)(length - sizeof(Degas));
+    long used = unpackBits((const uint8_t *)rawData + sizeof(Degas), packedLength, lines, DEGAS_IMAGE_BYTES);
+    return used >= 0 && packedLength - used <= (long)sizeof(DegasAnimation);
+}
+
 bool isDegasFormat(const void *rawData, long unsigned int length) {
+    if (length < sizeof(Degas)) return false;
+    
+    const Degas *degas_ref = (Degas *)rawData;
+    if ((swapInt16BigToHost(degas_ref->resolution) & 3) > 2) return false;
+    
+    if (isDegasCompressed(rawData)) {
+        /// PackBits grows each line of a plane by at most one byte, followed by the color animation.
+        if (length > DEGAS_MAX_BYTES) return false;
+        
+        /// No signature beyond bit 15, only a trial unpack tells it from any other file.
+        uint8_t lines[DEGAS_IMAGE_BYTES];
+        return unpackDegasLines(rawData, length, lines);
+    }
+    
     if (length != 32034) { /// A Degas file will always be exacly 32,034 bytes in length.
         if (length != 32066) { /// DEGAS Elite file will always be exacly 32,066 bytes in length.
             return false;
-        } else {
-            // DEGAS Elite
-            // TODO: Palette Animation...
         }
     }
-    
-    const Degas *degas_ref = (Degas *)rawData;
-    if ((swapInt16BigToHost(degas_ref->resolution) & 3) > 2) return false;
  
     return true;
 }
 
-// PackBits Compression Algorithm
-void unpackBits(void *dst, const void *pck, size_t n) {
-    char *p = (char  *)pck;
-    char *o = dst;
+bool isDegasCompressed(const void *rawData) {
+    const Degas *degas_ref = (Degas *)rawData;
+    return (swapInt16BigToHost(degas_ref->resolution) & 0x8000) != 0;
+}
+
+long degasAnimationOffset(const void *rawData, long unsigned int length) {
+    if (isDegasCompressed(rawData)) {
+        if (length < sizeof(Degas) + sizeof(DegasAnimation)) return -1;
+        return (long)(length - sizeof(DegasAnimation));
+    }
     
-    int i = 0;
+    if (length != 32066) return -1;
+    return sizeof(Degas) + DEGAS_IMAGE_BYTES;
+}
+
+bool unpackDegas(const void *rawData, long unsigned int length, void *image) {
+    if (length < sizeof(Degas) || !isDegasCompressed(rawData)) return false;
     
-    while (i < n) {
-        int k = p[i];
-        if (k >= 128) {
-            k = 256 - k;
-            for (int j = 0; j <= k; ++j) {
-                *o++ = p[i+1];
-            }
-            i++;
-        } else {
-            int j;
-            for (j = 0; j <= k; ++j) {
-                *o++ = p[i+j+1];
+    const Degas *degas_ref = (Degas *)rawData;
+    if ((swapInt16BigToHost(degas_ref->resolution) & 3) > 2) return false;
+    
+    int planeCount = 4 >> (swapInt16BigToHost(degas_ref->resolution) & 3);
+    uint8_t lines[DEGAS_IMAGE_BYTES];
+    
+    // Lines are packed one after the other, runs of a well formed file never cross a plane.
+    if (unpackDegasLines(rawData, length, lines) == false) return false;
+    
+    const int lineBytes = DEGAS_IMAGE_BYTES / DEGAS_LINES;
+    const int planeBytes = lineBytes / planeCount;
+    uint8_t *dst = image;
+    
+    for (int line = 0; line < DEGAS_LINES; line++) {
+        const uint8_t *src = lines + line * lineBytes;
+        
+        for (int w = 0; w < planeBytes; w += 2) {
+            for (int p = 0; p < planeCount; p++) {
+                *dst++ = src[p * planeBytes + w];
+                *dst++ = src[p * planeBytes + w + 1];
             }
-            i += j;
         }
-        i++;
     }
+    
+    return true;
 }
 
-
-
-
+// PackBits Compression Algorithm
+long unpackBits(const uint8_t *src, long srcLength, uint8_t *dst, long dstLength) {
+    long i = 0;
+    long o = 0;
+    
+    while (o < dstLength) {
+        if (i >= srcLength) return -1;
+        
+        int n = (int8_t)src[i++];
+        if (n >= 0) {
+            /// Literal run of n + 1 bytes.
+            long count = n + 1;
+            if (count > srcLength - i || count > dstLength - o) return -1;
+            memcpy(dst + o, src + i, count);
+            i += count;
+            o += count;
+        } else if (n != -128) {
+            /// Repeat the next byte 1 - n times, -128 is a no-op.
+            long count = 1 - n;
+            if (i >= srcLength || count > dstLength - o) return -1;
+            memset(dst + o, src[i++], count);
+            o += count;
+        }
+    }
+    
+    return i;
+}
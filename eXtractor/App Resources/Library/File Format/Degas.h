@@ -32,20 +32,55 @@ typedef struct {
                              resolution [0 = low res, 1 = medium res, 2 = high res]
                              Other bits may be used in the future; use a simple bit
                              test rather than checking for specific word values.
+                             Bit 15 is set when the image is compressed (DEGAS Elite).
                              */
     
     int16_t palette[16];
 } Degas;
 
+typedef struct {
+    int16_t leftLimit[4];       // Lowest color of each of the 4 animation channels
+    int16_t rightLimit[4];      // Highest color of each channel
+    int16_t direction[4];       // 0 = left, 1 = off, 2 = right
+    int16_t delay[4];           // 128 - number of 1/60ths of a second between steps
+} DegasAnimation;
+
 #pragma pack()   /* restore original alignment from stack */
 
+#define DEGAS_IMAGE_BYTES 32000
+#define DEGAS_LINES 200
+#define DEGAS_MAX_BYTES (sizeof(Degas) + DEGAS_IMAGE_BYTES + DEGAS_LINES * 4 + sizeof(DegasAnimation))  // Compressed, every line of every plane grown by a byte
+
 
 /* Set up for C function definitions, even when using C++ */
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+    /*
+     Compressed files are unpacked on trial, so every byte of rawData must be readable.
+     */
     bool isDegasFormat(const void *rawData, long unsigned int length);
+    bool isDegasCompressed(const void *rawData);
+    
+    /*
+     Offset of the DegasAnimation of a DEGAS Elite file, or -1 for a plain Degas file.
+     */
+    long degasAnimationOffset(const void *rawData, long unsigned int length);
+    
+    /*
+     Unpacks the image of a compressed DEGAS Elite file into the DEGAS_IMAGE_BYTES of an
+     uncompressed one. Compressed images keep each plane of a line apart, they are
+     interleaved a word at a time again as the ST shows them.
+     Returns false when the compressed data is damaged.
+     */
+    bool unpackDegas(const void *rawData, long unsigned int length, void *image);
+    
+    /*
+     PackBits, unpacks src until dstLength bytes have been written.
+     Returns the number of source bytes used, or -1 when src ends first or a run would overflow dst.
+     */
+    long unpackBits(const uint8_t *src, long srcLength, uint8_t *dst, long dstLength);
 
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
@@ -0,0 +1,269 @@
+/*
+Copyright © 2022 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "ZX Snapshot.h"
+
+#include <errno.h>
+
+#define SNA_HEADER_BYTES    27
+#define SNA_48K_BYTES       (SNA_HEADER_BYTES + 3 * ZX_BANK_BYTES)
+#define SNA_128K_BYTES      (SNA_48K_BYTES + 4 + 5 * ZX_BANK_BYTES)     // The paged bank is not 2 or 5
+#define SNA_128K_REPEATED   (SNA_128K_BYTES + ZX_BANK_BYTES)            // The paged bank 2 or 5 is stored twice
+#define Z80_HEADER_BYTES    30
+#define Z80_END_MARKER      "\x00\xED\xED\x00"
+
+static long readLittleEndian(const uint8_t *bytes, int count) {
+    long value = 0;
+    for (int i = count - 1; i >= 0; i--) {
+        value = value << 8 | bytes[i];
+    }
+    return value;
+}
+
+/*
+ Places the 48K seen from 0x4000 in the banks 5, 2 and 0.
+ */
+static void set48KMemory(ZXSnapshot *snapshot, const uint8_t *memory) {
+    static const int banks[3] = {5, 2, 0};
+    
+    for (int i = 0; i < 3; i++) {
+        memcpy(snapshot->bank[banks[i]], memory + i * ZX_BANK_BYTES, ZX_BANK_BYTES);
+        snapshot->present[banks[i]] = true;
+    }
+}
+
+static bool isZ80128K(int version, uint8_t hardware) {
+    if (version == 2) return hardware == 3 || hardware == 4;
+    return (hardware >= 4 && hardware <= 10) || hardware == 12 || hardware == 13;
+}
+
+/*
+ Bytes after the header of a version 2 or 3 file, or 0 for version 1.
+ */
+static long z80ExtraHeaderBytes(const uint8_t *file, long length) {
+    if (readLittleEndian(file + 6, 2) != 0 || length < Z80_HEADER_BYTES + 2) return 0;
+    
+    long extra = readLittleEndian(file + Z80_HEADER_BYTES, 2);
+    if (extra != 23 && extra != 54 && extra != 55) return -1;
+    if (Z80_HEADER_BYTES + 2 + extra > length) return -1;
+    return 2 + extra;
+}
+
+static bool readSna(ZXSnapshot *snapshot, const uint8_t *file, long length) {
+    snapshot->border = file[26] & 7;
+    set48KMemory(snapshot, file + SNA_HEADER_BYTES);
+    if (length == SNA_48K_BYTES) return true;
+    
+    // The bank at 0xC000 was stored with the 48K, the rest follow in order.
+    uint8_t port = file[SNA_48K_BYTES + 2];
+    snapshot->is128K = true;
+    snapshot->pagedBank = port & 7;
+    snapshot->shadowScreen = (port & 8) != 0;
+    
+    if (snapshot->pagedBank != 0) {
+        memcpy(snapshot->bank[snapshot->pagedBank], snapshot->bank[0], ZX_BANK_BYTES);
+        snapshot->present[snapshot->pagedBank] = true;
+        snapshot->present[0] = false;
+    }
+    
+    long offset = SNA_48K_BYTES + 4;
+    for (int bank = 0; bank < ZX_BANK_COUNT; bank++) {
+        if (bank == 5 || bank == 2 || bank == snapshot->pagedBank) continue;
+        if (offset + ZX_BANK_BYTES > length) return false;
+        memcpy(snapshot->bank[bank], file + offset, ZX_BANK_BYTES);
+        snapshot->present[bank] = true;
+        offset += ZX_BANK_BYTES;
+    }
+    return true;
+}
+
+static bool readZ80(ZXSnapshot *snapshot, const uint8_t *file, long length) {
+    uint8_t flags = file[12] == 0xFF ? 1 : file[12];
+    snapshot->border = flags >> 1 & 7;
+    
+    long extra = z80ExtraHeaderBytes(file, length);
+    if (extra < 0) return false;
+    
+    if (extra == 0) {
+        // Version 1, the 48K as one block, packed unless it is stored whole.
+        const uint8_t *data = file + Z80_HEADER_BYTES;
+        long dataLength = length - Z80_HEADER_BYTES;
+        if ((flags & 0x20) == 0) {
+            if (dataLength < 3 * ZX_BANK_BYTES) return false;
+            set48KMemory(snapshot, data);
+            return true;
+        }
+        
+        uint8_t *memory = malloc(3 * ZX_BANK_BYTES);
+        if (memory == NULL) return false;
+        bool unpacked = unpackZ80(data, dataLength, memory, 3 * ZX_BANK_BYTES) >= 0;
+        if (unpacked) set48KMemory(snapshot, memory);
+        free(memory);
+        return unpacked;
+    }
+    
+    int version = extra == 2 + 23 ? 2 : 3;
+    snapshot->is128K = isZ80128K(version, file[34]);
+    if (snapshot->is128K) {
+        snapshot->pagedBank = file[35] & 7;
+        snapshot->shadowScreen = (file[35] & 8) != 0;
+    }
+    
+    // Blocks of one page each, pages 3 to 10 being the banks of a 128K machine and 8, 4 and 5
+    // the 48K from 0x4000, any other page is a ROM and skipped.
+    static const int banks48K[12] = {-1, -1, -1, -1, 2, 0, -1, -1, 5, -1, -1, -1};
+    long offset = Z80_HEADER_BYTES + extra;
+    
+    while (length - offset >= 3) {
+        long blockLength = readLittleEndian(file + offset, 2);
+        uint8_t page = file[offset + 2];
+        offset += 3;
+        
+        bool stored = blockLength == 0xFFFF;
+        if (stored) blockLength = ZX_BANK_BYTES;
+        if (blockLength > length - offset) return false;
+        
+        int bank = -1;
+        if (page < 12) bank = snapshot->is128K ? (page >= 3 && page <= 10 ? page - 3 : -1) : banks48K[page];
+        
+        if (bank >= 0) {
+            if (stored) {
+                memcpy(snapshot->bank[bank], file + offset, ZX_BANK_BYTES);
+            } else if (unpackZ80(file + offset, blockLength, snapshot->bank[bank], ZX_BANK_BYTES) < 0) {
+                return false;
+            }
+            snapshot->present[bank] = true;
+        }
+        offset += blockLength;
+    }
+    return true;
+}
+
+// MARK: - Public Functions
+
+bool isZXSnaFormat(const void *rawData, long unsigned int length) {
+    const uint8_t *header = rawData;
+    
+    if (length != SNA_48K_BYTES && length != SNA_128K_BYTES && length != SNA_128K_REPEATED) return false;
+    
+    // Interrupt mode and border color.
+    return header[25] <= 2 && header[26] <= 7;
+}
+
+bool isZXZ80Format(const void *rawData, long unsigned int length) {
+    const uint8_t *file = rawData;
+    
+    if (length < Z80_HEADER_BYTES || length > ZX_Z80_MAX_BYTES) return false;
+    
+    long extra = z80ExtraHeaderBytes(file, (long)length);
+    if (extra < 0) return false;
+    
+    if (extra == 0) {
+        // Version 1, packed memory ends with a marker, memory stored whole is exactly 48K.
+        if (file[12] != 0xFF && (file[12] & 0x20)) {
+            return length >= Z80_HEADER_BYTES + 4 && memcmp(file + length - 4, Z80_END_MARKER, 4) == 0;
+        }
+        return length == Z80_HEADER_BYTES + 3 * ZX_BANK_BYTES;
+    }
+    
+    // Version 2 or 3, a chain of at least one block.
+    long offset = Z80_HEADER_BYTES + extra;
+    if (offset == (long)length) return false;
+    
+    while ((long)length - offset >= 3) {
+        long blockLength = readLittleEndian(file + offset, 2);
+        if (blockLength == 0xFFFF) blockLength = ZX_BANK_BYTES;
+        offset += 3 + blockLength;
+    }
+    return offset == (long)length;
+}
+
+ZXSnapshot *createZXSnapshot(const void *rawData, long unsigned int length) {
+    bool z80 = isZXZ80Format(rawData, length);
+    if (z80 == false && isZXSnaFormat(rawData, length) == false) {
+        errno = EINVAL;
+        return NULL;
+    }
+    
+    ZXSnapshot *snapshot = calloc(1, sizeof(ZXSnapshot));
+    if (snapshot == NULL) return NULL;
+    
+    bool read = z80 ? readZ80(snapshot, rawData, (long)length) : readSna(snapshot, rawData, (long)length);
+    if (read == false) {
+        free(snapshot);
+        errno = EINVAL;
+        return NULL;
+    }
+    return snapshot;
+}
+
+void closeZXSnapshot(ZXSnapshot *snapshot) {
+    free(snapshot);
+}
+
+long unpackZ80(const uint8_t *packed, long packedLength, uint8_t *bytes, long length) {
+    long in = 0, out = 0;
+    
+    while (out < length) {
+        if (in >= packedLength) return -1;
+        
+        // Every byte up to the next ED is a literal, copied in one go.
+        long available = packedLength - in < length - out ? packedLength - in : length - out;
+        const uint8_t *run = memchr(packed + in, 0xED, (size_t)available);
+        long literals = run ? run - (packed + in) : available;
+        memcpy(bytes + out, packed + in, (size_t)literals);
+        in += literals;
+        out += literals;
+        if (run == NULL) continue;
+        
+        if (in + 1 < packedLength && packed[in + 1] == 0xED) {
+            // ED ED count byte.
+            if (packedLength - in < 4) return -1;
+            long count = packed[in + 2];
+            if (count > length - out) return -1;
+            memset(bytes + out, packed[in + 3], (size_t)count);
+            out += count;
+            in += 4;
+        } else {
+            bytes[out++] = 0xED;
+            in++;
+        }
+    }
+    return in;
+}
+
+long zxSnapshotViewLength(ZXSnapshotView view) {
+    return view == ZXSnapshotView48K ? 3 * ZX_BANK_BYTES : ZX_BANK_COUNT * ZX_BANK_BYTES;
+}
+
+void copyZXSnapshotView(const ZXSnapshot *snapshot, ZXSnapshotView view, void *bytes) {
+    uint8_t *memory = bytes;
+    
+    if (view == ZXSnapshotViewBanks) {
+        memcpy(memory, snapshot->bank, ZX_BANK_COUNT * ZX_BANK_BYTES);
+        return;
+    }
+    
+    memcpy(memory, snapshot->bank[5], ZX_BANK_BYTES);
+    memcpy(memory + ZX_BANK_BYTES, snapshot->bank[2], ZX_BANK_BYTES);
+    memcpy(memory + 2 * ZX_BANK_BYTES, snapshot->bank[snapshot->pagedBank], ZX_BANK_BYTES);
+}
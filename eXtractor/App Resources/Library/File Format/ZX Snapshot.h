@@ -0,0 +1,96 @@
+/*
+Copyright © 2022 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#ifndef ZX_Snapshot_h
+#define ZX_Snapshot_h
+
+#include "common.h"
+
+#define ZX_BANK_BYTES   16384
+#define ZX_BANK_COUNT   8
+#define ZX_Z80_MAX_BYTES    (30 + 2 + 55 + 16 * (3 + ZX_BANK_BYTES))    // Longest header and 16 pages stored whole
+
+/*
+ Memory of a 48K or 128K .SNA or .Z80 snapshot, unpacked into its 16K banks. A 48K
+ machine has the banks 5, 2 and 0 at 0x4000, 0x8000 and 0xC000, a 128K machine pages
+ any bank in at 0xC000 and shows the screen in bank 5, or bank 7 as the shadow screen.
+ */
+
+typedef enum {
+    ZXSnapshotView48K,      // 0x4000 to 0xFFFF as the processor sees it, the screen first
+    ZXSnapshotViewBanks     // Every bank in order, bank n at n * ZX_BANK_BYTES, those not in the snapshot cleared
+} ZXSnapshotView;
+
+typedef struct {
+    uint8_t bank[ZX_BANK_COUNT][ZX_BANK_BYTES];
+    bool present[ZX_BANK_COUNT];
+    bool is128K;
+    int pagedBank;          // At 0xC000
+    bool shadowScreen;      // Showing bank 7 rather than bank 5
+    int border;             // 0 to 7
+} ZXSnapshot;
+
+/* Set up for C function definitions, even when using C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /*
+     A .SNA file has no signature, it is recognised by the length of a 48K or 128K snapshot.
+     */
+    bool isZXSnaFormat(const void *rawData, long unsigned int length);
+    
+    /*
+     A .Z80 file has no signature either, it is recognised by its header and, from version 2
+     on, a chain of memory blocks that ends exactly at the end of the file, so the whole
+     file has to be passed.
+     */
+    bool isZXZ80Format(const void *rawData, long unsigned int length);
+    
+    /*
+     Unpacks a whole .SNA or .Z80 file. Returns NULL and sets errno on failure.
+     */
+    ZXSnapshot *createZXSnapshot(const void *rawData, long unsigned int length);
+    
+    void closeZXSnapshot(ZXSnapshot *snapshot);
+    
+    /*
+     Unpacks the ED ED count byte runs of .Z80 memory until length bytes are written, never
+     reading past the end of the packed data or writing past length. Returns the number of
+     packed bytes used, or -1 when the data runs out or a run overflows.
+     */
+    long unpackZ80(const uint8_t *packed, long packedLength, uint8_t *bytes, long length);
+    
+    long zxSnapshotViewLength(ZXSnapshotView view);
+    
+    /*
+     Copies the memory of the view into the first zxSnapshotViewLength bytes of bytes.
+     */
+    void copyZXSnapshotView(const ZXSnapshot *snapshot, ZXSnapshotView view, void *bytes);
+
+/* Ends C function definitions when using C++ */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZX_Snapshot_h */
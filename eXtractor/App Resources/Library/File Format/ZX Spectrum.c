@@ -22,70 +22,105 @@ THE SOFTWARE.
 
 #include "ZX Spectrum.h"
 
+/*
+ Video data...
+ 
+ Pixels :- address is 010S SRRR CCCX XXXX
+ Attrs  :- address is 0101 10YY YYYX XXXX
+ 
+ S = Section (0-2)
+ C = Cell row within section (0-7)
+ R = Pixel row within cell (0-7)
+ X = X coord (0-31)
+ Y = Y coord (0-23)
+ 
+ ROW = SSCC CRRR
+     = YYYY Y000
+ */
+#define ROW(r)      ((((r) & 0xc0) << 5) | (((r) & 0x07) << 8) | (((r) & 0x38) << 2))
+#define ROW8(r)     ROW(r), ROW(r + 1), ROW(r + 2), ROW(r + 3), ROW(r + 4), ROW(r + 5), ROW(r + 6), ROW(r + 7)
+#define ROW64(r)    ROW8(r), ROW8(r + 8), ROW8(r + 16), ROW8(r + 24), ROW8(r + 32), ROW8(r + 40), ROW8(r + 48), ROW8(r + 56)
+
+// Offset of the bitmap of each row of the screen.
+static const uint16_t rowOffset[ZX_SCREEN_HEIGHT] = { ROW64(0), ROW64(64), ROW64(128) };
+
+/*
+ Index of set and clear bits for each attribute, F B PPP III, see ZX Spectrum.h for
+ the indices of FLASH cells.
+ */
+#define INK(a)      ((a) & 0x80 ? 0x80 | ((a) & 0x40) | ((a) & 0x07) << 3 | ((a) >> 3 & 0x07) : ((a) >> 3 & 0x08) | ((a) & 0x07))
+#define PAPER(a)    ((a) & 0x80 ? 0x80 | ((a) & 0x40) | ((a) & 0x38) | ((a) & 0x07) : ((a) >> 3 & 0x08) | ((a) >> 3 & 0x07))
+#define ATTR4(f, a) f(a), f(a + 1), f(a + 2), f(a + 3)
+#define ATTR16(f, a) ATTR4(f, a), ATTR4(f, a + 4), ATTR4(f, a + 8), ATTR4(f, a + 12)
+#define ATTR64(f, a) ATTR16(f, a), ATTR16(f, a + 16), ATTR16(f, a + 32), ATTR16(f, a + 48)
+#define ATTR256(f)  ATTR64(f, 0), ATTR64(f, 64), ATTR64(f, 128), ATTR64(f, 192)
+
+static const uint8_t inkIndex[256] = { ATTR256(INK) };
+static const uint8_t paperIndex[256] = { ATTR256(PAPER) };
+
+/*
+ Each bitmap byte expanded to 8 masks, 0xff for a set bit, in display order, so a cell
+ row is selected between ink and paper without a branch.
+ */
+#define BIT(b, n)   ((b) & (0x80 >> (n)) ? 0xff : 0x00)
+#define BITS(b)     { BIT(b, 0), BIT(b, 1), BIT(b, 2), BIT(b, 3), BIT(b, 4), BIT(b, 5), BIT(b, 6), BIT(b, 7) }
+#define BYTE4(b)    BITS(b), BITS(b + 1), BITS(b + 2), BITS(b + 3)
+#define BYTE16(b)   BYTE4(b), BYTE4(b + 4), BYTE4(b + 8), BYTE4(b + 12)
+#define BYTE64(b)   BYTE16(b), BYTE16(b + 16), BYTE16(b + 32), BYTE16(b + 48)
+
+static const uint8_t bitMask[256][8] = { BYTE64(0), BYTE64(64), BYTE64(128), BYTE64(192) };
+
 bool isZXSpectrumFormat(const void *rawData, long unsigned int length) {
-    if (length != 6912) { /// A ZX Spectrum Screen file will always be exacly 6912 bytes in length.
+    if (length != ZX_SCREEN_BYTES) { /// A ZX Spectrum Screen file will always be exacly 6912 bytes in length.
         return false;
     }
     
     return true;
 }
 
-void convertZXSpectrumScreenToIndexedColor(const void *rawData) {
-    uint8_t *pixelData = (uint8_t *)rawData;
-    uint8_t buf[49152];
-    
-    //memcpy(ulaPixelData, dest, 6912);
-    
-    for (int r = 0; r < 192; ++r)
-    {
-        
-        /*
-         
-         Video data...
-         
-         Pixels :- address is 010S SRRR CCCX XXXX
-         Attrs  :- address is 0101 10YY YYYX XXXX
-         
-         S = Section (0-2)
-         C = Cell row within section (0-7)
-         R = Pixel row within cell (0-7)
-         X = X coord (0-31)
-         Y = Y coord (0-23)
-         
-         ROW = SSCC CRRR
-         = YYYY Y000
-         
-         */
-        
-        uint16_t p = ((r & 0x0c0) << 5) + ((r & 0x7) << 8) + ((r & 0x38) << 2);
-        uint16_t a = 6144 + ((r & 0xf8) << 2);
-        
-        uint16_t ink,paper;
+void zxScreenToIndices(const uint8_t *bytes, int x, int width, uint8_t *index, long stride) {
+    for (int r = 0; r < ZX_SCREEN_HEIGHT; r++) {
+        const uint8_t *data = bytes + rowOffset[r] + x / 8;
+        const uint8_t *attr = bytes + 6144 + (r >> 3) * 32 + x / 8;
+        uint8_t *row = index + r * stride;
         
-        for (int c = 0; c < 256; c+=8)
-        {
-            uint8_t data = pixelData[p++];
-            uint8_t attr = pixelData[a++];
+        for (int c = 0; c < width; c += 8) {
+            const uint8_t *mask = bitMask[*data++];
+            uint8_t ink = inkIndex[*attr];
+            uint8_t paper = paperIndex[*attr++];
             
-            if (attr & 0b01000000) {
-                ink = attr & 0b00000111 + 8;
-                paper = ((attr & 0b00111000) >> 3) + 8;
-            } else {
-                ink = attr & 0b00000111;
-                paper = (attr & 0b00111000) >> 3;
+            for (int i = 0; i < 8; i++) {
+                row[c + i] = (ink & mask[i]) | (paper & ~mask[i]);
             }
+        }
+    }
+}
+
+void zxScreenToPixelData(const uint8_t *bytes, const uint32_t *colors, int x, int width, uint32_t *pixel, long stride) {
+    for (int r = 0; r < ZX_SCREEN_HEIGHT; r++) {
+        const uint8_t *data = bytes + rowOffset[r] + x / 8;
+        const uint8_t *attr = bytes + 6144 + (r >> 3) * 32 + x / 8;
+        uint32_t *row = pixel + r * stride;
+        
+        for (int c = 0; c < width; c += 8) {
+            const uint8_t *mask = bitMask[*data++];
+            uint32_t ink = colors[inkIndex[*attr]];
+            uint32_t paper = colors[paperIndex[*attr++]];
             
-            for (int i = 0; i < 8; ++i) {
-                buf[c + r * 256 + i] = (data & (0x80 >> i)) ? ink : paper;
+            for (int i = 0; i < 8; i++) {
+                row[c + i] = mask[i] ? ink : paper;
             }
-            
         }
     }
-    
-    memcpy(pixelData, buf, sizeof(buf));
 }
 
-
-
-
-
+void zxScreenColors(const uint32_t *rgb, bool flashInverted, uint32_t *colors) {
+    for (unsigned index = 0; index < 256; index++) {
+        if (index & 0x80) {
+            unsigned bright = index >> 3 & 0x08;
+            colors[index] = rgb[bright | (flashInverted ? index & 0x07 : index >> 3 & 0x07)];
+        } else {
+            colors[index] = rgb[index & 0x0f];
+        }
+    }
+}
@@ -25,7 +25,18 @@ THE SOFTWARE.
 
 #include "common.h"
 
+#define ZX_SCREEN_WIDTH     256
+#define ZX_SCREEN_HEIGHT    192
+#define ZX_SCREEN_BYTES     6912    // 6144 bytes of bitmap, in thirds of interleaved rows, then 768 attributes
 
+/*
+ Screens are decoded straight from the bitmap and attributes, wherever they are stored.
+ 
+ Pixels take palette indices 0 to 15, ink or paper plus 8 when BRIGHT. The pixels of
+ FLASH cells take indices 128 to 255 instead, 1 B S S S O O O, where S is the color
+ the pixel shows normally and O the one it shows while the flash is inverted, so
+ flashing only changes the colors the indices map to, see zxScreenColors.
+ */
 
 /* Set up for C function definitions, even when using C++ */
 #ifdef __cplusplus
@@ -33,7 +44,24 @@ extern "C" {
 #endif
 
     bool isZXSpectrumFormat(const void *rawData, long unsigned int length);
-    void convertZXSpectrumScreenToIndexedColor(const void *rawData);
+    
+    /*
+     Decodes the columns x to x + width, multiples of 8, of every row of the screen
+     into palette indices, addressed as index[row * stride + column - x].
+     */
+    void zxScreenToIndices(const uint8_t *bytes, int x, int width, uint8_t *index, long stride);
+    
+    /*
+     Decodes the columns x to x + width, multiples of 8, of every row of the screen
+     into the pixels of colors, as built by zxScreenColors.
+     */
+    void zxScreenToPixelData(const uint8_t *bytes, const uint32_t *colors, int x, int width, uint32_t *pixel, long stride);
+    
+    /*
+     Fills the 256 entry colors with the pixel of each index from the 16 colors of rgb,
+     FLASH cells with their ink and paper swapped when flashInverted is set.
+     */
+    void zxScreenColors(const uint32_t *rgb, bool flashInverted, uint32_t *colors);
 
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
@@ -22,7 +22,172 @@ THE SOFTWARE.
 
 #include "ZX Tape.h"
 
+#include <errno.h>
+
+#define TZX_HEADER_BYTES 10
+#define ZX_HEADER_BYTES 17     // Type, name, length and two parameters, without flag and checksum
+
+typedef struct {
+    ZXTapeIndex *index;
+    long capacity;
+    uint8_t type;               // Of the last header, until a block takes it
+    char name[11];
+} IndexBuilder;
+
+static long readLittleEndian(const uint8_t *bytes, int count) {
+    long value = 0;
+    for (int i = count - 1; i >= 0; i--) {
+        value = value << 8 | bytes[i];
+    }
+    return value;
+}
+
+static bool isChecksumValid(const uint8_t *data, long length) {
+    uint8_t checksum = 0;
+    for (long i = 0; i < length; i++) {
+        checksum ^= data[i];
+    }
+    return checksum == 0;
+}
+
+static bool appendBlock(IndexBuilder *builder, const ZXTapeBlock *block) {
+    ZXTapeIndex *index = builder->index;
+    
+    if (index->count == builder->capacity) {
+        long grown = builder->capacity ? builder->capacity * 2 : 64;
+        ZXTapeBlock *blocks = realloc(index->blocks, (size_t)grown * sizeof(ZXTapeBlock));
+        if (blocks == NULL) return false;
+        index->blocks = blocks;
+        builder->capacity = grown;
+    }
+    
+    index->blocks[index->count++] = *block;
+    index->viewLength += block->length;
+    return true;
+}
+
+/*
+ Adds the data of a block, data starting at offset in the file. A header names the block
+ after it rather than being indexed, data without a flag byte and checksum is kept whole.
+ */
+static bool addData(IndexBuilder *builder, const uint8_t *file, long offset, long length, uint8_t blockId, bool standard) {
+    const uint8_t *data = file + offset;
+    ZXTapeBlock block = {
+        .offset = offset,
+        .length = length,
+        .viewOffset = builder->index->viewLength,
+        .blockId = blockId,
+        .type = builder->type
+    };
+    
+    if (length >= 2 && (standard || ((data[0] == 0x00 || data[0] == 0xFF) && isChecksumValid(data, length)))) {
+        if (data[0] == 0x00 && length == ZX_HEADER_BYTES + 2) {
+            builder->type = data[1];
+            memcpy(builder->name, data + 2, 10);
+            builder->name[10] = 0;
+            return true;
+        }
+        
+        block.flag = data[0];
+        block.offset = offset + 1;
+        block.length = length - 2;
+    }
+    
+    memcpy(block.name, builder->name, sizeof(block.name));
+    builder->type = 0xFF;
+    builder->name[0] = 0;
+    
+    if (block.length <= 0) return true;
+    return appendBlock(builder, &block);
+}
+
+/*
+ Bytes between the block ID and the data of a block, and the bytes of data, or false when
+ the ID is unknown. Data is only indexed for blocks that hold bytes as loaded.
+ */
+static bool blockLayout(uint8_t blockId, const uint8_t *body, long available, long *headerBytes, long *dataBytes) {
+    // Every field needed to size a block has to be readable.
+    static const uint8_t minimum[256] = {
+        [0x10] = 4, [0x11] = 18, [0x12] = 4, [0x13] = 1, [0x14] = 10, [0x15] = 8,
+        [0x16] = 4, [0x17] = 4, [0x18] = 4, [0x19] = 4, [0x20] = 2, [0x21] = 1,
+        [0x23] = 2, [0x24] = 2, [0x26] = 2, [0x28] = 2, [0x2A] = 4, [0x2B] = 4,
+        [0x30] = 1, [0x31] = 2, [0x32] = 2, [0x33] = 1, [0x34] = 8, [0x35] = 20,
+        [0x40] = 4, [0x5A] = 9
+    };
+    
+    if (blockId == 0x22 || blockId == 0x25 || blockId == 0x27) {
+        // Group end, loop end and return from sequence are the ID alone.
+        *headerBytes = 0;
+        *dataBytes = 0;
+        return true;
+    }
+    
+    long needed = minimum[blockId] ? minimum[blockId] : 4;
+    if (available < needed) return false;
+    
+    *headerBytes = needed;
+    *dataBytes = 0;
+    
+    switch (blockId) {
+        case 0x10: *dataBytes = readLittleEndian(body + 2, 2); break;                   // Standard speed data
+        case 0x11: *dataBytes = readLittleEndian(body + 15, 3); break;                  // Turbo speed data
+        case 0x14: *dataBytes = readLittleEndian(body + 7, 3); break;                   // Pure data
+        case 0x15: *dataBytes = readLittleEndian(body + 5, 3); break;                   // Direct recording
+        case 0x13: *dataBytes = body[0] * 2; break;                                     // Pulse sequence
+        case 0x21: case 0x30: *dataBytes = body[0]; break;                              // Group start, text description
+        case 0x26: *dataBytes = readLittleEndian(body, 2) * 2; break;                   // Call sequence
+        case 0x28: case 0x32: *dataBytes = readLittleEndian(body, 2); break;            // Select, archive info
+        case 0x31: *dataBytes = body[1]; break;                                         // Message
+        case 0x33: *dataBytes = body[0] * 3; break;                                     // Hardware type
+        case 0x35: *dataBytes = readLittleEndian(body + 16, 4); break;                  // Custom info
+        case 0x40: *dataBytes = readLittleEndian(body + 1, 3); break;                   // Snapshot
+        case 0x12: case 0x20: case 0x23: case 0x24: case 0x34: case 0x5A:
+            break;
+            
+        default:
+            // CSW and generalized data, and any block added since, start with the length of the rest.
+            *dataBytes = readLittleEndian(body, 4);
+            break;
+    }
+    return true;
+}
+
+static bool indexTZX(IndexBuilder *builder, const uint8_t *file, long length) {
+    long offset = TZX_HEADER_BYTES;
+    
+    while (offset < length) {
+        uint8_t blockId = file[offset++];
+        long headerBytes, dataBytes;
+        
+        if (blockLayout(blockId, file + offset, length - offset, &headerBytes, &dataBytes) == false) break;
+        if (dataBytes > length - offset - headerBytes) break;
+        
+        if (blockId == 0x10 || blockId == 0x11 || blockId == 0x14) {
+            if (addData(builder, file, offset + headerBytes, dataBytes, blockId, blockId == 0x10) == false) return false;
+        }
+        offset += headerBytes + dataBytes;
+    }
+    return true;
+}
+
+static bool indexTAP(IndexBuilder *builder, const uint8_t *file, long length) {
+    long offset = 0;
+    
+    while (length - offset >= 2) {
+        long dataBytes = readLittleEndian(file + offset, 2);
+        offset += 2;
+        if (dataBytes > length - offset) break;
+        
+        if (addData(builder, file, offset, dataBytes, 0x10, true) == false) return false;
+        offset += dataBytes;
+    }
+    return true;
+}
+
+// MARK: - Public Functions
+
 bool isZXTapeFormat(const void *rawData, long unsigned int length) {
+    if (length < TZX_HEADER_BYTES) return false;
     if (strncmp(rawData, "ZXTape!", 7) != 0) {
         return false;
     }
@@ -30,15 +195,73 @@ bool isZXTapeFormat(const void *rawData, long unsigned int length) {
     return true;
 }
 
+bool isZXTapFormat(const void *rawData, long unsigned int length) {
+    const uint8_t *file = rawData;
+    long offset = 0;
+    
+    while (offset + 2 <= (long)length) {
+        offset = nextZXTapBlock(file + offset, offset, length);
+        if (offset < 0) return false;
+    }
+    return offset > 0 && offset == (long)length;
+}
 
-/*
- if ([url.pathExtension isEqualToString:@"tzx"]) {
-     [self setSize:CGSizeMake(64, 64)];
-     [self setPlaneCount:1];
-     [self setBitsPerPixel:1];
-     [self setTileWithWidthOf:1 andHightOf:1];
-     [self.palette loadWithContentsOfFile:[NSBundle.mainBundle pathForResource:@"ZX Spectrum" ofType:@"act"]];
-     self.alphaPlane = NO;
-     [self setAspectRatio:1.0];
- }
- */
+long nextZXTapBlock(const void *block, long offset, long unsigned int length) {
+    const uint8_t *bytes = block;
+    
+    long dataBytes = readLittleEndian(bytes, 2);
+    if (dataBytes < 2 || dataBytes > (long)length - offset - 2) return -1;
+    
+    // The first block is a header or data, anything else is not a tape.
+    if (offset == 0 && bytes[2] != 0x00 && bytes[2] != 0xFF) return -1;
+    return offset + 2 + dataBytes;
+}
+
+ZXTapeIndex *createZXTapeIndex(const void *rawData, long unsigned int length) {
+    IndexBuilder builder = {.type = 0xFF};
+    
+    builder.index = calloc(1, sizeof(ZXTapeIndex));
+    if (builder.index == NULL) return NULL;
+    
+    bool indexed = isZXTapeFormat(rawData, length) ? indexTZX(&builder, rawData, (long)length) : indexTAP(&builder, rawData, (long)length);
+    if (indexed == false) {
+        closeZXTapeIndex(builder.index);
+        errno = ENOMEM;
+        return NULL;
+    }
+    return builder.index;
+}
+
+void closeZXTapeIndex(ZXTapeIndex *index) {
+    if (index == NULL) return;
+    
+    free(index->blocks);
+    free(index);
+}
+
+long zxTapeBlockAtViewOffset(const ZXTapeIndex *index, long offset) {
+    long low = 0, high = index->count - 1;
+    
+    while (low <= high) {
+        long middle = (low + high) / 2;
+        const ZXTapeBlock *block = &index->blocks[middle];
+        
+        if (offset < block->viewOffset) {
+            high = middle - 1;
+        } else if (offset >= block->viewOffset + block->length) {
+            low = middle + 1;
+        } else {
+            return middle;
+        }
+    }
+    return -1;
+}
+
+void compactZXTape(const ZXTapeIndex *index, void *rawData) {
+    uint8_t *bytes = rawData;
+    
+    // A payload never moves past the start of its own data, so earlier moves never overwrite later payloads.
+    for (long i = 0; i < index->count; i++) {
+        memmove(bytes + index->blocks[i].viewOffset, bytes + index->blocks[i].offset, index->blocks[i].length);
+    }
+}
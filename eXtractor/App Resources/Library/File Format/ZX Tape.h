@@ -25,12 +25,67 @@ THE SOFTWARE.
 
 #include "common.h"
 
+/*
+ Index of the data blocks of a .TZX or .TAP tape image, built by walking the block chain
+ in place. Standard speed blocks, and turbo speed and pure data blocks that carry a flag
+ byte and a valid checksum, are indexed without them, every other block is skipped over by
+ its length. The payloads of the data blocks can be moved together to make a view of just
+ the data, with no tape headers, checksums or timing information between them.
+ */
+
+typedef struct {
+    long offset;            // Payload in the tape image
+    long length;
+    long viewOffset;        // Payload in the view of every payload one after the other
+    uint8_t blockId;        // TZX block ID, 0x10 for the blocks of a .TAP file
+    uint8_t flag;           // First byte of the block on tape, 0xFF for data, 0 when it has none
+    uint8_t type;           // From the header before it, 0 program, 1 number array, 2 character array, 3 bytes, 0xFF when not named
+    char name[11];          // From the header before it, empty when not named
+} ZXTapeBlock;
+
+typedef struct {
+    ZXTapeBlock *blocks;    // In the order they are on the tape
+    long count;
+    long viewLength;
+} ZXTapeIndex;
+
 /* Set up for C function definitions, even when using C++ */
 #ifdef __cplusplus
 extern "C" {
 #endif
 
     bool isZXTapeFormat(const void *rawData, long unsigned int length);
+    
+    /*
+     A .TAP file has no signature, it is recognised by a chain of length prefixed blocks
+     that ends exactly at the end of the file, so the whole file has to be passed.
+     */
+    bool isZXTapFormat(const void *rawData, long unsigned int length);
+    
+    /*
+     Offset of the .TAP block after the one at offset, or -1 when the block does not fit in the
+     length of the file. Only the first 3 bytes of the block are read, and only 2 when it does
+     not fit, so the chain can be walked without reading the whole file.
+     */
+    long nextZXTapBlock(const void *block, long offset, long unsigned int length);
+    
+    /*
+     Indexes the data blocks of a whole .TZX or .TAP file, the index stops at the first
+     damaged or unknown block. Returns NULL and sets errno on failure.
+     */
+    ZXTapeIndex *createZXTapeIndex(const void *rawData, long unsigned int length);
+    
+    void closeZXTapeIndex(ZXTapeIndex *index);
+    
+    /*
+     Returns the block whose payload holds the byte at offset in the view, or -1.
+     */
+    long zxTapeBlockAtViewOffset(const ZXTapeIndex *index, long offset);
+    
+    /*
+     Moves every payload to its view offset, leaving the view in the first viewLength bytes of rawData.
+     */
+    void compactZXTape(const ZXTapeIndex *index, void *rawData);
 
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
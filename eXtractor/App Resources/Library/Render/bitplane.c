@@ -0,0 +1,339 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "bitplane.h"
+
+#include <stdatomic.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BITPLANE_X86
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define BITPLANE_NEON
+#endif
+
+/*
+ Each plane word is broadcast to all 16 bytes, as [lo hi lo hi ...] in memory.
+ Byte j tests bit (7 - j / 2) of its byte, so odd bytes give pixels 0-7 and even
+ bytes give pixels 8-15, the bytes are put back in pixel order once all planes
+ have been merged.
+ */
+#if defined(BITPLANE_X86) || defined(BITPLANE_NEON)
+static const uint8_t bitMask[16] = {
+    0x80, 0x80, 0x40, 0x40, 0x20, 0x20, 0x10, 0x10,
+    0x08, 0x08, 0x04, 0x04, 0x02, 0x02, 0x01, 0x01
+};
+#endif
+
+// MARK: - Scalar
+
+/*
+ Spreads the 8 bits of a byte into 8 bytes of 0 or 1, leftmost pixel first in memory.
+ */
+static uint64_t spread(uint64_t byte) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    uint64_t bits = (byte * 0x0101010101010101ULL) & 0x8040201008040201ULL;
+#else
+    uint64_t bits = (byte * 0x0101010101010101ULL) & 0x0102040810204080ULL;
+#endif
+    return ((bits + 0x7F7F7F7F7F7F7F7FULL) >> 7) & 0x0101010101010101ULL;
+}
+
+static void bitplanesToIndicesScalar(const uint16_t (*planes)[8], int groups, int planeCount, uint8_t *indices) {
+    for (int g = 0; g < groups; g++) {
+        uint64_t left = 0, right = 0;
+        
+        for (int p = 0; p < planeCount; p++) {
+            left |= spread(planes[g][p] >> 8) << p;
+            right |= spread(planes[g][p] & 0xFF) << p;
+        }
+        
+        memcpy(indices, &left, 8);
+        memcpy(indices + 8, &right, 8);
+        indices += 16;
+    }
+}
+
+/*
+ Pixels from start to count, the alpha bit of each turned into a mask rather than a branch.
+ */
+static void indicesToPixelsWithAlphaScalar(const uint8_t *indices, const uint16_t *alpha, const uint32_t *rgb, uint32_t *pixel, int start, int count) {
+    for (int i = start; i < count; i++) {
+        uint32_t keep = (uint32_t)(alpha[i >> 4] >> (15 - (i & 15)) & 1) - 1;
+        pixel[i] = rgb[indices[i]] & keep;
+    }
+}
+
+static uint64_t sumOfAbsoluteDifferencesScalar(const uint8_t *a, const uint8_t *b, long count) {
+    uint64_t sum = 0;
+    
+    for (long i = 0; i < count; i++) {
+        sum += a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+    }
+    return sum;
+}
+
+// MARK: - SSE2 & AVX2
+
+#ifdef BITPLANE_X86
+#ifdef __SSE2__
+static void bitplanesToIndicesSSE2(const uint16_t (*planes)[8], int groups, int planeCount, uint8_t *indices) {
+    const __m128i mask = _mm_loadu_si128((const __m128i *)bitMask);
+    const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+    
+    for (int g = 0; g < groups; g++) {
+        __m128i merged = _mm_setzero_si128();
+        
+        for (int p = 0; p < planeCount; p++) {
+            __m128i plane = _mm_and_si128(_mm_set1_epi16((short)planes[g][p]), mask);
+            plane = _mm_cmpeq_epi8(plane, mask);
+            merged = _mm_or_si128(merged, _mm_and_si128(plane, _mm_set1_epi8((char)(1 << p))));
+        }
+        
+        merged = _mm_packus_epi16(_mm_srli_epi16(merged, 8), _mm_and_si128(merged, lowBytes));
+        _mm_storeu_si128((__m128i *)indices, merged);
+        indices += 16;
+    }
+}
+
+static uint64_t sumOfAbsoluteDifferencesSSE2(const uint8_t *a, const uint8_t *b, long count) {
+    __m128i sum = _mm_setzero_si128();
+    uint64_t lanes[2];
+    long i = 0;
+    
+    for (; i + 16 <= count; i += 16) {
+        __m128i sad = _mm_sad_epu8(_mm_loadu_si128((const __m128i *)(a + i)), _mm_loadu_si128((const __m128i *)(b + i)));
+        sum = _mm_add_epi64(sum, sad);
+    }
+    
+    _mm_storeu_si128((__m128i *)lanes, sum);
+    return lanes[0] + lanes[1] + sumOfAbsoluteDifferencesScalar(a + i, b + i, count - i);
+}
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BITPLANE_AVX2
+
+__attribute__((target("avx2")))
+static void bitplanesToIndicesAVX2(const uint16_t (*planes)[8], int groups, int planeCount, uint8_t *indices) {
+    const __m256i mask = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)bitMask));
+    const __m256i lowBytes = _mm256_set1_epi16(0x00FF);
+    int g = 0;
+    
+    // Two groups at a time, one per 128-bit lane.
+    for (; g + 2 <= groups; g += 2) {
+        __m256i merged = _mm256_setzero_si256();
+        
+        for (int p = 0; p < planeCount; p++) {
+            __m256i plane = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_set1_epi16((short)planes[g][p])), _mm_set1_epi16((short)planes[g + 1][p]), 1);
+            plane = _mm256_cmpeq_epi8(_mm256_and_si256(plane, mask), mask);
+            merged = _mm256_or_si256(merged, _mm256_and_si256(plane, _mm256_set1_epi8((char)(1 << p))));
+        }
+        
+        merged = _mm256_packus_epi16(_mm256_srli_epi16(merged, 8), _mm256_and_si256(merged, lowBytes));
+        _mm256_storeu_si256((__m256i *)indices, merged);
+        indices += 32;
+    }
+    
+    if (g < groups) {
+        bitplanesToIndicesScalar(planes + g, groups - g, planeCount, indices);
+    }
+}
+
+__attribute__((target("avx2")))
+static void indicesToPixelsAVX2(const uint8_t *indices, const uint32_t *rgb, uint32_t *pixel, int count) {
+    int i = 0;
+    
+    for (; i + 8 <= count; i += 8) {
+        __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(indices + i)));
+        _mm256_storeu_si256((__m256i *)(pixel + i), _mm256_i32gather_epi32((const int *)rgb, index, 4));
+    }
+    
+    for (; i < count; i++) {
+        pixel[i] = rgb[indices[i]];
+    }
+}
+
+/*
+ The alpha bits of 8 pixels are broadcast to every lane, lane k tests bit 7 - k and
+ becomes a mask of all ones where the pixel is kept.
+ */
+__attribute__((target("avx2")))
+static void indicesToPixelsWithAlphaAVX2(const uint8_t *indices, const uint16_t *alpha, const uint32_t *rgb, uint32_t *pixel, int count) {
+    const __m256i bits = _mm256_setr_epi32(0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+    int i = 0;
+    
+    for (; i + 8 <= count; i += 8) {
+        int byte = (i & 8) ? alpha[i >> 4] & 0xFF : alpha[i >> 4] >> 8;
+        __m256i keep = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(byte), bits), _mm256_setzero_si256());
+        __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(indices + i)));
+        __m256i color = _mm256_i32gather_epi32((const int *)rgb, index, 4);
+        _mm256_storeu_si256((__m256i *)(pixel + i), _mm256_and_si256(color, keep));
+    }
+    
+    indicesToPixelsWithAlphaScalar(indices, alpha, rgb, pixel, i, count);
+}
+
+__attribute__((target("avx2")))
+static void wordsToPixelsAVX2(const uint8_t *bytes, const uint32_t *table, uint32_t *pixel, int count) {
+    int i = 0;
+    
+    for (; i + 8 <= count; i += 8) {
+        __m256i index = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(bytes + i * 2)));
+        _mm256_storeu_si256((__m256i *)(pixel + i), _mm256_i32gather_epi32((const int *)table, index, 4));
+    }
+    
+    for (; i < count; i++) {
+        pixel[i] = table[bytes[i * 2] | bytes[i * 2 + 1] << 8];
+    }
+}
+
+__attribute__((target("avx2")))
+static uint64_t sumOfAbsoluteDifferencesAVX2(const uint8_t *a, const uint8_t *b, long count) {
+    __m256i sum = _mm256_setzero_si256();
+    uint64_t lanes[4];
+    long i = 0;
+    
+    for (; i + 32 <= count; i += 32) {
+        __m256i sad = _mm256_sad_epu8(_mm256_loadu_si256((const __m256i *)(a + i)), _mm256_loadu_si256((const __m256i *)(b + i)));
+        sum = _mm256_add_epi64(sum, sad);
+    }
+    
+    _mm256_storeu_si256((__m256i *)lanes, sum);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sumOfAbsoluteDifferencesScalar(a + i, b + i, count - i);
+}
+
+// Kernels run on several threads at once, every one of them may be first to ask.
+static bool hasAVX2(void) {
+    static atomic_int supported = -1;
+    int value = atomic_load_explicit(&supported, memory_order_relaxed);
+    if (value < 0) {
+        value = __builtin_cpu_supports("avx2") ? 1 : 0;
+        atomic_store_explicit(&supported, value, memory_order_relaxed);
+    }
+    return value == 1;
+}
+#endif
+#endif
+
+// MARK: - NEON
+
+#ifdef BITPLANE_NEON
+static void bitplanesToIndicesNEON(const uint16_t (*planes)[8], int groups, int planeCount, uint8_t *indices) {
+    const uint8x16_t mask = vld1q_u8(bitMask);
+    
+    for (int g = 0; g < groups; g++) {
+        uint8x16_t merged = vdupq_n_u8(0);
+        
+        for (int p = 0; p < planeCount; p++) {
+            uint8x16_t plane = vreinterpretq_u8_u16(vdupq_n_u16(planes[g][p]));
+            merged = vorrq_u8(merged, vandq_u8(vtstq_u8(plane, mask), vdupq_n_u8((uint8_t)(1 << p))));
+        }
+        
+        uint16x8_t words = vreinterpretq_u16_u8(merged);
+        vst1q_u8(indices, vcombine_u8(vshrn_n_u16(words, 8), vmovn_u16(words)));
+        indices += 16;
+    }
+}
+
+static uint64_t sumOfAbsoluteDifferencesNEON(const uint8_t *a, const uint8_t *b, long count) {
+    uint64x2_t sum = vdupq_n_u64(0);
+    long i = 0;
+    
+    for (; i + 16 <= count; i += 16) {
+        uint16x8_t pairs = vpaddlq_u8(vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i)));
+        sum = vaddq_u64(sum, vpaddlq_u32(vpaddlq_u16(pairs)));
+    }
+    
+    return vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1) + sumOfAbsoluteDifferencesScalar(a + i, b + i, count - i);
+}
+#endif
+
+// MARK: - Public Functions
+
+void bitplanesToIndices(const uint16_t (*planes)[8], int groups, int planeCount, uint8_t *indices) {
+#ifdef BITPLANE_AVX2
+    if (hasAVX2()) {
+        bitplanesToIndicesAVX2(planes, groups, planeCount, indices);
+        return;
+    }
+#endif
+#if defined(BITPLANE_X86) && defined(__SSE2__)
+    bitplanesToIndicesSSE2(planes, groups, planeCount, indices);
+#elif defined(BITPLANE_NEON)
+    bitplanesToIndicesNEON(planes, groups, planeCount, indices);
+#else
+    bitplanesToIndicesScalar(planes, groups, planeCount, indices);
+#endif
+}
+
+void indicesToPixels(const uint8_t *indices, const uint32_t *rgb, uint32_t *pixel, int count) {
+#ifdef BITPLANE_AVX2
+    if (hasAVX2()) {
+        indicesToPixelsAVX2(indices, rgb, pixel, count);
+        return;
+    }
+#endif
+    for (int i = 0; i < count; i++) {
+        pixel[i] = rgb[indices[i]];
+    }
+}
+
+void indicesToPixelsWithAlpha(const uint8_t *indices, const uint16_t *alpha, const uint32_t *rgb, uint32_t *pixel, int count) {
+#ifdef BITPLANE_AVX2
+    if (hasAVX2()) {
+        indicesToPixelsWithAlphaAVX2(indices, alpha, rgb, pixel, count);
+        return;
+    }
+#endif
+    indicesToPixelsWithAlphaScalar(indices, alpha, rgb, pixel, 0, count);
+}
+
+void wordsToPixels(const uint8_t *bytes, const uint32_t *table, uint32_t *pixel, int count) {
+#ifdef BITPLANE_AVX2
+    if (hasAVX2()) {
+        wordsToPixelsAVX2(bytes, table, pixel, count);
+        return;
+    }
+#endif
+    for (int i = 0; i < count; i++) {
+        pixel[i] = table[bytes[i * 2] | bytes[i * 2 + 1] << 8];
+    }
+}
+
+uint64_t sumOfAbsoluteDifferences(const uint8_t *a, const uint8_t *b, long count) {
+#ifdef BITPLANE_AVX2
+    if (hasAVX2()) {
+        return sumOfAbsoluteDifferencesAVX2(a, b, count);
+    }
+#endif
+#if defined(BITPLANE_X86) && defined(__SSE2__)
+    return sumOfAbsoluteDifferencesSSE2(a, b, count);
+#elif defined(BITPLANE_NEON)
+    return sumOfAbsoluteDifferencesNEON(a, b, count);
+#else
+    return sumOfAbsoluteDifferencesScalar(a, b, count);
+#endif
+}
@@ -0,0 +1,78 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef bitplane_h
+#define bitplane_h
+
+#include "common.h"
+
+/* Set up for C function definitions, even when using C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /*
+     Converts groups of 16 pixels stored as bitplanes into 8-bit chunky color indices.
+     
+     Uses a merge network of byte masks, with AVX2, SSE2 or NEON when available and a
+     64-bit SWAR fallback otherwise.
+     
+     Parameters
+     planes
+     8 words per group, word p holds plane p with the leftmost pixel in bit 15.
+     groups
+     Number of 16 pixel groups.
+     planeCount
+     Number of planes used, 1 to 8.
+     indices
+     Receives 16 indices per group.
+     */
+    void bitplanesToIndices(const uint16_t (*planes)[8], int groups, int planeCount, uint8_t *indices);
+    
+    /*
+     Maps color indices to pixels, pixel[i] = rgb[indices[i]].
+     */
+    void indicesToPixels(const uint8_t *indices, const uint32_t *rgb, uint32_t *pixel, int count);
+    
+    /*
+     Maps color indices to pixels as indicesToPixels does, clearing every pixel whose bit is
+     set in alpha, one word per 16 pixels with the leftmost pixel in bit 15.
+     */
+    void indicesToPixelsWithAlpha(const uint8_t *indices, const uint16_t *alpha, const uint32_t *rgb, uint32_t *pixel, int count);
+    
+    /*
+     Maps 16-bit words, read from bytes in little-endian order, to pixels through a
+     65536 entry table, pixel[i] = table[word[i]].
+     */
+    void wordsToPixels(const uint8_t *bytes, const uint32_t *table, uint32_t *pixel, int count);
+    
+    /*
+     Sum of |a[i] - b[i]| over count bytes, the two ranges may overlap.
+     */
+    uint64_t sumOfAbsoluteDifferences(const uint8_t *a, const uint8_t *b, long count);
+
+/* Ends C function definitions when using C++ */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* bitplane_h */
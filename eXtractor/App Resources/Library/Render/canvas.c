@@ -0,0 +1,604 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "canvas.h"
+#include "parallel.h"
+#include "bitplane.h"
+#include "trace.h"
+
+#include <errno.h>
+#include <limits.h>
+
+#define TILE_SIZE 128           // Rounded down to whole blocks of the layout
+#define LAYOUT_COUNT 16         // Layouts whose tiles are kept at the same time
+
+typedef struct CanvasTile {
+    struct CanvasTile *next;    // Next tile in the same bucket
+    uint64_t layout;            // Identifier of the layout the tile was decoded for
+    long column;
+    long row;
+    uint64_t lastUse;           // Draw the tile was last part of
+    uint64_t colorKey;          // Colors the pixels were mapped, or decoded, with
+    bool valid;
+    size_t count;               // Pixels the buffers hold
+    uint32_t *pixel;
+    uint8_t *index;             // Only used by indexed geometries
+} CanvasTile;
+
+typedef struct {
+    uint64_t identifier;        // 0 when the entry is unused
+    RenderGeometry geometry;
+    long phase;                 // Offset of the first row of the layout
+    uint64_t lastUse;
+} CanvasLayout;
+
+struct RenderCanvas {
+    CanvasTile **tiles;
+    int tileCount;
+    int tileCapacity;
+    CanvasTile **buckets;       // Valid tiles by layout, column and row
+    int bucketCount;
+    CanvasTile **visible;
+    int visibleCapacity;
+    
+    size_t budget;
+    size_t bytes;
+    unsigned long hits;
+    unsigned long misses;
+    
+    CanvasLayout layouts[LAYOUT_COUNT];
+    uint64_t layout;            // Identifier of the layout of the last draw
+    uint64_t nextIdentifier;
+    int tileWidth;
+    int tileHeight;
+    
+    uint64_t clock;
+    bool hasColors;
+    unsigned long paletteStamp;
+    bool alphaPlane;
+    bool flashInverted;
+    uint64_t colorKey;
+    uint32_t colors[256];
+};
+
+/*
+ Tiles to decode or color during a draw, along with the source bytes of the rows of
+ layout they were taken from.
+ */
+typedef struct {
+    RenderCanvas *canvas;
+    const RenderPalette *palette;
+    const RenderGeometry *band;
+    const uint8_t *bytes;
+    long bandRow;
+    CanvasTile **tiles;
+    bool *decode;
+} CanvasWork;
+
+// MARK: - Private Functions
+
+static bool isMasked(const RenderGeometry *geometry) {
+    return geometry->maskPlane && geometry->planeCount > 1 && geometry->layout == RenderLayoutLinear;
+}
+
+/*
+ Tiles stay valid as long as the bytes of each row are. The height only matters to a
+ masked image, as its mask plane follows the color planes of every row, and the alpha
+ channel of packed indices, like the flash of ZX screens, only changes their colors.
+ */
+static bool isSameLayout(const RenderGeometry *a, const RenderGeometry *b) {
+    if (a->layout != b->layout) return false;
+    if (a->width != b->width || a->bitsPerPixel != b->bitsPerPixel || a->planeCount != b->planeCount) return false;
+    if (a->maskPlane != b->maskPlane || a->bigEndian != b->bigEndian || a->pixelFormat != b->pixelFormat) return false;
+    if (a->tileWidth != b->tileWidth || a->tileHeight != b->tileHeight || a->padding != b->padding) return false;
+    if (isMasked(a) && a->height != b->height) return false;
+    if ((a->planeCount > 1 || a->bitsPerPixel > 8) && a->alphaPlane != b->alphaPlane) return false;
+    return true;
+}
+
+// FNV-1a, continuing from hash.
+static uint64_t hashBytes(uint64_t hash, const void *bytes, size_t length) {
+    const uint8_t *byte = bytes;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ byte[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static size_t tileBytes(const CanvasTile *tile) {
+    return tile->count * sizeof(uint32_t) + (tile->index ? tile->count : 0);
+}
+
+static CanvasTile **bucketOf(const RenderCanvas *canvas, uint64_t layout, long column, long row) {
+    uint64_t hash = layout * 0x9e3779b97f4a7c15ULL ^ (uint64_t)column * 0xc2b2ae3d27d4eb4fULL ^ (uint64_t)row * 0x165667b19e3779f9ULL;
+    return &canvas->buckets[(hash >> 32) & (uint64_t)(canvas->bucketCount - 1)];
+}
+
+static void linkTile(RenderCanvas *canvas, CanvasTile *tile) {
+    CanvasTile **bucket = bucketOf(canvas, tile->layout, tile->column, tile->row);
+    tile->next = *bucket;
+    *bucket = tile;
+    tile->valid = true;
+}
+
+static void unlinkTile(RenderCanvas *canvas, CanvasTile *tile) {
+    if (tile->valid == false) return;
+    
+    CanvasTile **link = bucketOf(canvas, tile->layout, tile->column, tile->row);
+    while (*link != tile) link = &(*link)->next;
+    *link = tile->next;
+    tile->next = NULL;
+    tile->valid = false;
+}
+
+static CanvasTile *findTile(const RenderCanvas *canvas, uint64_t layout, long column, long row) {
+    for (CanvasTile *tile = *bucketOf(canvas, layout, column, row); tile; tile = tile->next) {
+        if (tile->layout == layout && tile->column == column && tile->row == row) return tile;
+    }
+    return NULL;
+}
+
+// Keeps about one tile per bucket, failing to grow only makes the buckets longer.
+static void growBuckets(RenderCanvas *canvas) {
+    if (canvas->tileCount <= canvas->bucketCount) return;
+    
+    CanvasTile **buckets = calloc((size_t)canvas->bucketCount * 2, sizeof(CanvasTile *));
+    if (buckets == NULL) return;
+    
+    free(canvas->buckets);
+    canvas->buckets = buckets;
+    canvas->bucketCount *= 2;
+    
+    for (int i = 0; i < canvas->tileCount; i++) {
+        CanvasTile *tile = canvas->tiles[i];
+        if (tile->valid) linkTile(canvas, tile);
+    }
+}
+
+static void releaseBuffers(RenderCanvas *canvas, CanvasTile *tile) {
+    canvas->bytes -= tileBytes(tile);
+    free(tile->pixel);
+    free(tile->index);
+    tile->pixel = NULL;
+    tile->index = NULL;
+    tile->count = 0;
+}
+
+// An unused tile, else the least recently drawn one not needed by the current draw.
+static CanvasTile *reuseTile(const RenderCanvas *canvas) {
+    CanvasTile *oldest = NULL;
+    
+    for (int i = 0; i < canvas->tileCount; i++) {
+        CanvasTile *tile = canvas->tiles[i];
+        if (tile->lastUse == canvas->clock) continue;
+        if (tile->valid == false) return tile;
+        if (oldest == NULL || tile->lastUse < oldest->lastUse) oldest = tile;
+    }
+    return oldest;
+}
+
+static CanvasTile *newTile(RenderCanvas *canvas) {
+    if (canvas->tileCount == canvas->tileCapacity) {
+        int capacity = canvas->tileCapacity ? canvas->tileCapacity * 2 : 64;
+        CanvasTile **tiles = realloc(canvas->tiles, (size_t)capacity * sizeof(CanvasTile *));
+        if (tiles == NULL) return NULL;
+        canvas->tiles = tiles;
+        canvas->tileCapacity = capacity;
+    }
+    
+    CanvasTile *tile = calloc(1, sizeof(CanvasTile));
+    if (tile == NULL) return NULL;
+    
+    canvas->tiles[canvas->tileCount++] = tile;
+    growBuckets(canvas);
+    return tile;
+}
+
+/*
+ A tile with room for count pixels, and their indices when indexed. A new one while
+ the budget allows, else the least recently drawn tile gives up its pixels. Tiles of
+ the current draw are never taken, so a view larger than the budget is still drawn.
+ */
+static CanvasTile *acquireTile(RenderCanvas *canvas, size_t count, bool indexed) {
+    CanvasTile *tile = reuseTile(canvas);
+    
+    if (tile == NULL || (tile->valid && canvas->bytes + count * (sizeof(uint32_t) + indexed) <= canvas->budget)) {
+        tile = newTile(canvas);
+        if (tile == NULL) return NULL;
+    }
+    
+    unlinkTile(canvas, tile);
+    if (tile->count < count || (indexed && tile->index == NULL)) {
+        releaseBuffers(canvas, tile);
+        tile->pixel = malloc(count * sizeof(uint32_t));
+        tile->index = indexed ? malloc(count) : NULL;
+        if (tile->pixel == NULL || (indexed && tile->index == NULL)) {
+            free(tile->pixel);
+            free(tile->index);
+            tile->pixel = NULL;
+            tile->index = NULL;
+            return NULL;
+        }
+        tile->count = count;
+        canvas->bytes += tileBytes(tile);
+    }
+    return tile;
+}
+
+// Frees the pixels of the least recently drawn tiles, unused ones first, until within the budget.
+static void trimTiles(RenderCanvas *canvas) {
+    while (canvas->bytes > canvas->budget) {
+        CanvasTile *oldest = NULL;
+        
+        for (int i = 0; i < canvas->tileCount; i++) {
+            CanvasTile *tile = canvas->tiles[i];
+            if (tile->lastUse == canvas->clock || tile->count == 0) continue;
+            if (oldest == NULL || (oldest->valid && tile->valid == false) ||
+                (oldest->valid == tile->valid && tile->lastUse < oldest->lastUse)) oldest = tile;
+        }
+        if (oldest == NULL) return;
+        
+        unlinkTile(canvas, oldest);
+        releaseBuffers(canvas, oldest);
+    }
+}
+
+/*
+ The layout of the geometry and phase, the least recently drawn one making way for it
+ when it is new. Tiles are kept for every layout in the list, so going back to an offset
+ or geometry seen recently finds its tiles still decoded.
+ */
+static CanvasLayout *useLayout(RenderCanvas *canvas, const RenderGeometry *geometry, long phase) {
+    CanvasLayout *oldest = NULL;
+    
+    for (int i = 0; i < LAYOUT_COUNT; i++) {
+        CanvasLayout *layout = &canvas->layouts[i];
+        if (layout->identifier && layout->phase == phase && isSameLayout(&layout->geometry, geometry)) return layout;
+        if (oldest == NULL || layout->lastUse < oldest->lastUse) oldest = layout;
+    }
+    
+    if (oldest->identifier) {
+        for (int i = 0; i < canvas->tileCount; i++) {
+            CanvasTile *tile = canvas->tiles[i];
+            if (tile->layout == oldest->identifier) unlinkTile(canvas, tile);
+        }
+    }
+    
+    oldest->identifier = ++canvas->nextIdentifier;
+    oldest->geometry = *geometry;
+    oldest->phase = phase;
+    return oldest;
+}
+
+static void setLayout(RenderCanvas *canvas, CanvasLayout *layout) {
+    int w, h;
+    regionAlignment(&layout->geometry, &w, &h);
+    
+    int tileWidth = TILE_SIZE / w * w;
+    int tileHeight = TILE_SIZE / h * h;
+    if (tileWidth < w) tileWidth = w;
+    if (tileHeight < h) tileHeight = h;
+    
+    canvas->tileWidth = tileWidth;
+    canvas->tileHeight = tileHeight;
+    canvas->layout = layout->identifier;
+    canvas->hasColors = false;
+}
+
+static void colorTile(const RenderCanvas *canvas, CanvasTile *tile) {
+    for (int r = 0; r < canvas->tileHeight; r++) {
+        indicesToPixels(tile->index + r * canvas->tileWidth, canvas->colors, tile->pixel + r * canvas->tileWidth, canvas->tileWidth);
+    }
+    tile->colorKey = canvas->colorKey;
+}
+
+static void workOnTile(void *context, size_t index) {
+    const CanvasWork *work = context;
+    RenderCanvas *canvas = work->canvas;
+    CanvasTile *tile = work->tiles[index];
+    size_t count = (size_t)canvas->tileWidth * canvas->tileHeight;
+    
+    if (work->decode[index] == false) {
+        colorTile(canvas, tile);
+        return;
+    }
+    
+    int x = (int)(tile->column * canvas->tileWidth);
+    int y = (int)(tile->row * canvas->tileHeight - work->bandRow);
+    
+    if (isIndexedGeometry(work->band)) {
+        memset(tile->index, 0, count);
+        renderRegionToIndices(work->band, work->bytes, x, y, canvas->tileWidth, canvas->tileHeight, tile->index, canvas->tileWidth);
+        colorTile(canvas, tile);
+    } else {
+        memset(tile->pixel, 0, count * sizeof(uint32_t));
+        renderRegionToPixelData(work->band, work->palette, NULL, work->bytes, x, y, canvas->tileWidth, canvas->tileHeight, tile->pixel, canvas->tileWidth);
+        tile->colorKey = canvas->colorKey;
+    }
+}
+
+static void clearRectangle(uint32_t *pixel, long stride, long x, long y, long width, long height) {
+    if (width < 1 || height < 1) return;
+    for (long row = y; row < y + height; row++) {
+        memset(pixel + row * stride + x, 0, (size_t)width * sizeof(uint32_t));
+    }
+}
+
+// MARK: - Public Functions
+
+RenderCanvas *createCanvas(size_t budget) {
+    RenderCanvas *canvas = calloc(1, sizeof(RenderCanvas));
+    if (canvas == NULL) return NULL;
+    
+    canvas->bucketCount = 256;
+    canvas->buckets = calloc(canvas->bucketCount, sizeof(CanvasTile *));
+    if (canvas->buckets == NULL) {
+        closeCanvas(canvas);
+        return NULL;
+    }
+    
+    canvas->budget = budget;
+    return canvas;
+}
+
+void closeCanvas(RenderCanvas *canvas) {
+    if (canvas == NULL) return;
+    
+    for (int i = 0; i < canvas->tileCount; i++) {
+        free(canvas->tiles[i]->pixel);
+        free(canvas->tiles[i]->index);
+        free(canvas->tiles[i]);
+    }
+    free(canvas->tiles);
+    free(canvas->buckets);
+    free(canvas->visible);
+    free(canvas);
+}
+
+void invalidateCanvas(RenderCanvas *canvas) {
+    for (int i = 0; i < canvas->tileCount; i++) {
+        canvas->tiles[i]->valid = false;
+        canvas->tiles[i]->next = NULL;
+    }
+    memset(canvas->buckets, 0, (size_t)canvas->bucketCount * sizeof(CanvasTile *));
+}
+
+void setCanvasBudget(RenderCanvas *canvas, size_t budget) {
+    canvas->budget = budget;
+    trimTiles(canvas);
+}
+
+void canvasStatistics(const RenderCanvas *canvas, RenderCanvasStatistics *statistics) {
+    statistics->hits = canvas->hits;
+    statistics->misses = canvas->misses;
+    statistics->bytes = canvas->bytes;
+    statistics->tiles = 0;
+    for (int i = 0; i < canvas->tileCount; i++) {
+        if (canvas->tiles[i]->valid) statistics->tiles++;
+    }
+}
+
+void drawCanvas(RenderCanvas *canvas, DataSource *source, long offset, const RenderGeometry *geometry, const RenderPalette *palette, unsigned long paletteStamp, int x, int y, int width, int height, uint32_t *pixel, long stride) {
+    int w, h;
+    int areaWidth = width;
+    int areaHeight = height;
+    
+    if (isValidGeometry(geometry) == false || offset < 0) {
+        clearRectangle(pixel, stride, 0, 0, areaWidth, areaHeight);
+        return;
+    }
+    regionAlignment(geometry, &w, &h);
+    
+    /*
+     Rows of the layout are counted in whole rows of blocks from the first one in the data
+     at or before the offset, a masked image can only be decoded as a whole.
+     */
+    RenderGeometry strip = *geometry;
+    strip.height = h;
+    long bytesPerStrip = isMasked(geometry) ? bytesPerImage(geometry) : bytesPerImage(&strip);
+    long phase = isMasked(geometry) ? offset : offset % bytesPerStrip;
+    long firstRow = isMasked(geometry) ? 0 : offset / bytesPerStrip * h;
+    long rows = isMasked(geometry) ? geometry->height : (dataSourceLength(source) - phase) / bytesPerStrip * h;
+    
+    CanvasLayout *layout = useLayout(canvas, geometry, phase);
+    if (layout->identifier != canvas->layout) setLayout(canvas, layout);
+    
+    /*
+     Indexed tiles are colored again when the colors differ from those they were mapped
+     with, other tiles that take their colors from the palette are decoded again.
+     */
+    bool indexed = isIndexedGeometry(geometry);
+    if (canvas->hasColors == false || canvas->paletteStamp != paletteStamp || canvas->alphaPlane != geometry->alphaPlane ||
+        canvas->flashInverted != geometry->flashInverted) {
+        uint64_t key = 0xcbf29ce484222325ULL;
+        if (indexed) {
+            buildIndexColors(geometry, palette, canvas->colors);
+            key = hashBytes(key, canvas->colors, sizeof(canvas->colors));
+        } else if (geometry->planeCount > 1 || geometry->bitsPerPixel <= 8) {
+            key = hashBytes(key, palette, sizeof(RenderPalette));
+        }
+        canvas->hasColors = true;
+        canvas->paletteStamp = paletteStamp;
+        canvas->alphaPlane = geometry->alphaPlane;
+        canvas->flashInverted = geometry->flashInverted;
+        canvas->colorKey = key;
+    }
+    
+    // Only whole blocks of the image are drawn, as with renderToPixelData.
+    int right = geometry->width / w * w;
+    int bottom = isMasked(geometry) ? geometry->height / 2 * 2 : geometry->height / h * h;
+    if (width > right - x) width = right - x;
+    if (height > bottom - y) height = bottom - y;
+    if (x < 0 || y < 0 || width < 1 || height < 1) {
+        clearRectangle(pixel, stride, 0, 0, areaWidth, areaHeight);
+        return;
+    }
+    
+    long top = firstRow + y;
+    long end = firstRow + y + height;
+    if (end > rows) end = rows;
+    if (top >= end) {
+        clearRectangle(pixel, stride, 0, 0, areaWidth, areaHeight);
+        return;
+    }
+    
+    // What the tiles do not cover, to the right of and below the image, is cleared.
+    clearRectangle(pixel, stride, width, 0, areaWidth - width, end - top);
+    clearRectangle(pixel, stride, 0, end - top, areaWidth, areaHeight - (end - top));
+    
+    int tileWidth = canvas->tileWidth;
+    int tileHeight = canvas->tileHeight;
+    size_t count = (size_t)tileWidth * tileHeight;
+    long inView = ((end - 1) / tileHeight - top / tileHeight + 1) * ((x + width - 1) / tileWidth - x / tileWidth + 1);
+    
+    if (inView > canvas->visibleCapacity) {
+        CanvasTile **visible = realloc(canvas->visible, (size_t)inView * sizeof(CanvasTile *));
+        if (visible == NULL) {
+            clearRectangle(pixel, stride, 0, 0, width, end - top);
+            return;
+        }
+        canvas->visible = visible;
+        canvas->visibleCapacity = (int)inView;
+    }
+    
+    int visibleCount = 0;
+    int workCount = 0;
+    bool complete = true;           // Every tile in view is cached or will be decoded
+    long bandRow = LONG_MAX;
+    long bandEnd = 0;
+    bool decode[inView];
+    CanvasTile *work[inView];
+    
+    canvas->clock++;
+    layout->lastUse = canvas->clock;
+    
+    for (long row = top / tileHeight; row <= (end - 1) / tileHeight; row++) {
+        for (long column = x / tileWidth; column <= (x + width - 1) / tileWidth; column++) {
+            CanvasTile *tile = findTile(canvas, layout->identifier, column, row);
+            bool decodeTile = false;
+            
+            if (tile == NULL) {
+                // Out of memory, the tile is left undrawn.
+                tile = acquireTile(canvas, count, indexed);
+                if (tile == NULL) {
+                    complete = false;
+                    continue;
+                }
+                
+                tile->layout = layout->identifier;
+                tile->column = column;
+                tile->row = row;
+                decodeTile = true;
+            } else if (indexed == false && tile->colorKey != canvas->colorKey) {
+                unlinkTile(canvas, tile);
+                decodeTile = true;
+            }
+            
+            if (decodeTile) {
+                canvas->misses++;
+                decode[workCount] = true;
+                work[workCount++] = tile;
+                if (row * tileHeight < bandRow) bandRow = row * tileHeight;
+                if ((row + 1) * tileHeight > bandEnd) bandEnd = (row + 1) * tileHeight;
+            } else {
+                canvas->hits++;
+                if (indexed && tile->colorKey != canvas->colorKey) {
+                    decode[workCount] = false;
+                    work[workCount++] = tile;
+                }
+            }
+            
+            tile->lastUse = canvas->clock;
+            canvas->visible[visibleCount++] = tile;
+        }
+    }
+    
+    if (canvas->bytes > canvas->budget) trimTiles(canvas);
+    
+    if (workCount) {
+        RenderGeometry band = *geometry;
+        const uint8_t *bytes = NULL;
+        bool decoding = bandRow < bandEnd;     // Else the tiles are only colored again
+        
+        if (decoding && isMasked(geometry)) {
+            bandRow = 0;
+            bytes = dataSourceBytes(source, offset, bytesPerImage(geometry));
+        } else if (decoding) {
+            // Fetched once, for every row of tiles that needs decoding.
+            if (bandEnd > rows) bandEnd = rows;
+            band.height = (int)(bandEnd - bandRow);
+            bytes = dataSourceBytes(source, phase + bandRow / h * bytesPerStrip, bytesPerImage(&band));
+        }
+        
+        if (bytes || decoding == false) {
+            uint64_t start = traceBegin();
+            CanvasWork context = {
+                .canvas = canvas,
+                .palette = palette,
+                .band = &band,
+                .bytes = bytes,
+                .bandRow = bandRow,
+                .tiles = work,
+                .decode = decode
+            };
+            parallelFor(workCount, &context, workOnTile);
+            
+            for (int i = 0; i < workCount; i++) {
+                if (decode[i]) linkTile(canvas, work[i]);
+            }
+            
+            traceEnd(decoding ? "decode tiles" : "color tiles", start);
+            if (decoding) traceAdd(TraceCounterBytesDecoded, isMasked(geometry) ? bytesPerImage(geometry) : bytesPerImage(&band));
+        }
+    }
+    
+    uint64_t start = traceBegin();
+    long written = 0;
+    
+    for (int i = 0; i < visibleCount && complete; i++) {
+        complete = canvas->visible[i]->valid;
+    }
+    
+    // Undrawn tiles are rare, the image is cleared beneath them rather than tracking each one.
+    if (complete == false) clearRectangle(pixel, stride, 0, 0, width, end - top);
+    
+    for (int i = 0; i < visibleCount; i++) {
+        CanvasTile *tile = canvas->visible[i];
+        if (tile->valid == false) continue;
+        
+        // The part of the tile within the rectangle, in rows of the layout and columns of the image.
+        long tileTop = tile->row * tileHeight;
+        long tileLeft = tile->column * tileWidth;
+        long r0 = tileTop > top ? tileTop : top;
+        long r1 = tileTop + tileHeight < end ? tileTop + tileHeight : end;
+        long c0 = tileLeft > x ? tileLeft : x;
+        long c1 = tileLeft + tileWidth < x + width ? tileLeft + tileWidth : x + width;
+        
+        for (long r = r0; r < r1; r++) {
+            memcpy(pixel + (r - top) * stride + (c0 - x), tile->pixel + (r - tileTop) * tileWidth + (c0 - tileLeft), (c1 - c0) * sizeof(uint32_t));
+        }
+        written += (r1 - r0) * (c1 - c0);
+    }
+    
+    traceEnd("copy tiles", start);
+    traceAdd(TraceCounterPixelsWritten, written);
+}
@@ -0,0 +1,99 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef canvas_h
+#define canvas_h
+
+#include "render.h"
+#include "datasource.h"
+
+/*
+ A virtual canvas for images of any size, decoded a fixed size tile at a time.
+ 
+ Only the tiles of the area being drawn are decoded, in parallel, and kept in a cache
+ bounded by a memory budget, the least recently drawn tile is the one reused. Tiles
+ are placed by their rows from the start of the data rather than from the offset, so
+ scrolling the offset by whole rows keeps every tile still in view. Tiles are kept for
+ the last few layouts drawn, the geometry along with the offset within a row, so going
+ back to a page or geometry seen recently only copies its pixels. Tiles of indexed
+ geometries keep their indices and are only colored again when the colors differ from
+ those they were mapped with.
+ */
+
+typedef struct RenderCanvas RenderCanvas;
+
+typedef struct {
+    unsigned long hits;         // Tiles drawn without decoding, including those colored again
+    unsigned long misses;       // Tiles decoded from the source
+    int tiles;                  // Tiles cached
+    size_t bytes;               // Memory held by the pixels of every tile
+} RenderCanvasStatistics;
+
+/* Set up for C function definitions, even when using C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /*
+     Creates a canvas caching tiles in up to budget bytes, more only when the area being
+     drawn needs it. Returns NULL and sets errno on failure.
+     */
+    RenderCanvas *createCanvas(size_t budget);
+    
+    void closeCanvas(RenderCanvas *canvas);
+    
+    /*
+     Drops every tile, call after the source data has changed.
+     */
+    void invalidateCanvas(RenderCanvas *canvas);
+    
+    /*
+     Changes the memory budget, freeing the least recently drawn tiles until within it.
+     */
+    void setCanvasBudget(RenderCanvas *canvas, size_t budget);
+    
+    /*
+     Fills statistics with the tiles drawn since the canvas was created and the memory they hold.
+     */
+    void canvasStatistics(const RenderCanvas *canvas, RenderCanvasStatistics *statistics);
+    
+    /*
+     Draws the rectangle x, y, width, height of the image that starts offset bytes into
+     the source, decoding any tile that is not cached. Every pixel of the rectangle is
+     written, those outside the image, or past the end of the data, are cleared.
+     
+     Parameters
+     paletteStamp
+     Changes whenever the colors of the palette do.
+     pixel
+     Destination of the top left pixel of the rectangle.
+     stride
+     Distance in pixels between two destination rows.
+     */
+    void drawCanvas(RenderCanvas *canvas, DataSource *source, long offset, const RenderGeometry *geometry, const RenderPalette *palette, unsigned long paletteStamp, int x, int y, int width, int height, uint32_t *pixel, long stride);
+
+/* Ends C function definitions when using C++ */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* canvas_h */
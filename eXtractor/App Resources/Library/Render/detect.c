@@ -0,0 +1,410 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "detect.h"
+#include "bitplane.h"
+#include "parallel.h"
+
+#include <math.h>
+
+#define SAMPLE_BYTES    (128 * 1024)    // Byte pairs compared for every lag
+#define SAMPLE_ROW_BYTES 16384          // Source bytes of whole rows decoded to try a layout
+#define SAMPLE_PIXELS   (SAMPLE_ROW_BYTES * 8)
+#define MIN_STRIDE      8
+#define MAX_STRIDE      8192
+#define NEIGHBOURS      8               // Lags either side that the dip of a stride is measured against
+#define LAGS_PER_JOB    64
+#define MAX_STRIDES     8               // Dips tried with every layout
+#define MAX_PADDING     3
+#define MAX_HARMONIC    4               // Rows of a stride that may look alike, line doubled or interlaced images
+
+typedef struct {
+    int bitsPerPixel;
+    int planeCount;
+} Layout;
+
+static const Layout layouts[] = {
+    {1, 1}, {2, 1}, {4, 1}, {8, 1}, {16, 1}, {24, 1}, {32, 1},
+    {16, 2}, {16, 3}, {16, 4}, {16, 5}, {16, 6},
+    {8, 2}, {8, 3}, {8, 4}, {8, 5}
+};
+
+typedef struct {
+    const uint8_t *bytes;
+    long samples;
+    long lags;
+    double difference[MAX_STRIDE + NEIGHBOURS + 1];    // Mean absolute difference for each lag, [0] unused
+} Lags;
+
+typedef struct {
+    uint8_t index[SAMPLE_PIXELS];
+    uint32_t pixel[SAMPLE_PIXELS];
+    uint8_t counts[4][256 * 16][2];     // Zeros and ones seen in each context of fitScore, per byte
+    float cost[2][256][256];            // Bits to code a 0 or a 1 after seeing that many zeros and ones
+} Sample;
+
+// MARK: - Private Functions
+
+static double clamp(double value) {
+    return value < 0.0 ? 0.0 : value > 1.0 ? 1.0 : value;
+}
+
+static void measureLags(void *context, size_t index) {
+    Lags *lags = context;
+    long first = (long)index * LAGS_PER_JOB + 1;
+    long last = first + LAGS_PER_JOB;
+    if (last > lags->lags + 1) last = lags->lags + 1;
+    
+    for (long lag = first; lag < last; lag++) {
+        uint64_t sum = sumOfAbsoluteDifferences(lags->bytes, lags->bytes + lag, lags->samples);
+        lags->difference[lag] = (double)sum / (double)lags->samples;
+    }
+}
+
+/*
+ How far the difference at the stride dips below the mean of the lags around it, 0 to 1, or 0
+ unless it is the floor of the dip. The lags right next to a stride compare diagonal neighbours,
+ which dithering can make as alike as the pixels above, so they are left out of the mean.
+ */
+static double rowScore(const Lags *lags, long stride) {
+    const double *difference = lags->difference;
+    double mean = 0.0;
+    int count = 0;
+    
+    if (difference[stride] > difference[stride - 1] || difference[stride] >= difference[stride + 1]) return 0.0;
+    
+    for (long lag = stride - NEIGHBOURS; lag <= stride + NEIGHBOURS; lag++) {
+        if (lag < 1 || labs(lag - stride) < 2) continue;
+        mean += difference[lag];
+        count++;
+    }
+    mean /= count;
+    
+    return mean > 0.0 ? clamp((mean - difference[stride]) / mean) : 0.0;
+}
+
+/*
+ Every few rows of an image look alike too, so a stride gives way to the shortest stride it
+ is a whole multiple of that dips nearly as far.
+ */
+static long fundamentalStride(const Lags *lags, long stride, double *score) {
+    for (long k = MAX_HARMONIC; k >= 2; k--) {
+        if (stride % k || stride / k < MIN_STRIDE) continue;
+        
+        double s = rowScore(lags, stride / k);
+        if (s >= *score * 0.75) {
+            *score = s;
+            return stride / k;
+        }
+    }
+    return stride;
+}
+
+/*
+ The strides that dip below their neighbours the most, best first, leaving out the harmonics
+ of a better one. The lags either side of each are tried too, as the floor of a dip can be a
+ diagonal neighbour, which leaves up to 3 strides per dip.
+ */
+static int findStrides(const Lags *lags, long *strides, double *scores) {
+    long found[MAX_STRIDES];
+    double foundScores[MAX_STRIDES];
+    int count = 0;
+    
+    for (long stride = MIN_STRIDE; stride <= lags->lags - NEIGHBOURS; stride++) {
+        double score = rowScore(lags, stride);
+        if (score <= 0.0) continue;
+        if (count == MAX_STRIDES && score <= foundScores[MAX_STRIDES - 1]) continue;
+        
+        int i = count < MAX_STRIDES ? count++ : MAX_STRIDES - 1;
+        for (; i > 0 && foundScores[i - 1] < score; i--) {
+            found[i] = found[i - 1];
+            foundScores[i] = foundScores[i - 1];
+        }
+        found[i] = stride;
+        foundScores[i] = score;
+    }
+    
+    int kept = 0;
+    int dips = 0;
+    for (int i = 0; i < count; i++) {
+        double score = foundScores[i];
+        long stride = fundamentalStride(lags, found[i], &score);
+        
+        bool harmonic = false;
+        for (int j = 0; j < dips; j++) {
+            if (stride % found[j] == 0 && stride / found[j] <= MAX_HARMONIC) harmonic = true;
+        }
+        if (harmonic) continue;
+        found[dips++] = stride;
+        
+        for (long lag = stride - 1; lag <= stride + 1; lag++) {
+            bool seen = false;
+            for (int j = 0; j < kept; j++) {
+                if (strides[j] == lag) seen = true;
+            }
+            if (seen) continue;
+            
+            strides[kept] = lag;
+            scores[kept] = score;
+            kept++;
+        }
+    }
+    return kept;
+}
+
+static int unitBytes(const Layout *layout) {
+    if (layout->planeCount > 1) return layout->bitsPerPixel / 8 * layout->planeCount;
+    return layout->bitsPerPixel < 8 ? 1 : layout->bitsPerPixel / 8;
+}
+
+static int pixelsPerUnit(const Layout *layout) {
+    if (layout->planeCount > 1) return layout->bitsPerPixel;
+    return layout->bitsPerPixel < 8 ? 8 / layout->bitsPerPixel : 1;
+}
+
+/*
+ Fraction of the bytes at positions first to last - 1 of each cycle that are equal to the
+ same byte of the cycle before, high for the constant filler of padding bytes.
+ */
+static double constancy(const uint8_t *bytes, long length, int cycle, int first, int last) {
+    long equal = 0;
+    long count = 0;
+    
+    for (long i = cycle; i + cycle <= length; i += cycle) {
+        for (int k = first; k < last; k++) {
+            if (bytes[i + k] == bytes[i + k - cycle]) equal++;
+            count++;
+        }
+    }
+    return count ? (double)equal / (double)count : 0.0;
+}
+
+/*
+ How well the pixels of the sample compress, 0 to 1, as 1 less the bits needed per source bit.
+ 
+ Every bit of a pixel, or of each byte of a direct color pixel, is coded from counts kept for
+ the bits above it in the same pixel and the same bit of the pixels to the left and the three
+ above. The right layout lines up the bits that change together with their neighbours, so it needs
+ the fewest. Counts start empty, so contexts seen only a few times cost nearly a bit a bit.
+ */
+static double fitScore(Sample *sample, int width, int height, int channels, int bits) {
+    memset(sample->counts, 0, sizeof(sample->counts));
+    double cost = 0.0;
+    long coded = 0;
+    
+    for (int y = 1; y < height; y++) {
+        const uint32_t *row = sample->pixel + (long)y * width;
+        
+        for (int x = 1; x + 1 < width; x++) {
+            uint32_t pixel = row[x];
+            uint32_t left = row[x - 1];
+            uint32_t above = row[x - width];
+            uint32_t aboveLeft = row[x - width - 1];
+            uint32_t aboveRight = row[x - width + 1];
+            
+            for (int channel = 0; channel < channels; channel++) {
+                int shift = channel * 8;
+                uint8_t (*counts)[2] = sample->counts[channel];
+                
+                for (int bit = bits - 1; bit >= 0; bit--) {
+                    int value = (pixel >> (shift + bit)) & 1;
+                    int prefix = (int)((pixel >> shift & 0xFF) >> (bit + 1));
+                    int context = ((1 << (bits - 1 - bit)) - 1 + prefix) * 16;
+                    context |= (int)(aboveRight >> (shift + bit) & 1) << 3;
+                    context |= (int)(left >> (shift + bit) & 1) << 2;
+                    context |= (int)(above >> (shift + bit) & 1) << 1;
+                    context |= (int)(aboveLeft >> (shift + bit) & 1);
+                    
+                    uint8_t *n = counts[context];
+                    cost += sample->cost[value][n[0]][n[1]];
+                    if (++n[value] == 255) {
+                        n[0] >>= 1;
+                        n[1] >>= 1;
+                    }
+                }
+            }
+            coded += channels * bits;
+        }
+    }
+    
+    return coded ? clamp(1.0 - cost / coded) : 0.0;
+}
+
+/*
+ Decodes the rows at bytes with the geometry and scores how much they look like an image.
+ Direct color pixels are scored on their bytes as they are stored.
+ */
+static double sampleScore(Sample *sample, const RenderGeometry *geometry, const uint8_t *bytes) {
+    long count = (long)geometry->width * geometry->height;
+    
+    if (isIndexedGeometry(geometry)) {
+        renderToIndices(geometry, bytes, sample->index, geometry->width);
+        for (long i = 0; i < count; i++) {
+            sample->pixel[i] = sample->index[i];
+        }
+        return fitScore(sample, geometry->width, geometry->height, 1, geometry->planeCount > 1 ? geometry->planeCount : geometry->bitsPerPixel);
+    }
+    
+    int size = geometry->bitsPerPixel / 8;
+    long stride = bytesPerImage(geometry) / geometry->height;
+    for (int y = 0; y < geometry->height; y++) {
+        const uint8_t *source = bytes + y * stride;
+        uint32_t *pixel = sample->pixel + (long)y * geometry->width;
+        
+        for (int x = 0; x < geometry->width; x++) {
+            uint32_t value = 0;
+            for (int i = 0; i < size; i++) {
+                value |= (uint32_t)source[i] << (i * 8);
+            }
+            pixel[x] = value;
+            source += size + geometry->padding;
+        }
+    }
+    return fitScore(sample, geometry->width, geometry->height, size, 8);
+}
+
+static double widthPrior(int width) {
+    static const int common[] = {
+        128, 160, 176, 192, 224, 240, 256, 288, 320, 352, 384, 400, 448, 480, 512, 640, 720, 768, 800, 1024, 1280
+    };
+    double prior = width % 16 == 0 ? 0.9 : width % 8 == 0 ? 0.8 : 0.6;
+    
+    for (size_t i = 0; i < sizeof(common) / sizeof(common[0]); i++) {
+        if (common[i] == width) prior = 1.0;
+    }
+    if (width < 32) prior *= 0.5;
+    if (width > 2048) prior *= 0.7;
+    return prior;
+}
+
+static int compareScore(const void *a, const void *b) {
+    float x = ((const RenderHypothesis *)a)->score;
+    float y = ((const RenderHypothesis *)b)->score;
+    return (x < y) - (x > y);
+}
+
+// MARK: - Public Functions
+
+int detectGeometry(DataSource *source, long offset, RenderHypothesis *hypotheses, int count) {
+    long length = source ? dataSourceLength(source) - offset : 0;
+    if (offset < 0 || length < 64 || count < 1) return 0;
+    
+    Lags *lags = malloc(sizeof(Lags));
+    Sample *sample = malloc(sizeof(Sample));
+    int layoutCount = (int)(sizeof(layouts) / sizeof(layouts[0]));
+    RenderHypothesis *found = malloc(sizeof(RenderHypothesis) * MAX_STRIDES * 3 * layoutCount * (MAX_PADDING + 1));
+    uint8_t *bytes = NULL;
+    int n = 0;
+    
+    if (lags == NULL || sample == NULL || found == NULL) goto cleanup;
+    
+    // At least four rows of the widest stride are compared.
+    long maxStride = (length - NEIGHBOURS) / 4;
+    if (maxStride > MAX_STRIDE) maxStride = MAX_STRIDE;
+    
+    lags->lags = maxStride + NEIGHBOURS;
+    lags->samples = length - lags->lags;
+    if (lags->samples > SAMPLE_BYTES) lags->samples = SAMPLE_BYTES;
+    lags->difference[0] = 0.0;
+    
+    // The start of the data is kept, as it is still needed once the middle has been read.
+    long head = lags->samples + lags->lags;
+    const uint8_t *start = dataSourceBytes(source, offset, head);
+    bytes = malloc(head);
+    if (start == NULL || bytes == NULL) goto cleanup;
+    memcpy(bytes, start, head);
+    lags->bytes = bytes;
+    parallelFor((size_t)(lags->lags + LAGS_PER_JOB - 1) / LAGS_PER_JOB, lags, measureLags);
+    
+    long strides[MAX_STRIDES * 3];
+    double scores[MAX_STRIDES * 3];
+    int strideCount = findStrides(lags, strides, scores);
+    for (int zeros = 0; zeros < 256; zeros++) {
+        for (int ones = 0; ones < 256; ones++) {
+            double p = (ones + 0.4) / (zeros + ones + 0.8);
+            sample->cost[1][zeros][ones] = (float)-log2(p);
+            sample->cost[0][zeros][ones] = (float)-log2(1.0 - p);
+        }
+    }
+    
+    for (int l = 0; l < layoutCount; l++) {
+        const Layout *layout = &layouts[l];
+        int unit = unitBytes(layout);
+        
+        for (int padding = 0; padding <= MAX_PADDING; padding++) {
+            int cycle = unit + padding;
+            double fill = 1.0;
+            
+            // Padding is only believed when it is constant filler between varying pixels.
+            if (padding) {
+                if (layout->planeCount == 1 && layout->bitsPerPixel < 8) break;
+                fill = constancy(bytes, lags->samples, cycle, unit, cycle);
+                if (fill < 0.95 || fill - constancy(bytes, lags->samples, cycle, 0, unit) < 0.2) continue;
+                fill *= 0.9;
+            }
+            
+            for (int s = 0; s < strideCount; s++) {
+                if (strides[s] % cycle) continue;
+                
+                long width = strides[s] / cycle * pixelsPerUnit(layout);
+                long rows = SAMPLE_ROW_BYTES / strides[s];
+                if (rows > length / strides[s]) rows = length / strides[s];
+                if (rows < 3 || width * rows > SAMPLE_PIXELS) continue;
+                
+                RenderGeometry geometry = {
+                    .width = (int)width,
+                    .height = (int)rows,
+                    .bitsPerPixel = layout->bitsPerPixel,
+                    .planeCount = layout->planeCount,
+                    .bigEndian = true,
+                    .pixelFormat = RenderPixelFormatRGB555,
+                    .tileWidth = 1,
+                    .tileHeight = 1,
+                    .padding = padding
+                };
+                if (isValidGeometry(&geometry) == false) continue;
+                
+                // The rows from the middle, the top of a picture is often a plain background.
+                long first = (length / strides[s] - rows) / 2;
+                const uint8_t *middle = dataSourceBytes(source, offset + first * strides[s], rows * strides[s]);
+                if (middle == NULL) continue;
+                double score = sampleScore(sample, &geometry, middle);
+                geometry.height = (int)(length / strides[s]);
+                
+                found[n].geometry = geometry;
+                found[n].score = (float)(scores[s] * score * fill * widthPrior(geometry.width));
+                n++;
+            }
+        }
+    }
+    
+    if (n > 0) qsort(found, n, sizeof(RenderHypothesis), compareScore);
+    if (n > count) n = count;
+    if (n > 0) memcpy(hypotheses, found, sizeof(RenderHypothesis) * n);
+    
+cleanup:
+    free(bytes);
+    free(found);
+    free(sample);
+    free(lags);
+    return n;
+}
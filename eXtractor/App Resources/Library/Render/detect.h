@@ -0,0 +1,71 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef detect_h
+#define detect_h
+
+#include "render.h"
+#include "datasource.h"
+
+/*
+ Guesses the layout of raw image data from its bytes alone.
+ 
+ Rows of an image look alike, so the distance in bytes between two rows shows up as a dip
+ in the mean absolute difference between every byte and the byte that many bytes further on.
+ The differences for every lag up to 8192 are measured over the first 128 KB with SIMD sum
+ of absolute differences, spread over all cores, and the deepest dips are the candidate strides.
+ Each stride is then tried with every packed and planar layout that fits a whole number of pixel
+ groups in it, by decoding rows from the middle of the data and measuring how well the pixels
+ are predicted by their neighbours. Scores are relative, only useful for ranking.
+ 
+ Only those two samples are read from the source, however long it is.
+ */
+
+typedef struct {
+    RenderGeometry geometry;        // Width, bitsPerPixel, planeCount, padding and the rows that fit in the data
+    float score;                    // Higher is more likely
+} RenderHypothesis;
+
+/* Set up for C function definitions, even when using C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /*
+     Fills hypotheses with at most count layouts for the image data, best first.
+     
+     Parameters
+     source
+     Image data, the rest of it from offset on, at least 64 bytes are needed.
+     offset
+     Start of the image data, any header skipped so pixel groups start on the first byte.
+     
+     Returns the number of hypotheses written, 0 when the data shows no row structure.
+     */
+    int detectGeometry(DataSource *source, long offset, RenderHypothesis *hypotheses, int count);
+
+/* Ends C function definitions when using C++ */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* detect_h */
@@ -0,0 +1,230 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "paletteindex.h"
+
+#include <errno.h>
+#include <stdlib.h>
+
+#define PALETTE_WORDS   16
+#define PALETTE_BYTES   (PALETTE_WORDS * 2)
+#define CHUNK_BYTES     (1024 * 1024)     // Window offsets checked per read of the source
+
+static const PaletteFormat formatList[] = {
+    PaletteFormatAtariST, PaletteFormatAtariSTE, PaletteFormatNext
+};
+
+/*
+ Sets flags[i] to the formats the word starting at bytes[i] is valid in, count + 1 bytes are read.
+ */
+static void classifyWords(const uint8_t *bytes, uint8_t *flags, long count) {
+    for (long i = 0; i < count; i++) {
+        uint8_t high = bytes[i], low = bytes[i + 1];
+        flags[i] = (uint8_t)((((high & 0xF8) | (low & 0x88)) == 0) * PaletteFormatAtariST |
+                             ((high & 0xF0) == 0) * PaletteFormatAtariSTE |
+                             ((low & 0xFE) == 0) * PaletteFormatNext);
+    }
+}
+
+/*
+ Leaves in flags[i] the formats every word of the window starting at i is valid in, by
+ doubling the words covered on each pass. Only the first count - 30 flags are meaningful after.
+ */
+static void combineWindows(uint8_t *flags, long count) {
+    for (long step = 2; step < PALETTE_BYTES; step *= 2) {
+        count -= step;
+        for (long i = 0; i < count; i++) {
+            flags[i] &= flags[i + step];
+        }
+    }
+}
+
+/*
+ Returns true when no two words of the window are the same, seen is a 65536 bit map left all clear.
+ */
+static bool isDistinct(const uint8_t *bytes, uint64_t *seen) {
+    bool distinct = true;
+    int i;
+    
+    for (i = 0; i < PALETTE_WORDS; i++) {
+        unsigned word = (unsigned)bytes[i * 2] << 8 | bytes[i * 2 + 1];
+        uint64_t bit = (uint64_t)1 << (word & 63);
+        if (seen[word >> 6] & bit) {
+            distinct = false;
+            break;
+        }
+        seen[word >> 6] |= bit;
+    }
+    
+    while (i-- > 0) {
+        seen[((unsigned)bytes[i * 2] << 8 | bytes[i * 2 + 1]) >> 6] = 0;
+    }
+    return distinct;
+}
+
+/*
+ Channels of a word scaled to 0...15.
+ */
+static void wordToRgb(const uint8_t *bytes, PaletteFormat format, int rgb[3]) {
+    uint8_t first = bytes[0], second = bytes[1];
+    
+    switch (format) {
+        case PaletteFormatAtariST:
+            rgb[0] = (first & 7) << 1;
+            rgb[1] = (second >> 4 & 7) << 1;
+            rgb[2] = (second & 7) << 1;
+            break;
+            
+        case PaletteFormatAtariSTE:
+            rgb[0] = (first & 7) << 1 | (first >> 3 & 1);
+            rgb[1] = (second >> 4 & 7) << 1 | (second >> 7);
+            rgb[2] = (second & 7) << 1 | (second >> 3 & 1);
+            break;
+            
+        case PaletteFormatNext:
+            rgb[0] = (first >> 5) << 1;
+            rgb[1] = (first >> 2 & 7) << 1;
+            rgb[2] = ((first & 3) << 1 | (second & 1)) << 1;
+            break;
+    }
+}
+
+/*
+ Palettes use all three channels, have black, usually as color 0, and spread their colors
+ over many brightness levels, tables of small numbers that happen to fit the masks do not.
+ */
+static float scorePalette(const uint8_t *bytes, PaletteFormat format) {
+    int lowest[3] = {15, 15, 15}, highest[3] = {0, 0, 0};
+    uint64_t brightness = 0;
+    int levels = 0;
+    float black = 0.0f;
+    
+    for (int i = 0; i < PALETTE_WORDS; i++) {
+        int rgb[3] = {0, 0, 0};
+        wordToRgb(bytes + i * 2, format, rgb);
+        
+        for (int c = 0; c < 3; c++) {
+            if (rgb[c] < lowest[c]) lowest[c] = rgb[c];
+            if (rgb[c] > highest[c]) highest[c] = rgb[c];
+        }
+        
+        uint64_t level = (uint64_t)1 << (rgb[0] + rgb[1] + rgb[2]);
+        if ((brightness & level) == 0) levels++;
+        brightness |= level;
+        
+        if (rgb[0] + rgb[1] + rgb[2] == 0) black = i == 0 ? 1.0f : 0.5f;
+    }
+    
+    int varied = 0;
+    for (int c = 0; c < 3; c++) {
+        if (highest[c] > lowest[c]) varied++;
+    }
+    
+    return 0.4f * (float)varied / 3.0f + 0.3f * black + 0.3f * (float)levels / (float)PALETTE_WORDS;
+}
+
+static bool appendCandidate(PaletteIndex *index, long *capacity, const PaletteCandidate *candidate) {
+    if (index->count > 0) {
+        PaletteCandidate *last = &index->candidates[index->count - 1];
+        if (candidate->offset < last->offset + PALETTE_BYTES) {
+            if (candidate->score > last->score) *last = *candidate;
+            return true;
+        }
+    }
+    
+    if (index->count == *capacity) {
+        long grown = *capacity ? *capacity * 2 : 256;
+        PaletteCandidate *candidates = realloc(index->candidates, (size_t)grown * sizeof(PaletteCandidate));
+        if (candidates == NULL) return false;
+        index->candidates = candidates;
+        *capacity = grown;
+    }
+    index->candidates[index->count++] = *candidate;
+    return true;
+}
+
+PaletteIndex *createPaletteIndex(DataSource *source, int formats) {
+    long length = dataSourceLength(source);
+    long capacity = 0;
+    
+    PaletteIndex *index = calloc(1, sizeof(PaletteIndex));
+    uint8_t *flags = malloc(CHUNK_BYTES + PALETTE_BYTES);
+    uint64_t *seen = calloc(65536 / 64, sizeof(uint64_t));
+    if (index == NULL || flags == NULL || seen == NULL) goto failed;
+    
+    for (long start = 0; start + PALETTE_BYTES <= length; start += CHUNK_BYTES) {
+        long windows = length - PALETTE_BYTES + 1 - start;
+        if (windows > CHUNK_BYTES) windows = CHUNK_BYTES;
+        
+        long words = windows + PALETTE_BYTES - 2;
+        const uint8_t *bytes = dataSourceBytes(source, start, words + 1);
+        if (bytes == NULL) {
+            errno = EIO;
+            goto failed;
+        }
+        
+        classifyWords(bytes, flags, words);
+        combineWindows(flags, words);
+        
+        for (long i = 0; i < windows; i++) {
+            int valid = flags[i] & formats;
+            if (valid == 0) continue;
+            if (!isDistinct(bytes + i, seen)) continue;
+            
+            // Every Atari ST palette is also a valid Atari STE one, with darker colors.
+            if (valid & PaletteFormatAtariST) valid &= ~PaletteFormatAtariSTE;
+            
+            PaletteCandidate candidate = {
+                .offset = start + i,
+                .backgroundBlack = bytes[i] == 0 && bytes[i + 1] == 0,
+                .score = -1.0f
+            };
+            for (int f = 0; f < (int)(sizeof(formatList) / sizeof(formatList[0])); f++) {
+                if ((valid & formatList[f]) == 0) continue;
+                float score = scorePalette(bytes + i, formatList[f]);
+                if (score > candidate.score) {
+                    candidate.score = score;
+                    candidate.format = formatList[f];
+                }
+            }
+            
+            if (!appendCandidate(index, &capacity, &candidate)) goto failed;
+        }
+    }
+    
+    free(flags);
+    free(seen);
+    return index;
+    
+failed:
+    free(flags);
+    free(seen);
+    closePaletteIndex(index);
+    return NULL;
+}
+
+void closePaletteIndex(PaletteIndex *index) {
+    if (index == NULL) return;
+    
+    free(index->candidates);
+    free(index);
+}
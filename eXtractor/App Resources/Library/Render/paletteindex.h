@@ -0,0 +1,75 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef paletteindex_h
+#define paletteindex_h
+
+#include "common.h"
+#include "datasource.h"
+
+/*
+ Every 16 color palette stored in a file, found in a single pass.
+ 
+ A window of 16 words can only be a palette when every word leaves the unused bits of its
+ format clear and no two words are the same. The word masks are checked for every byte
+ offset a chunk at a time with branch-free loops the compiler vectorises, then combined
+ over each 32-byte window, and the few windows left are checked for repeats with a bitmap.
+ Windows that overlap are reduced to the one that looks most like a palette.
+ */
+
+typedef enum {
+    PaletteFormatAtariST  = 1 << 0,     // Big-endian 0000 0RRR 0GGG 0BBB
+    PaletteFormatAtariSTE = 1 << 1,     // Big-endian 0000 RRRR GGGG BBBB, low bit of each channel on top
+    PaletteFormatNext     = 1 << 2      // Little-endian RRRG GGBB 0000 000B
+} PaletteFormat;
+
+typedef struct {
+    long offset;                // Offset of the first word in the source
+    PaletteFormat format;       // Atari ST palettes are never reported as Atari STE
+    bool backgroundBlack;       // Color 0 is black, as games keep it
+    float score;                // 0...1, how much the colors look like a palette rather than data
+} PaletteCandidate;
+
+typedef struct {
+    PaletteCandidate *candidates;   // Sorted by offset, none overlapping
+    long count;
+} PaletteIndex;
+
+/* Set up for C function definitions, even when using C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /*
+     Indexes every palette in the source of one of the formats, a mask of PaletteFormat.
+     Returns NULL and sets errno on failure.
+     */
+    PaletteIndex *createPaletteIndex(DataSource *source, int formats);
+    
+    void closePaletteIndex(PaletteIndex *index);
+
+/* Ends C function definitions when using C++ */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* paletteindex_h */
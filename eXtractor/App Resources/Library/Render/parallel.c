@@ -0,0 +1,174 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "parallel.h"
+
+#ifdef __APPLE__
+#include <dispatch/dispatch.h>
+#else
+#include <pthread.h>
+#include <stdatomic.h>
+#endif
+
+#include <unistd.h>
+
+#define MAX_THREAD_COUNT 64
+
+static int coreCount(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (count < 1) return 1;
+    return count > MAX_THREAD_COUNT ? MAX_THREAD_COUNT : (int)count;
+}
+
+#ifdef __APPLE__
+
+int parallelThreadCount(void) {
+    return coreCount();
+}
+
+void parallelFor(size_t count, void *context, ParallelWork work) {
+    if (count == 1) {
+        work(context, 0);
+        return;
+    }
+    dispatch_apply_f(count, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), context, work);
+}
+
+#else
+
+// MARK: - Thread Pool
+
+/*
+ A submitted parallelFor, lives on the stack of the submitting thread. Jobs stay queued
+ until every index has been claimed, users counts the workers still running one of its
+ indices so the submitter knows when the job may go out of scope.
+ */
+typedef struct Job {
+    ParallelWork work;
+    void *context;
+    size_t count;
+    atomic_size_t next;
+    int users;
+    struct Job *nextJob;
+} Job;
+
+static pthread_once_t poolOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t jobQueued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t jobReleased = PTHREAD_COND_INITIALIZER;
+static Job *queue;
+static int workerCount;
+
+static void runJob(Job *job) {
+    for (;;) {
+        size_t index = atomic_fetch_add_explicit(&job->next, 1, memory_order_relaxed);
+        if (index >= job->count) return;
+        job->work(job->context, index);
+    }
+}
+
+// Must be called with poolLock held.
+static void unlinkJob(Job *job) {
+    for (Job **link = &queue; *link; link = &(*link)->nextJob) {
+        if (*link == job) {
+            *link = job->nextJob;
+            return;
+        }
+    }
+}
+
+static void *worker(void *arg) {
+    pthread_mutex_lock(&poolLock);
+    for (;;) {
+        while (queue == NULL) {
+            pthread_cond_wait(&jobQueued, &poolLock);
+        }
+        
+        Job *job = queue;
+        job->users++;
+        pthread_mutex_unlock(&poolLock);
+        
+        runJob(job);
+        
+        pthread_mutex_lock(&poolLock);
+        // Every index has been claimed, so there is nothing left for other workers to pick up.
+        unlinkJob(job);
+        if (--job->users == 0) {
+            pthread_cond_broadcast(&jobReleased);
+        }
+    }
+    return NULL;
+}
+
+static void startPool(void) {
+    int count = coreCount() - 1;
+    
+    for (int i = 0; i < count; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, worker, NULL) != 0) break;
+        pthread_detach(thread);
+        workerCount++;
+    }
+}
+
+int parallelThreadCount(void) {
+    pthread_once(&poolOnce, startPool);
+    return workerCount + 1;
+}
+
+void parallelFor(size_t count, void *context, ParallelWork work) {
+    pthread_once(&poolOnce, startPool);
+    
+    if (count < 2 || workerCount == 0) {
+        for (size_t index = 0; index < count; index++) {
+            work(context, index);
+        }
+        return;
+    }
+    
+    Job job = {
+        .work = work,
+        .context = context,
+        .count = count,
+        .users = 0,
+        .nextJob = NULL
+    };
+    atomic_init(&job.next, 0);
+    
+    pthread_mutex_lock(&poolLock);
+    Job **link = &queue;
+    while (*link) link = &(*link)->nextJob;
+    *link = &job;
+    pthread_cond_broadcast(&jobQueued);
+    pthread_mutex_unlock(&poolLock);
+    
+    runJob(&job);
+    
+    pthread_mutex_lock(&poolLock);
+    unlinkJob(&job);
+    while (job.users > 0) {
+        pthread_cond_wait(&jobReleased, &poolLock);
+    }
+    pthread_mutex_unlock(&poolLock);
+}
+
+#endif
@@ -0,0 +1,56 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef parallel_h
+#define parallel_h
+
+#include "common.h"
+
+/*
+ Runs work(context, index) for every index below count, spread over all cores.
+ 
+ Uses dispatch_apply on macOS. Elsewhere a pool of one worker thread per extra core
+ is started on first use, every worker and the caller take the next unclaimed index
+ until none are left, so faster threads pick up the work of slower ones. Any number of
+ threads may submit work at the same time. Returns once every index has been run.
+ */
+
+typedef void (*ParallelWork)(void *context, size_t index);
+
+/* Set up for C function definitions, even when using C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /*
+     Number of threads that work is spread over, the caller included.
+     */
+    int parallelThreadCount(void);
+    
+    void parallelFor(size_t count, void *context, ParallelWork work);
+
+/* Ends C function definitions when using C++ */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* parallel_h */
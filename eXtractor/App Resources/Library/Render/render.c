@@ -0,0 +1,1258 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "render.h"
+#include "bitplane.h"
+#include "parallel.h"
+#include "tileformat.h"
+#include "ZX Spectrum.h"
+#include "Commodore 64.h"
+
+#include <stdatomic.h>
+
+#define PIXEL_FORMAT_COUNT 8
+#define PIXELS_PER_BAND 16384   // Smallest band worth handing to another thread
+#define BANDS_PER_THREAD 4      // Spare bands for threads that finish early to pick up
+
+/*
+ Decodes count pixels of a single row. The table is the palette for planar rows,
+ the lookup for packed rows of up to 8 bits, the direct color table for 16-bit
+ rows and unused otherwise.
+ */
+typedef const uint8_t *(*RowDecoder)(const RenderGeometry *geometry, const void *table, const uint8_t *bytes, uint32_t *pixel, int count);
+
+// MARK: - Private Functions
+
+static bool isPlanar(const RenderGeometry *geometry) {
+    return geometry->planeCount > 1 && geometry->layout == RenderLayoutLinear;
+}
+
+static bool isTiled(const RenderGeometry *geometry) {
+    return geometry->tileWidth > 1 && geometry->tileHeight > 1;
+}
+
+// Console tiles, 8 by 8 pixels of bitplanes laid out as their descriptor states.
+static bool isTileFormat(const RenderGeometry *geometry) {
+    return tileFormatBits(geometry->layout) > 0;
+}
+
+// ZX screens and C64 bitmaps, pictures of a fixed size and layout.
+static bool isPicture(const RenderGeometry *geometry) {
+    return geometry->layout != RenderLayoutLinear && isTileFormat(geometry) == false;
+}
+
+static uint16_t planeWord(const RenderGeometry *geometry, const uint8_t *bytes) {
+    if (geometry->bigEndian) return (uint16_t)bytes[0] << 8 | bytes[1];
+    return (uint16_t)bytes[1] << 8 | bytes[0];
+}
+
+static uint32_t indexedColor(const RenderGeometry *geometry, const RenderPalette *palette, unsigned index) {
+    if (geometry->alphaPlane && (int)index == palette->transparentIndex) return 0;
+    return palette->rgb[index & 255];
+}
+
+/*
+ The smallest run of pixels that starts on a byte boundary, a single byte for
+ packed pixels of less than 8 bits, a group of bitsPerPlane pixels in planar mode,
+ a cell of a picture.
+ */
+static int unitWidth(const RenderGeometry *geometry) {
+    if (isPicture(geometry)) return geometry->layout == RenderLayoutC64Multicolor ? 4 : 8;
+    if (isTileFormat(geometry)) return TILE_FORMAT_SIZE;
+    if (isPlanar(geometry)) return geometry->bitsPerPixel;
+    if (geometry->bitsPerPixel < 8) return 8 / geometry->bitsPerPixel;
+    return 1;
+}
+
+static long bytesForPixels(const RenderGeometry *geometry, long count) {
+    if (isPicture(geometry)) {
+        // On average, a ZX screen row is 32 bytes of bitmap and 4 of attributes.
+        int width, height;
+        long bytes;
+        pictureSize(geometry, &width, &height, &bytes);
+        return count * bytes / ((long)width * height);
+    }
+    
+    if (isTileFormat(geometry)) {
+        return tileFormatBits(geometry->layout) * count / 8;
+    }
+    
+    if (isPlanar(geometry)) {
+        // bitsPerPixel is regarded as bitsPerPlane in Planer Mode.
+        long n = geometry->bitsPerPixel / 8 * geometry->planeCount;
+        if (geometry->alphaPlane) {
+            n += geometry->bitsPerPixel / 8;
+        }
+        return n * (count / geometry->bitsPerPixel);
+    }
+    
+    if (geometry->bitsPerPixel == 24 && geometry->alphaPlane) {
+        return 4 * count;
+    }
+    return geometry->bitsPerPixel * count / 8;
+}
+
+/*
+ Image data is stored as a sequence of blocks, each followed by padding bytes.
+ A block is a tile when tiled, else a single unit, or a whole line when there is no padding.
+ A block is a whole picture for ZX screens and C64 bitmaps, and a tile for console tiles.
+ */
+static void blockSize(const RenderGeometry *geometry, int *width, int *height) {
+    int unit = unitWidth(geometry);
+    long bytes;
+    
+    if (pictureSize(geometry, width, height, &bytes)) return;
+    
+    if (isTileFormat(geometry)) {
+        *width = TILE_FORMAT_SIZE;
+        *height = TILE_FORMAT_SIZE;
+        return;
+    }
+    
+    if (isTiled(geometry)) {
+        *width = geometry->tileWidth / unit * unit;
+        if (*width == 0) *width = unit;
+        *height = geometry->tileHeight;
+        return;
+    }
+    
+    *width = geometry->padding ? unit : geometry->width / unit * unit;
+    if (*width == 0) *width = unit;
+    *height = 1;
+}
+
+// The color planes of a masked image, rendered as the top half.
+static RenderGeometry maskedImageGeometry(const RenderGeometry *geometry) {
+    RenderGeometry image = *geometry;
+    image.height = geometry->height / 2;
+    image.alphaPlane = false;
+    image.maskPlane = false;
+    image.padding = 0;
+    image.tileWidth = 1;
+    image.tileHeight = 1;
+    return image;
+}
+
+static void renderBlocks(const RenderGeometry *geometry, const void *table, const uint8_t *bytes, uint32_t *pixel, long stride, RowDecoder decoder) {
+    int w, h;
+    blockSize(geometry, &w, &h);
+    
+    for (int r = 0; r + h <= geometry->height; r += h) {
+        for (int c = 0; c + w <= geometry->width; c += w) {
+            for (int y = 0; y < h; y++) {
+                bytes = decoder(geometry, table, bytes, pixel + (r + y) * stride + c, w);
+            }
+            bytes += geometry->padding;
+        }
+    }
+}
+
+/*
+ Images are decoded in horizontal bands of whole blocks, so each band can work out where
+ its data starts and be decoded on a thread of its own. A masked image is a single band
+ as its mask plane follows the color planes of every row.
+ */
+typedef struct {
+    const RenderGeometry *geometry;
+    const RenderPalette *palette;
+    const RenderLookup *lookup;
+    const uint32_t *colors;
+    const uint8_t *bytes;
+    uint8_t *index;
+    const uint8_t *indices;
+    long indexStride;
+    uint32_t *pixel;
+    long stride;
+    int width;
+    int bandHeight;
+} Bands;
+
+static size_t bandCount(const RenderGeometry *geometry, int rowsPerBlock, Bands *bands) {
+    if (geometry->height < 1) return 0;
+    
+    long blocks = geometry->height / rowsPerBlock;
+    long count = (long)geometry->width * geometry->height / PIXELS_PER_BAND;
+    long limit = (long)parallelThreadCount() * BANDS_PER_THREAD;
+    
+    if (count > limit) count = limit;
+    if (count > blocks) count = blocks;
+    if (count < 1 || (geometry->maskPlane && isPlanar(geometry))) count = 1;
+    
+    bands->bandHeight = (int)((blocks + count - 1) / count) * rowsPerBlock;
+    if (bands->bandHeight < 1 || count == 1) bands->bandHeight = geometry->height;
+    return (size_t)((geometry->height + bands->bandHeight - 1) / bands->bandHeight);
+}
+
+// The geometry of a band and the first of its source bytes, found from the bytes of the bands above it.
+static const uint8_t *bandGeometry(const Bands *bands, size_t index, RenderGeometry *band) {
+    RenderGeometry above = *bands->geometry;
+    above.height = (int)index * bands->bandHeight;
+    
+    *band = *bands->geometry;
+    band->height = bands->geometry->height - above.height;
+    if (band->height > bands->bandHeight) band->height = bands->bandHeight;
+    
+    return bands->bytes + (above.height ? bytesPerImage(&above) : 0);
+}
+
+static int blockHeight(const RenderGeometry *geometry) {
+    int w, h;
+    blockSize(geometry, &w, &h);
+    return h;
+}
+
+// MARK: - Row Decoders
+
+static const uint8_t *packed1BitRow(const RenderGeometry *geometry, const void *table, const uint8_t *bytes, uint32_t *pixel, int count) {
+    const RenderLookup *lookup = table;
+    for (int c = 0; c < count; c += 8) {
+        memcpy(pixel + c, lookup->pixel[*bytes++], 8 * sizeof(uint32_t));
+    }
+    return bytes;
+}
+
+static const uint8_t *packed2BitRow(const RenderGeometry *geometry, const void *table, const uint8_t *bytes, uint32_t *pixel, int count) {
+    const RenderLookup *lookup = table;
+    for (int c = 0; c < count; c += 4) {
+        memcpy(pixel + c, lookup->pixel[*bytes++], 4 * sizeof(uint32_t));
+    }
+    return bytes;
+}
+
+static const uint8_t *packed4BitRow(const RenderGeometry *geometry, const void *table, const uint8_t *bytes, uint32_t *pixel, int count) {
+    const RenderLookup *lookup = table;
+    for (int c = 0; c < count; c += 2) {
+        memcpy(pixel + c, lookup->pixel[*bytes++], 2 * sizeof(uint32_t));
+    }
+    return bytes;
+}
+
+static const uint8_t *packed8BitRow(const RenderGeometry *geometry, const void *table, const uint8_t *bytes, uint32_t *pixel, int count) {
+    const RenderLookup *lookup = table;
+    for (int c = 0; c < count; c++) {
+        pixel[c] = lookup->pixel[*bytes++][0];
+    }
+    return bytes;
+}
+
+static uint32_t toColorFromRGB555(uint16_t color) {
+    // [A0 R4 R3 R2 R1 R0 G4 G3] | [G2 G1 G0 B4 B3 B2 B1 B0]
+    
+    uint32_t r = color & 0b0111110000000000;
+    uint32_t g = color & 0b0000001111100000;
+    uint32_t b = color & 0b0000000000011111;
+    
+    uint32_t rgb = (r >> 7) | (g << 6) | (b << 19);
+    // [A7...0 B7...0 G7...0 R7...0]
+    return 0xFF000000 | rgb | ((rgb >> 5) & 0x070707);
+}
+
+static uint32_t toColorFromRGB565(uint16_t color) {
+    // [R4 R3 R2 R1 R0 G5 G4 G3] | [G2 G1 G0 B4 B3 B2 B1 B0]
+    
+    uint32_t r = color & 0b1111100000000000;
+    uint32_t g = color & 0b0000011111100000;
+    uint32_t b = color & 0b0000000000011111;
+    
+    uint32_t rgb = (r >> 8) | (g << 5) | (b << 19);
+    // [A7...0 B7...0 G7...0 R7...0]
+    return 0xFF000000 | rgb | ((rgb >> 5) & 0x070707);
+}
+
+static uint32_t toColorFromRGBA555(uint16_t color) {
+    // [R4 R3 R2 R1 R0 G4 G3 G2] | [G1 G0 B4 B3 B2 B1 B0 A0]
+    
+    uint32_t a = color & 0b0000000000000001;
+    uint32_t r = color & 0b1111100000000000;
+    uint32_t g = color & 0b0000011111000000;
+    uint32_t b = color & 0b0000000000111110;
+    
+    uint32_t rgb = (r >> 8) | (g << 5) | (b << 18);
+    // [A7...0 B7...0 G7...0 R7...0]
+    return (a * 0xFF000000) | rgb | ((rgb >> 5) & 0x070707);
+}
+
+static uint32_t toColorFromARGB555(uint16_t color) {
+    // [A0 R4 R3 R2 R1 R0 G4 G3] | [G2 G1 G0 B4 B3 B2 B1 B0]
+    
+    uint32_t a = color & 0b1000000000000000;
+    uint32_t r = color & 0b0111110000000000;
+    uint32_t g = color & 0b0000001111100000;
+    uint32_t b = color & 0b0000000000011111;
+    
+    uint32_t rgb = (r >> 7) | (g << 6) | (b << 19);
+    // [A7...0 B7...0 G7...0 R7...0]
+    return (a * 0x1FE00) | rgb | ((rgb >> 5) & 0x070707);
+}
+
+static uint32_t toColorFromBGR555(uint16_t color) {
+    // [A0 B4 B3 B2 B1 B0 G4 G3] | [G2 G1 G0 R4 R3 R2 R1 R0]
+    
+    uint32_t r = color & 0b0000000000011111;
+    uint32_t g = color & 0b0000001111100000;
+    uint32_t b = color & 0b0111110000000000;
+    
+    uint32_t rgb = (r << 3) | (g << 6) | (b << 9);
+    // [A7...0 B7...0 G7...0 R7...0]
+    return 0xFF000000 | rgb | ((rgb >> 5) & 0x070707);
+}
+
+static uint32_t toColorFromBGR565(uint16_t color) {
+    // [B4 B3 B2 B1 B0 G5 G4 G3] | [G2 G1 G0 R4 R3 R2 R1 R0]
+    
+    uint32_t r = color & 0b0000000000011111;
+    uint32_t g = color & 0b0000011111100000;
+    uint32_t b = color & 0b1111100000000000;
+    
+    uint32_t rgb = (r << 3) | (g << 5) | (b << 8);
+    // [A7...0 B7...0 G7...0 R7...0]
+    return 0xFF000000 | rgb | ((rgb >> 5) & 0x070707);
+}
+
+static uint32_t toColorFromRGB444(uint16_t color) {
+    // [xx xx xx xx R3 R2 R1 R0] | [G3 G2 G1 G0 B3 B2 B1 B0]
+    
+    uint32_t r = color & 0b0000111100000000;
+    uint32_t g = color & 0b0000000011110000;
+    uint32_t b = color & 0b0000000000001111;
+    
+    uint32_t rgb = (r >> 8) | (g << 4) | (b << 16);
+    // [A7...0 B7...0 G7...0 R7...0]
+    return 0xFF000000 | rgb | (rgb << 4);
+}
+
+static uint32_t toColorFromARGB4444(uint16_t color) {
+    // [A3 A2 A1 A0 R3 R2 R1 R0] | [G3 G2 G1 G0 B3 B2 B1 B0]
+    
+    uint32_t a = color & 0b1111000000000000;
+    uint32_t r = color & 0b0000111100000000;
+    uint32_t g = color & 0b0000000011110000;
+    uint32_t b = color & 0b0000000000001111;
+    
+    uint32_t argb = (a << 12) | (r >> 8) | (g << 4) | (b << 16);
+    // [A7...0 B7...0 G7...0 R7...0]
+    return argb | (argb << 4);
+}
+
+static uint32_t directColor(const RenderGeometry *geometry, uint16_t channels) {
+    uint32_t color;
+    
+    switch (geometry->pixelFormat) {
+        case RenderPixelFormatRGB565:
+            color = toColorFromRGB565(channels);
+            break;
+            
+        case RenderPixelFormatRGBA555:
+            color = toColorFromRGBA555(channels);
+            break;
+            
+        case RenderPixelFormatARGB555:
+            color = toColorFromARGB555(channels);
+            break;
+            
+        case RenderPixelFormatBGR555:
+            color = toColorFromBGR555(channels);
+            break;
+            
+        case RenderPixelFormatBGR565:
+            color = toColorFromBGR565(channels);
+            break;
+            
+        case RenderPixelFormatRGB444:
+            color = toColorFromRGB444(channels);
+            break;
+            
+        case RenderPixelFormatARGB4444:
+            color = toColorFromARGB4444(channels);
+            break;
+            
+        default:
+            color = toColorFromRGB555(channels);
+            break;
+    }
+    
+    if (geometry->alphaPlane) {
+        color |= 0xFF000000;
+    }
+    
+    return color;
+}
+
+// Only used when the direct color table could not be allocated.
+static const uint8_t *packed16BitRow(const RenderGeometry *geometry, const void *table, const uint8_t *bytes, uint32_t *pixel, int count) {
+    for (int c = 0; c < count; c++) {
+        pixel[c] = directColor(geometry, planeWord(geometry, bytes));
+        bytes += 2;
+    }
+    return bytes;
+}
+
+static const uint8_t *packed16BitTableRow(const RenderGeometry *geometry, const void *table, const uint8_t *bytes, uint32_t *pixel, int count) {
+    wordsToPixels(bytes, table, pixel, count);
+    return bytes + 2 * count;
+}
+
+static const uint8_t *packed24BitRow(const RenderGeometry *geometry, const void *table, const uint8_t *bytes, uint32_t *pixel, int count) {
+    for (int c = 0; c < count; c++) {
+        pixel[c] = (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | 0xFF000000;
+        bytes += 3;
+    }
+    return bytes;
+}
+
+static const uint8_t *packed32BitRow(const RenderGeometry *geometry, const void *table, const uint8_t *bytes, uint32_t *pixel, int count) {
+    for (int c = 0; c < count; c++) {
+        pixel[c] = (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+        bytes += 4;
+    }
+    return bytes;
+}
+
+/*
+ Atari ST/Amiga interleaved bitplanes, each group of bitsPerPlane pixels is stored as
+ [alpha plane] plane 0, plane 1 ... plane n. A set bit in the alpha plane marks a
+ transparent pixel, as is color index 0 whenever there is an alpha plane.
+ 
+ Groups are gathered as 16 pixel words, two groups at a time for 8-bit planes, in
+ batches of up to 256 pixels. Returns the bytes following the batch, the number of
+ groups and the number of pixels gathered.
+ */
+static const uint8_t *gatherPlanes(const RenderGeometry *geometry, const uint8_t *bytes, uint16_t planes[16][8], uint16_t alpha[16], int count, int *groupCount, int *pixelCount) {
+    int bytesPerPlane = geometry->bitsPerPixel / 8;
+    int groups = 0;
+    int n = 0;
+    
+    for (; groups < 16 && n < count; groups++) {
+        uint16_t *plane = planes[groups];
+        
+        if (bytesPerPlane == 2) {
+            alpha[groups] = 0;
+            if (geometry->alphaPlane) {
+                alpha[groups] = planeWord(geometry, bytes);
+                bytes += 2;
+            }
+            for (int p = 0; p < geometry->planeCount; p++) {
+                plane[p] = planeWord(geometry, bytes);
+                bytes += 2;
+            }
+            n += 16;
+            continue;
+        }
+        
+        alpha[groups] = 0;
+        memset(plane, 0, sizeof(planes[0]));
+        for (int shift = 8; shift >= 0 && n < count; shift -= 8) {
+            if (geometry->alphaPlane) {
+                alpha[groups] |= *bytes++ << shift;
+            }
+            for (int p = 0; p < geometry->planeCount; p++) {
+                plane[p] |= *bytes++ << shift;
+            }
+            n += 8;
+        }
+    }
+    
+    *groupCount = groups;
+    *pixelCount = n;
+    return bytes;
+}
+
+static const uint8_t *planarRow(const RenderGeometry *geometry, const void *table, const uint8_t *bytes, uint32_t *pixel, int count) {
+    const uint32_t *colors = table;
+    uint16_t planes[16][8];
+    uint16_t alpha[16];
+    uint8_t indices[256];
+    
+    for (int c = 0; c < count; ) {
+        int groups, n;
+        
+        bytes = gatherPlanes(geometry, bytes, planes, alpha, count - c, &groups, &n);
+        bitplanesToIndices(planes, groups, geometry->planeCount, indices);
+        if (geometry->alphaPlane) {
+            indicesToPixelsWithAlpha(indices, alpha, colors, pixel + c, n);
+        } else {
+            indicesToPixels(indices, colors, pixel + c, n);
+        }
+        
+        c += n;
+    }
+    return bytes;
+}
+
+// MARK: - Index Row Decoders
+
+/*
+ Decodes count palette indices of a single row, used by the index buffer stage so
+ that a palette change only has to map indices to pixels again.
+ */
+typedef const uint8_t *(*IndexRowDecoder)(const RenderGeometry *geometry, const uint8_t *bytes, uint8_t *index, int count);
+
+static void renderIndexBlocks(const RenderGeometry *geometry, const uint8_t *bytes, uint8_t *index, long stride, IndexRowDecoder decoder) {
+    int w, h;
+    blockSize(geometry, &w, &h);
+    
+    for (int r = 0; r + h <= geometry->height; r += h) {
+        for (int c = 0; c + w <= geometry->width; c += w) {
+            for (int y = 0; y < h; y++) {
+                bytes = decoder(geometry, bytes, index + (r + y) * stride + c, w);
+            }
+            bytes += geometry->padding;
+        }
+    }
+}
+
+static const uint8_t *packed1BitIndexRow(const RenderGeometry *geometry, const uint8_t *bytes, uint8_t *index, int count) {
+    for (int c = 0; c < count; c += 8) {
+        uint8_t data = *bytes++;
+        for (int n = 0; n < 8; n++) {
+            index[c + n] = data >> (7 - n) & 1;
+        }
+    }
+    return bytes;
+}
+
+static const uint8_t *packed2BitIndexRow(const RenderGeometry *geometry, const uint8_t *bytes, uint8_t *index, int count) {
+    for (int c = 0; c < count; c += 4) {
+        uint8_t data = *bytes++;
+        for (int n = 0; n < 4; n++) {
+            index[c + n] = data >> (6 - n * 2) & 3;
+        }
+    }
+    return bytes;
+}
+
+static const uint8_t *packed4BitIndexRow(const RenderGeometry *geometry, const uint8_t *bytes, uint8_t *index, int count) {
+    for (int c = 0; c < count; c += 2) {
+        uint8_t data = *bytes++;
+        index[c] = data >> 4;
+        index[c + 1] = data & 15;
+    }
+    return bytes;
+}
+
+static const uint8_t *packed8BitIndexRow(const RenderGeometry *geometry, const uint8_t *bytes, uint8_t *index, int count) {
+    memcpy(index, bytes, count);
+    return bytes + count;
+}
+
+static const uint8_t *planarIndexRow(const RenderGeometry *geometry, const uint8_t *bytes, uint8_t *index, int count) {
+    uint16_t planes[16][8];
+    uint16_t alpha[16];
+    uint8_t indices[256];
+    
+    for (int c = 0; c < count; ) {
+        int groups, n;
+        
+        bytes = gatherPlanes(geometry, bytes, planes, alpha, count - c, &groups, &n);
+        bitplanesToIndices(planes, groups, geometry->planeCount, indices);
+        memcpy(index + c, indices, n);
+        c += n;
+    }
+    return bytes;
+}
+
+// MARK: - Public Functions
+
+void defaultPalette(RenderPalette *palette) {
+    /*
+     3 bits in red and green channels give us 8 values.
+     When scaled to the 0–255 range we get:
+     */
+    static const uint32_t tbl[] = {0, 36, 72, 109, 145, 182, 218, 255};
+    
+    for (int rgb = 0; rgb < 256; rgb++) {
+        uint32_t r = (rgb & 0b11100000) >> 5;
+        uint32_t g = (rgb & 0b00011100) >> 2;
+        uint32_t b = (rgb & 0b00000011) << 1;
+        if (rgb & 0b00000010) b |= 0b00000001;
+        
+        palette->rgb[rgb] = tbl[r] | tbl[g] << 8 | tbl[b] << 16 | 0xFF000000;
+    }
+    
+    palette->colorCount = 256;
+    palette->transparentIndex = 0xE3;
+}
+
+void buildLookup(RenderLookup *lookup, const RenderGeometry *geometry, const RenderPalette *palette) {
+    int bits = geometry->bitsPerPixel;
+    
+    lookup->bitsPerPixel = bits;
+    lookup->alphaPlane = geometry->alphaPlane;
+    if (bits != 1 && bits != 2 && bits != 4 && bits != 8) return;
+    
+    for (int byte = 0; byte < 256; byte++) {
+        // Leftmost pixel in the most significant bits.
+        for (int n = 0; n < 8 / bits; n++) {
+            unsigned index = byte >> (8 - bits - n * bits) & ((1 << bits) - 1);
+            if (bits == 1) {
+                // Monochrome, set bits are white and clear bits transparent.
+                lookup->pixel[byte][n] = index ? 0xffffffff : 0;
+            } else {
+                lookup->pixel[byte][n] = indexedColor(geometry, palette, index);
+            }
+        }
+    }
+}
+
+bool isLookupForGeometry(const RenderLookup *lookup, const RenderGeometry *geometry) {
+    return lookup->bitsPerPixel == geometry->bitsPerPixel && lookup->alphaPlane == geometry->alphaPlane;
+}
+
+const uint32_t *directColorTable(const RenderGeometry *geometry) {
+    static _Atomic(uint32_t *) tables[PIXEL_FORMAT_COUNT][2][2];
+    
+    int format = (unsigned)geometry->pixelFormat < PIXEL_FORMAT_COUNT ? geometry->pixelFormat : RenderPixelFormatRGB555;
+    _Atomic(uint32_t *) *slot = &tables[format][geometry->bigEndian ? 1 : 0][geometry->alphaPlane ? 1 : 0];
+    
+    uint32_t *table = atomic_load_explicit(slot, memory_order_acquire);
+    if (table) return table;
+    
+    table = malloc(65536 * sizeof(uint32_t));
+    if (!table) return NULL;
+    
+    for (int word = 0; word < 65536; word++) {
+        uint8_t bytes[2] = {word & 255, word >> 8};
+        table[word] = directColor(geometry, planeWord(geometry, bytes));
+    }
+    
+    // Another thread may have got there first, in which case its table is the one kept.
+    uint32_t *expected = NULL;
+    if (atomic_compare_exchange_strong_explicit(slot, &expected, table, memory_order_acq_rel, memory_order_acquire) == false) {
+        free(table);
+        table = expected;
+    }
+    
+    return table;
+}
+
+long bytesPerLine(const RenderGeometry *geometry) {
+    return bytesForPixels(geometry, geometry->width);
+}
+
+bool pictureSize(const RenderGeometry *geometry, int *width, int *height, long *bytes) {
+    switch (geometry->layout) {
+        case RenderLayoutZXScreen:
+            *width = ZX_SCREEN_WIDTH;
+            *height = ZX_SCREEN_HEIGHT;
+            *bytes = ZX_SCREEN_BYTES;
+            return true;
+            
+        case RenderLayoutC64Hires:
+            *width = C64_BITMAP_WIDTH;
+            *height = C64_BITMAP_HEIGHT;
+            *bytes = C64_HIRES_BYTES;
+            return true;
+            
+        case RenderLayoutC64Multicolor:
+            *width = C64_MULTICOLOR_WIDTH;
+            *height = C64_BITMAP_HEIGHT;
+            *bytes = C64_MULTICOLOR_BYTES;
+            return true;
+            
+        default:
+            return false;
+    }
+}
+
+long bytesPerImage(const RenderGeometry *geometry) {
+    int w, h;
+    long bytes;
+    
+    if (pictureSize(geometry, &w, &h, &bytes)) {
+        // Not every picture is a whole number of bytes a row.
+        return (long)(geometry->height / h) * (bytes + geometry->padding);
+    }
+    
+    if (geometry->maskPlane && isPlanar(geometry)) {
+        // Color planes for the top half followed by a single mask plane for the bottom half.
+        long groups = geometry->width / geometry->bitsPerPixel;
+        return groups * (geometry->height / 2) * 2 * (geometry->planeCount + 1);
+    }
+    
+    blockSize(geometry, &w, &h);
+    
+    long blocks = (long)(geometry->width / w) * (long)(geometry->height / h);
+    return blocks * (bytesForPixels(geometry, w) * h + geometry->padding);
+}
+
+bool isValidGeometry(const RenderGeometry *geometry) {
+    if (geometry->width < 1 || geometry->height < 1) return false;
+    if (geometry->tileWidth < 1 || geometry->tileHeight < 1) return false;
+    if (isPicture(geometry)) {
+        int w, h;
+        long bytes;
+        pictureSize(geometry, &w, &h, &bytes);
+        return geometry->width == w;
+    }
+    
+    if (isTileFormat(geometry)) {
+        return geometry->width >= TILE_FORMAT_SIZE;
+    }
+    
+    if (isPlanar(geometry)) {
+        if (geometry->planeCount > 8) return false;
+        if (geometry->bitsPerPixel != 8 && geometry->bitsPerPixel != 16) return false;
+        if (geometry->maskPlane && geometry->bitsPerPixel != 16) return false;
+        return geometry->width >= geometry->bitsPerPixel;
+    }
+    
+    switch (geometry->bitsPerPixel) {
+        case 1:
+        case 2:
+        case 4:
+            return geometry->width >= 8 / geometry->bitsPerPixel;
+            
+        case 8:
+        case 16:
+        case 24:
+        case 32:
+            return true;
+            
+        default:
+            return false;
+    }
+}
+
+void packed1BitToPixelData(const RenderGeometry *geometry, const RenderLookup *lookup, const uint8_t *bytes, uint32_t *pixel, long stride) {
+    renderBlocks(geometry, lookup, bytes, pixel, stride, packed1BitRow);
+}
+
+void packed2BitToPixelData(const RenderGeometry *geometry, const RenderLookup *lookup, const uint8_t *bytes, uint32_t *pixel, long stride) {
+    renderBlocks(geometry, lookup, bytes, pixel, stride, packed2BitRow);
+}
+
+void packed4BitToPixelData(const RenderGeometry *geometry, const RenderLookup *lookup, const uint8_t *bytes, uint32_t *pixel, long stride) {
+    renderBlocks(geometry, lookup, bytes, pixel, stride, packed4BitRow);
+}
+
+void packed8BitToPixelData(const RenderGeometry *geometry, const RenderLookup *lookup, const uint8_t *bytes, uint32_t *pixel, long stride) {
+    renderBlocks(geometry, lookup, bytes, pixel, stride, packed8BitRow);
+}
+
+void packed16BitToPixelData(const RenderGeometry *geometry, const uint8_t *bytes, uint32_t *pixel, long stride) {
+    const uint32_t *table = directColorTable(geometry);
+    renderBlocks(geometry, table, bytes, pixel, stride, table ? packed16BitTableRow : packed16BitRow);
+}
+
+void packed24BitToPixelData(const RenderGeometry *geometry, const uint8_t *bytes, uint32_t *pixel, long stride) {
+    renderBlocks(geometry, NULL, bytes, pixel, stride, packed24BitRow);
+}
+
+void packed32BitToPixelData(const RenderGeometry *geometry, const uint8_t *bytes, uint32_t *pixel, long stride) {
+    renderBlocks(geometry, NULL, bytes, pixel, stride, packed32BitRow);
+}
+
+/*
+ Colors of the planar kernels. With an alpha plane, color index 0 is transparent as well
+ as the pixels the alpha plane marks, its RGB kept as the original kernels did.
+ */
+static void planarColors(const RenderGeometry *geometry, const RenderPalette *palette, uint32_t colors[256]) {
+    memcpy(colors, palette->rgb, sizeof(palette->rgb));
+    if (geometry->alphaPlane) colors[0] &= 0x00FFFFFF;
+}
+
+void planer8BitToPixelData(const RenderGeometry *geometry, const RenderPalette *palette, const uint8_t *bytes, uint32_t *pixel, long stride) {
+    uint32_t colors[256];
+    planarColors(geometry, palette, colors);
+    renderBlocks(geometry, colors, bytes, pixel, stride, planarRow);
+}
+
+void planer16BitToPixelData(const RenderGeometry *geometry, const RenderPalette *palette, const uint8_t *bytes, uint32_t *pixel, long stride) {
+    uint32_t colors[256];
+    planarColors(geometry, palette, colors);
+    renderBlocks(geometry, colors, bytes, pixel, stride, planarRow);
+}
+
+/*
+ Console tiles a row of tiles at a time, each tile decoded by the kernel generated from its descriptor.
+ */
+void tilePlanesToPixelData(const RenderGeometry *geometry, const RenderPalette *palette, const uint8_t *bytes, uint32_t *pixel, long stride) {
+    uint32_t colors[256];
+    int columns = geometry->width / TILE_FORMAT_SIZE;
+    long bytesPerRow = (long)columns * (tileFormatBits(geometry->layout) * TILE_FORMAT_SIZE + geometry->padding);
+    
+    buildIndexColors(geometry, palette, colors);
+    for (int r = 0; r + TILE_FORMAT_SIZE <= geometry->height; r += TILE_FORMAT_SIZE) {
+        tilesToPixelData(geometry->layout, bytes, columns, geometry->padding, colors, pixel + r * stride, stride);
+        bytes += bytesPerRow;
+    }
+}
+
+void mask16BitToPixelData(const RenderGeometry *geometry, const RenderPalette *palette, const uint8_t *bytes, uint32_t *pixel, long stride) {
+    RenderGeometry image = maskedImageGeometry(geometry);
+    
+    // Color planes, top half.
+    uint32_t colors[256];
+    planarColors(&image, palette, colors);
+    renderBlocks(&image, colors, bytes, pixel, stride, planarRow);
+    bytes += bytesPerImage(&image);
+    
+    // Mask plane, bottom half.
+    pixel += image.height * stride;
+    for (int r = 0; r < image.height; r++) {
+        for (int c = 0; c + 16 <= image.width; c += 16) {
+            uint16_t plane = planeWord(geometry, bytes);
+            for (int n = 15; n >= 0; n--) {
+                pixel[r * stride + c + 15 - n] = palette->rgb[plane & (1 << n) ? 15 : 0];
+            }
+            bytes += 2;
+        }
+    }
+}
+
+/*
+ Decodes the columns x to x + width of the pictures from row y to y + height, whole pictures,
+ into pixels when pixel is set, else into indices.
+ */
+static void renderPictures(const RenderGeometry *geometry, const RenderPalette *palette, const uint8_t *bytes, int x, int y, int width, int height, uint32_t *pixel, uint8_t *index, long stride) {
+    uint32_t colors[256];
+    int w, h;
+    long bytesPerPicture;
+    
+    pictureSize(geometry, &w, &h, &bytesPerPicture);
+    bytesPerPicture += geometry->padding;
+    if (pixel) buildIndexColors(geometry, palette, colors);
+    
+    bytes += (long)(y / h) * bytesPerPicture;
+    for (int r = 0; r + h <= height; r += h) {
+        switch (geometry->layout) {
+            case RenderLayoutZXScreen:
+                if (pixel) zxScreenToPixelData(bytes, colors, x, width, pixel + r * stride, stride);
+                else zxScreenToIndices(bytes, x, width, index + r * stride, stride);
+                break;
+                
+            case RenderLayoutC64Hires:
+                if (pixel) c64HiresToPixelData(bytes, colors, x, width, pixel + r * stride, stride);
+                else c64HiresToIndices(bytes, x, width, index + r * stride, stride);
+                break;
+                
+            case RenderLayoutC64Multicolor:
+                if (pixel) c64MulticolorToPixelData(bytes, colors, x, width, pixel + r * stride, stride);
+                else c64MulticolorToIndices(bytes, x, width, index + r * stride, stride);
+                break;
+                
+            default:
+                return;
+        }
+        bytes += bytesPerPicture;
+    }
+}
+
+static void renderImage(const RenderGeometry *geometry, const RenderPalette *palette, const RenderLookup *lookup, const uint8_t *bytes, uint32_t *pixel, long stride) {
+    if (isPicture(geometry)) {
+        renderPictures(geometry, palette, bytes, 0, 0, geometry->width, geometry->height, pixel, NULL, stride);
+        return;
+    }
+    
+    if (isTileFormat(geometry)) {
+        tilePlanesToPixelData(geometry, palette, bytes, pixel, stride);
+        return;
+    }
+    
+    if (isPlanar(geometry)) {
+        if (geometry->bitsPerPixel == 8) {
+            planer8BitToPixelData(geometry, palette, bytes, pixel, stride);
+        }
+        if (geometry->bitsPerPixel == 16) {
+            if (geometry->maskPlane) {
+                mask16BitToPixelData(geometry, palette, bytes, pixel, stride);
+            } else {
+                planer16BitToPixelData(geometry, palette, bytes, pixel, stride);
+            }
+        }
+        return;
+    }
+    
+    switch (geometry->bitsPerPixel) {
+        case 1:
+            packed1BitToPixelData(geometry, lookup, bytes, pixel, stride);
+            break;
+            
+        case 2:
+            packed2BitToPixelData(geometry, lookup, bytes, pixel, stride);
+            break;
+            
+        case 4:
+            packed4BitToPixelData(geometry, lookup, bytes, pixel, stride);
+            break;
+            
+        case 8:
+            packed8BitToPixelData(geometry, lookup, bytes, pixel, stride);
+            break;
+            
+        case 16:
+            packed16BitToPixelData(geometry, bytes, pixel, stride);
+            break;
+            
+        case 24:
+            if (geometry->alphaPlane) {
+                packed32BitToPixelData(geometry, bytes, pixel, stride);
+            } else {
+                packed24BitToPixelData(geometry, bytes, pixel, stride);
+            }
+            break;
+            
+        case 32:
+            packed32BitToPixelData(geometry, bytes, pixel, stride);
+            break;
+            
+        default:
+            break;
+    }
+}
+
+static void renderBand(void *context, size_t index) {
+    const Bands *bands = context;
+    RenderGeometry band;
+    const uint8_t *bytes = bandGeometry(bands, index, &band);
+    
+    renderImage(&band, bands->palette, bands->lookup, bytes, bands->pixel + index * bands->bandHeight * bands->stride, bands->stride);
+}
+
+void renderToPixelData(const RenderGeometry *geometry, const RenderPalette *palette, const RenderLookup *lookup, const uint8_t *bytes, uint32_t *pixel, long stride) {
+    RenderLookup local;
+    
+    if (isValidGeometry(geometry) == false) return;
+    
+    // Built once here, and shared by every band.
+    if (isPlanar(geometry) == false && geometry->layout == RenderLayoutLinear && geometry->bitsPerPixel <= 8 && (lookup == NULL || isLookupForGeometry(lookup, geometry) == false)) {
+        buildLookup(&local, geometry, palette);
+        lookup = &local;
+    }
+    
+    Bands bands = {
+        .geometry = geometry,
+        .palette = palette,
+        .lookup = lookup,
+        .bytes = bytes,
+        .pixel = pixel,
+        .stride = stride
+    };
+    parallelFor(bandCount(geometry, blockHeight(geometry), &bands), &bands, renderBand);
+}
+
+// MARK: - Index Buffer
+
+bool isIndexedGeometry(const RenderGeometry *geometry) {
+    if (isPicture(geometry) || isTileFormat(geometry)) return true;
+    
+    if (isPlanar(geometry)) {
+        // A transparent pixel in the alpha plane has no palette index of its own.
+        return geometry->alphaPlane == false || geometry->maskPlane;
+    }
+    return geometry->bitsPerPixel <= 8;
+}
+
+void buildIndexColors(const RenderGeometry *geometry, const RenderPalette *palette, uint32_t *colors) {
+    if (geometry->layout == RenderLayoutZXScreen) {
+        zxScreenColors(palette->rgb, geometry->flashInverted, colors);
+        return;
+    }
+    
+    if (isPicture(geometry)) {
+        // C64 color numbers.
+        for (unsigned index = 0; index < 256; index++) {
+            colors[index] = palette->rgb[index & 0x0f];
+        }
+        return;
+    }
+    
+    for (unsigned index = 0; index < 256; index++) {
+        if (isPlanar(geometry)) {
+            colors[index] = palette->rgb[index];
+        } else if (isTileFormat(geometry)) {
+            colors[index] = indexedColor(geometry, palette, index);
+        } else if (geometry->bitsPerPixel == 1) {
+            // Monochrome, set bits are white and clear bits transparent.
+            colors[index] = index ? 0xffffffff : 0;
+        } else {
+            colors[index] = indexedColor(geometry, palette, index);
+        }
+    }
+}
+
+static void renderIndices(const RenderGeometry *geometry, const uint8_t *bytes, uint8_t *index, long stride) {
+    if (isPicture(geometry)) {
+        renderPictures(geometry, NULL, bytes, 0, 0, geometry->width, geometry->height, NULL, index, stride);
+        return;
+    }
+    
+    if (isTileFormat(geometry)) {
+        int columns = geometry->width / TILE_FORMAT_SIZE;
+        long bytesPerRow = (long)columns * (tileFormatBits(geometry->layout) * TILE_FORMAT_SIZE + geometry->padding);
+        for (int r = 0; r + TILE_FORMAT_SIZE <= geometry->height; r += TILE_FORMAT_SIZE) {
+            tilesToIndices(geometry->layout, bytes, columns, geometry->padding, index + r * stride, stride);
+            bytes += bytesPerRow;
+        }
+        return;
+    }
+    
+    if (isPlanar(geometry) && geometry->maskPlane) {
+        RenderGeometry image = maskedImageGeometry(geometry);
+        
+        // Color planes, top half.
+        renderIndexBlocks(&image, bytes, index, stride, planarIndexRow);
+        bytes += bytesPerImage(&image);
+        
+        // Mask plane, bottom half.
+        index += image.height * stride;
+        for (int r = 0; r < image.height; r++) {
+            for (int c = 0; c + 16 <= image.width; c += 16) {
+                uint16_t plane = planeWord(geometry, bytes);
+                for (int n = 15; n >= 0; n--) {
+                    index[r * stride + c + 15 - n] = plane & (1 << n) ? 15 : 0;
+                }
+                bytes += 2;
+            }
+        }
+        return;
+    }
+    
+    if (isPlanar(geometry)) {
+        renderIndexBlocks(geometry, bytes, index, stride, planarIndexRow);
+        return;
+    }
+    
+    switch (geometry->bitsPerPixel) {
+        case 1:
+            renderIndexBlocks(geometry, bytes, index, stride, packed1BitIndexRow);
+            break;
+            
+        case 2:
+            renderIndexBlocks(geometry, bytes, index, stride, packed2BitIndexRow);
+            break;
+            
+        case 4:
+            renderIndexBlocks(geometry, bytes, index, stride, packed4BitIndexRow);
+            break;
+            
+        default:
+            renderIndexBlocks(geometry, bytes, index, stride, packed8BitIndexRow);
+            break;
+    }
+}
+
+static void renderIndexBand(void *context, size_t index) {
+    const Bands *bands = context;
+    RenderGeometry band;
+    const uint8_t *bytes = bandGeometry(bands, index, &band);
+    
+    renderIndices(&band, bytes, bands->index + index * bands->bandHeight * bands->indexStride, bands->indexStride);
+}
+
+void renderToIndices(const RenderGeometry *geometry, const uint8_t *bytes, uint8_t *index, long stride) {
+    if (isValidGeometry(geometry) == false || isIndexedGeometry(geometry) == false) return;
+    
+    Bands bands = {
+        .geometry = geometry,
+        .bytes = bytes,
+        .index = index,
+        .indexStride = stride
+    };
+    parallelFor(bandCount(geometry, blockHeight(geometry), &bands), &bands, renderIndexBand);
+}
+
+static void colorBand(void *context, size_t index) {
+    const Bands *bands = context;
+    int first = (int)index * bands->bandHeight;
+    int height = bands->geometry->height - first;
+    if (height > bands->bandHeight) height = bands->bandHeight;
+    
+    for (int r = first; r < first + height; r++) {
+        indicesToPixels(bands->indices + r * bands->indexStride, bands->colors, bands->pixel + r * bands->stride, bands->width);
+    }
+}
+
+void indicesToPixelData(const RenderGeometry *geometry, const uint32_t *colors, const uint8_t *index, long indexStride, uint32_t *pixel, long stride) {
+    int w, h;
+    int width, height;
+    
+    if (isValidGeometry(geometry) == false) return;
+    
+    // Only the pixels renderToIndices wrote to, whole blocks or whole groups of the masked image.
+    if (isPlanar(geometry) && geometry->maskPlane) {
+        width = geometry->width / 16 * 16;
+        height = geometry->height / 2 * 2;
+    } else {
+        blockSize(geometry, &w, &h);
+        width = geometry->width / w * w;
+        height = geometry->height / h * h;
+    }
+    
+    RenderGeometry rendered = *geometry;
+    rendered.height = height;
+    rendered.maskPlane = false;
+    
+    Bands bands = {
+        .geometry = &rendered,
+        .colors = colors,
+        .indices = index,
+        .indexStride = indexStride,
+        .pixel = pixel,
+        .stride = stride,
+        .width = width
+    };
+    parallelFor(bandCount(&rendered, 1, &bands), &bands, colorBand);
+}
+
+// MARK: - Regions
+
+/*
+ Where a region of the image is decoded to, pixels when pixel is set, else indices.
+ */
+typedef struct {
+    const RenderPalette *palette;
+    const RenderLookup *lookup;
+    uint32_t *pixel;
+    uint8_t *index;
+    long stride;
+} RegionTarget;
+
+static void renderRegionRows(const RenderGeometry *part, const uint8_t *bytes, const RegionTarget *target, long row) {
+    if (target->pixel) {
+        renderImage(part, target->palette, target->lookup, bytes, target->pixel + row * target->stride, target->stride);
+    } else {
+        renderIndices(part, bytes, target->index + row * target->stride, target->stride);
+    }
+}
+
+static void renderMaskRegion(const RenderGeometry *geometry, const uint8_t *bytes, int x, int y, int width, int height, const RegionTarget *target) {
+    RenderGeometry part = maskedImageGeometry(geometry);
+    long groups = geometry->width / 16;
+    long topBytes = bytesPerImage(&part);
+    int half = part.height;
+    
+    part.width = width;
+    part.height = 1;
+    
+    for (int r = y; r < y + height && r < half * 2; r++) {
+        if (r < half) {
+            // Color planes, top half.
+            renderRegionRows(&part, bytes + (r * groups + x / 16) * 2 * geometry->planeCount, target, r - y);
+            continue;
+        }
+        
+        // Mask plane, bottom half.
+        const uint8_t *plane = bytes + topBytes + ((r - half) * groups + x / 16) * 2;
+        for (int c = 0; c + 16 <= width; c += 16) {
+            uint16_t word = planeWord(geometry, plane);
+            for (int n = 15; n >= 0; n--) {
+                int index = word & (1 << n) ? 15 : 0;
+                if (target->pixel) {
+                    target->pixel[(r - y) * target->stride + c + 15 - n] = target->palette->rgb[index];
+                } else {
+                    target->index[(r - y) * target->stride + c + 15 - n] = index;
+                }
+            }
+            plane += 2;
+        }
+    }
+}
+
+static void renderRegion(const RenderGeometry *geometry, const uint8_t *bytes, int x, int y, int width, int height, const RegionTarget *target) {
+    int w, h;
+    
+    if (isValidGeometry(geometry) == false) return;
+    
+    regionAlignment(geometry, &w, &h);
+    if (x < 0 || y < 0 || x % w || y % h) return;
+    
+    // Whole blocks only, within the image.
+    if (width > geometry->width - x) width = geometry->width - x;
+    if (height > geometry->height - y) height = geometry->height - y;
+    width = width / w * w;
+    height = height / h * h;
+    if (width < 1 || height < 1) return;
+    
+    if (isPlanar(geometry) && geometry->maskPlane) {
+        renderMaskRegion(geometry, bytes, x, y, width, height, target);
+        return;
+    }
+    
+    if (isPicture(geometry)) {
+        renderPictures(geometry, target->palette, bytes, x, y, width, height, target->pixel, target->index, target->stride);
+        return;
+    }
+    
+    // Each row of blocks holds the blocks of every column in turn, so the blocks of a region are a run within it.
+    long columns = geometry->width / w;
+    long bytesPerBlock = bytesForPixels(geometry, w) * h + geometry->padding;
+    RenderGeometry part = *geometry;
+    part.width = width;
+    part.height = h;
+    
+    for (int r = 0; r < height; r += h) {
+        renderRegionRows(&part, bytes + ((y + r) / h * columns + x / w) * bytesPerBlock, target, r);
+    }
+}
+
+void regionAlignment(const RenderGeometry *geometry, int *width, int *height) {
+    // Any cell column of a picture can be decoded, but only whole pictures hold all of their rows.
+    if (isPicture(geometry)) {
+        long bytes;
+        pictureSize(geometry, width, height, &bytes);
+        *width = unitWidth(geometry);
+        return;
+    }
+    
+    if (isPlanar(geometry) && geometry->maskPlane) {
+        *width = 16;
+        *height = 1;
+        return;
+    }
+    
+    if (isTiled(geometry) || isTileFormat(geometry)) {
+        blockSize(geometry, width, height);
+        return;
+    }
+    
+    // Lines without padding are still a run of units, so they can be cut at any unit.
+    *width = unitWidth(geometry);
+    *height = 1;
+}
+
+void renderRegionToPixelData(const RenderGeometry *geometry, const RenderPalette *palette, const RenderLookup *lookup, const uint8_t *bytes, int x, int y, int width, int height, uint32_t *pixel, long stride) {
+    RegionTarget target = {
+        .palette = palette,
+        .lookup = lookup,
+        .pixel = pixel,
+        .stride = stride
+    };
+    RenderLookup local;
+    
+    if (isPlanar(geometry) == false && geometry->layout == RenderLayoutLinear && geometry->bitsPerPixel <= 8 && (lookup == NULL || isLookupForGeometry(lookup, geometry) == false)) {
+        buildLookup(&local, geometry, palette);
+        target.lookup = &local;
+    }
+    
+    renderRegion(geometry, bytes, x, y, width, height, &target);
+}
+
+void renderRegionToIndices(const RenderGeometry *geometry, const uint8_t *bytes, int x, int y, int width, int height, uint8_t *index, long stride) {
+    RegionTarget target = {
+        .index = index,
+        .stride = stride
+    };
+    
+    if (isIndexedGeometry(geometry) == false) return;
+    renderRegion(geometry, bytes, x, y, width, height, &target);
+}
@@ -0,0 +1,231 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef render_h
+#define render_h
+
+#include "common.h"
+
+/*
+ Portable C versions of the Image pixel kernels.
+ 
+ All kernels decode from a raw byte buffer into 32-bit pixels laid out as
+ [A7...0 B7...0 G7...0 R7...0], the same layout used by the SKMutableTexture.
+ The destination is addressed as pixel[row * stride + column], so a kernel can
+ write either into a tightly packed buffer (stride == width) or directly into a
+ rectangle of a larger texture.
+ 
+ renderToPixelData, renderToIndices and indicesToPixelData split large images into
+ horizontal bands of whole rows, or whole rows of tiles, and decode them on every core.
+ */
+
+typedef enum {
+    RenderPixelFormatRGB555,
+    RenderPixelFormatRGB565,
+    RenderPixelFormatRGBA555,
+    RenderPixelFormatARGB555,
+    RenderPixelFormatBGR555,
+    RenderPixelFormatBGR565,
+    RenderPixelFormatRGB444,
+    RenderPixelFormatARGB4444
+} RenderPixelFormat;
+
+typedef enum {
+    RenderLayoutLinear,         // Rows, or rows of tiles, one after another as described by the other fields
+    RenderLayoutZXScreen,       // ZX Spectrum screens of 6912 bytes stacked one above the other, 256 pixels wide
+    RenderLayoutC64Hires,       // Commodore 64 bitmaps and screen RAM of 9000 bytes, 320 pixels wide
+    RenderLayoutC64Multicolor,  // Commodore 64 bitmaps, screen RAM, color RAM and background of 10001 bytes, 160 double width pixels wide
+    RenderLayoutGameBoyTiles,   // 8x8 tiles of console bitplanes as described in tileformat.c, Game Boy and SNES 2bpp
+    RenderLayoutNESTiles,       // NES, two planes of 8 bytes
+    RenderLayoutSNES4BitTiles,  // SNES and PC Engine, two pairs of row interleaved planes
+    RenderLayoutSNES8BitTiles,  // SNES, four pairs of row interleaved planes
+    RenderLayoutMasterSystemTiles   // Master System and Game Gear, four row interleaved planes
+} RenderLayout;
+
+typedef struct {
+    int width;                  // Image width in pixels
+    int height;                 // Image height in pixels
+    int bitsPerPixel;           // When planeCount is greater than 1, bitsPerPixel is regarded as bitsPerPlane 8/16
+    int planeCount;             // Packed if value == 1, else Planar
+    bool alphaPlane;            // Alpha plane in planar mode, alpha channel in packed mode
+    bool maskPlane;
+    bool bigEndian;
+    RenderPixelFormat pixelFormat;    // Only used by 16-bit packed pixels
+    int tileWidth;
+    int tileHeight;
+    int padding;                // Bytes skipped after each tile, or after each byte, pixel or plane group when not tiled
+    RenderLayout layout;        // Other than RenderLayoutLinear only uses the width, height and padding, skipped after each picture or tile
+    bool flashInverted;         // ZX screens, FLASH cells show with ink and paper swapped
+} RenderGeometry;
+
+typedef struct {
+    uint32_t rgb[256];
+    int colorCount;
+    int transparentIndex;       // Only applied when alphaPlane is set, values above 255 disable transparency
+} RenderPalette;
+
+/*
+ Pixels for every possible source byte of 1, 2, 4 or 8-bit packed pixel data, in
+ display order and with transparency already applied, so a packed row decodes as
+ one table copy per byte. Only needs rebuilding when the palette, bitsPerPixel or
+ alphaPlane changes.
+ */
+typedef struct {
+    uint32_t pixel[256][8];
+    int bitsPerPixel;
+    bool alphaPlane;
+} RenderLookup;
+
+
+/* Set up for C function definitions, even when using C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /*
+     Fills the palette with the default 256 color R3 G3 B2 palette.
+     */
+    void defaultPalette(RenderPalette *palette);
+    
+    /*
+     Fills the lookup with the pixels of every byte value for the bitsPerPixel and alphaPlane of the geometry.
+     */
+    void buildLookup(RenderLookup *lookup, const RenderGeometry *geometry, const RenderPalette *palette);
+    
+    /*
+     Returns true when the lookup was built for the bitsPerPixel and alphaPlane of the geometry.
+     */
+    bool isLookupForGeometry(const RenderLookup *lookup, const RenderGeometry *geometry);
+    
+    /*
+     Returns the 65536 entry table mapping a 16-bit word, as read from memory in little-endian
+     order, to its pixel for the pixelFormat, bigEndian and alphaPlane of the geometry.
+     
+     Tables are built on first use, shared by every caller and thread, and never freed.
+     Returns NULL if the table could not be allocated.
+     */
+    const uint32_t *directColorTable(const RenderGeometry *geometry);
+    
+    /*
+     Number of source bytes for a single line of pixels, padding not included.
+     */
+    long bytesPerLine(const RenderGeometry *geometry);
+    
+    /*
+     Number of source bytes consumed when rendering the whole image, padding included.
+     */
+    long bytesPerImage(const RenderGeometry *geometry);
+    
+    /*
+     Returns true for the layouts of pictures of a fixed size, ZX screens and C64 bitmaps,
+     with the width and height of one in pixels and its bytes, padding not included.
+     */
+    bool pictureSize(const RenderGeometry *geometry, int *width, int *height, long *bytes);
+    
+    /*
+     Returns true when the geometry describes a layout the kernels are able to render.
+     */
+    bool isValidGeometry(const RenderGeometry *geometry);
+    
+    void packed1BitToPixelData(const RenderGeometry *geometry, const RenderLookup *lookup, const uint8_t *bytes, uint32_t *pixel, long stride);
+    void packed2BitToPixelData(const RenderGeometry *geometry, const RenderLookup *lookup, const uint8_t *bytes, uint32_t *pixel, long stride);
+    void packed4BitToPixelData(const RenderGeometry *geometry, const RenderLookup *lookup, const uint8_t *bytes, uint32_t *pixel, long stride);
+    void packed8BitToPixelData(const RenderGeometry *geometry, const RenderLookup *lookup, const uint8_t *bytes, uint32_t *pixel, long stride);
+    void packed16BitToPixelData(const RenderGeometry *geometry, const uint8_t *bytes, uint32_t *pixel, long stride);
+    void packed24BitToPixelData(const RenderGeometry *geometry, const uint8_t *bytes, uint32_t *pixel, long stride);
+    void packed32BitToPixelData(const RenderGeometry *geometry, const uint8_t *bytes, uint32_t *pixel, long stride);
+    void planer8BitToPixelData(const RenderGeometry *geometry, const RenderPalette *palette, const uint8_t *bytes, uint32_t *pixel, long stride);
+    void planer16BitToPixelData(const RenderGeometry *geometry, const RenderPalette *palette, const uint8_t *bytes, uint32_t *pixel, long stride);
+    void mask16BitToPixelData(const RenderGeometry *geometry, const RenderPalette *palette, const uint8_t *bytes, uint32_t *pixel, long stride);
+    void tilePlanesToPixelData(const RenderGeometry *geometry, const RenderPalette *palette, const uint8_t *bytes, uint32_t *pixel, long stride);
+    
+    /*
+     Renders the image using the kernel selected by the geometry.
+     
+     Parameters
+     lookup
+     Lookup built for this palette and geometry, or NULL to build one for packed pixels of up to 8 bits.
+     bytes
+     Start of the image data, at least bytesPerImage(geometry) bytes must be readable.
+     pixel
+     Top left pixel of the destination rectangle.
+     stride
+     Distance in pixels between two destination rows.
+     */
+    void renderToPixelData(const RenderGeometry *geometry, const RenderPalette *palette, const RenderLookup *lookup, const uint8_t *bytes, uint32_t *pixel, long stride);
+
+    /*
+     Returns true when every pixel of the geometry is a palette index, packed pixels of up to
+     8 bits and planar pixels without an alpha plane, so the image can be decoded once with
+     renderToIndices and colored again with indicesToPixelData after the palette changes.
+     */
+    bool isIndexedGeometry(const RenderGeometry *geometry);
+
+    /*
+     Fills the 256 entry colors with the pixel of each index for the geometry, with
+     transparency applied and set bits white for 1-bit packed pixels.
+     */
+    void buildIndexColors(const RenderGeometry *geometry, const RenderPalette *palette, uint32_t *colors);
+
+    /*
+     Decodes the image into one palette index per pixel, addressed as index[row * stride + column].
+     Does nothing unless isIndexedGeometry(geometry) is true.
+     */
+    void renderToIndices(const RenderGeometry *geometry, const uint8_t *bytes, uint8_t *index, long stride);
+
+    /*
+     Maps the indices written by renderToIndices for the same geometry to pixels.
+     */
+    void indicesToPixelData(const RenderGeometry *geometry, const uint32_t *colors, const uint8_t *index, long indexStride, uint32_t *pixel, long stride);
+
+    /*
+     Columns and rows the corners of a region are aligned to, a block when tiled, else
+     the smallest run of pixels that starts on a byte boundary and a single row.
+     */
+    void regionAlignment(const RenderGeometry *geometry, int *width, int *height);
+
+    /*
+     Renders the whole blocks of the region x, y, width, height of the image, without
+     touching any other source bytes, so a large image can be decoded a piece at a time.
+     
+     Parameters
+     bytes
+     Start of the image data, the bytes of the region must be readable.
+     x, y
+     Top left corner of the region, multiples of regionAlignment(geometry).
+     pixel
+     Destination of the top left pixel of the region.
+     */
+    void renderRegionToPixelData(const RenderGeometry *geometry, const RenderPalette *palette, const RenderLookup *lookup, const uint8_t *bytes, int x, int y, int width, int height, uint32_t *pixel, long stride);
+
+    /*
+     Decodes the region x, y, width, height of the image into palette indices, see renderRegionToPixelData.
+     Does nothing unless isIndexedGeometry(geometry) is true.
+     */
+    void renderRegionToIndices(const RenderGeometry *geometry, const uint8_t *bytes, int x, int y, int width, int height, uint8_t *index, long stride);
+
+/* Ends C function definitions when using C++ */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* render_h */
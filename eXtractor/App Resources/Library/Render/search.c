@@ -0,0 +1,367 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "search.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHUNK_BYTES     (1024 * 1024)   // Key positions checked per read of the source
+#define MAX_STRIDE      8192
+#define MIN_KEY         2   // A 16 pixel wide 1-bit sprite has two whole bytes a row
+#define MAX_KEY         8
+
+typedef struct {
+    int bitsPerPixel;
+    int planeCount;
+    bool bigEndian;
+} Layout;
+
+static const Layout layouts[] = {
+    {1, 1, true}, {2, 1, true}, {4, 1, true}, {8, 1, true},
+    {16, 2, true}, {16, 3, true}, {16, 4, true}, {16, 5, true}, {16, 6, true}, {16, 7, true}, {16, 8, true},
+    {16, 2, false}, {16, 3, false}, {16, 4, false}, {16, 5, false}, {16, 6, false}, {16, 7, false}, {16, 8, false},
+    {8, 2, true}, {8, 3, true}, {8, 4, true}, {8, 5, true}, {8, 6, true}, {8, 7, true}, {8, 8, true}
+};
+
+#define LAYOUT_COUNT ((int)(sizeof(layouts) / sizeof(layouts[0])))
+
+/*
+ The reference as stored in one layout, a mask bit is set for every bit a pixel of the
+ reference decides. The key is a run of whole bytes of one row, found first.
+ */
+typedef struct {
+    Layout layout;
+    int unitPixels;
+    int unitBytes;
+    long rowBytes;
+    uint8_t *bytes;
+    uint8_t *mask;
+    int keyRow;
+    long keyColumn;
+    int keyLength;
+    uint8_t key[MAX_KEY];
+} Encoding;
+
+typedef struct {
+    long position;
+    int encoding;
+} Hit;
+
+static int closestIndex(uint32_t color, const RenderPalette *palette) {
+    int count = palette->colorCount > 0 && palette->colorCount <= 256 ? palette->colorCount : 256;
+    int closest = 0;
+    long best = -1;
+    
+    for (int i = 0; i < count; i++) {
+        long r = (long)(color & 0xFF) - (long)(palette->rgb[i] & 0xFF);
+        long g = (long)(color >> 8 & 0xFF) - (long)(palette->rgb[i] >> 8 & 0xFF);
+        long b = (long)(color >> 16 & 0xFF) - (long)(palette->rgb[i] >> 16 & 0xFF);
+        long distance = r * r + g * g + b * b;
+        
+        if (best < 0 || distance < best) {
+            best = distance;
+            closest = i;
+        }
+    }
+    return closest;
+}
+
+static void setPixel(Encoding *encoding, int x, int y, unsigned index) {
+    const Layout *layout = &encoding->layout;
+    uint8_t *bytes = encoding->bytes + y * encoding->rowBytes;
+    uint8_t *mask = encoding->mask + y * encoding->rowBytes;
+    
+    if (layout->planeCount == 1) {
+        if (layout->bitsPerPixel == 8) {
+            bytes[x] = (uint8_t)index;
+            mask[x] = 0xFF;
+            return;
+        }
+        
+        long at = x / encoding->unitPixels;
+        int shift = 8 - layout->bitsPerPixel * (x % encoding->unitPixels + 1);
+        bytes[at] |= (uint8_t)(index << shift);
+        mask[at] |= (uint8_t)(((1 << layout->bitsPerPixel) - 1) << shift);
+        return;
+    }
+    
+    int bit = encoding->unitPixels - 1 - x % encoding->unitPixels;
+    long at = x / encoding->unitPixels * encoding->unitBytes;
+    
+    for (int p = 0; p < layout->planeCount; p++) {
+        long byte = at + p * (layout->bitsPerPixel / 8);
+        if (layout->bitsPerPixel == 16 && (bit >= 8) != layout->bigEndian) byte++;
+        
+        bytes[byte] |= (uint8_t)((index >> p & 1) << (bit & 7));
+        mask[byte] |= (uint8_t)(1 << (bit & 7));
+    }
+}
+
+/*
+ Picks the run of whole bytes with the most different values as the key, as long a run as
+ there is up to MAX_KEY bytes, so the key seldom turns up in data that is not the reference.
+ Narrow references only have short runs, their keys turn up more often and leave more of
+ the work to matchStride.
+ */
+static bool chooseKey(Encoding *encoding, int height) {
+    int bestLength = 0, bestDistinct = 0;
+    
+    for (int y = 0; y < height; y++) {
+        const uint8_t *bytes = encoding->bytes + y * encoding->rowBytes;
+        const uint8_t *mask = encoding->mask + y * encoding->rowBytes;
+        
+        for (long c = 0; c < encoding->rowBytes; c++) {
+            int length = 0;
+            while (length < MAX_KEY && c + length < encoding->rowBytes && mask[c + length] == 0xFF) length++;
+            if (length < MIN_KEY || length < bestLength) continue;
+            
+            int distinct = 0;
+            for (int i = 0; i < length; i++) {
+                if (memchr(bytes + c, bytes[c + i], i) == NULL) distinct++;
+            }
+            if (length == bestLength && distinct <= bestDistinct) continue;
+            
+            bestLength = length;
+            bestDistinct = distinct;
+            encoding->keyRow = y;
+            encoding->keyColumn = c;
+            encoding->keyLength = length;
+            memcpy(encoding->key, bytes + c, length);
+        }
+    }
+    
+    // A run of a single value, a row of background, is found all over most files.
+    return bestDistinct >= 2;
+}
+
+static bool encodeReference(Encoding *encoding, const Layout *layout, const int16_t *index, int width, int height) {
+    memset(encoding, 0, sizeof(Encoding));
+    encoding->layout = *layout;
+    
+    if (layout->planeCount > 1) {
+        encoding->unitPixels = layout->bitsPerPixel;
+        encoding->unitBytes = layout->bitsPerPixel / 8 * layout->planeCount;
+    } else {
+        encoding->unitPixels = layout->bitsPerPixel < 8 ? 8 / layout->bitsPerPixel : 1;
+        encoding->unitBytes = 1;
+    }
+    encoding->rowBytes = (width + encoding->unitPixels - 1) / encoding->unitPixels * encoding->unitBytes;
+    
+    int depth = layout->planeCount > 1 ? layout->planeCount : layout->bitsPerPixel;
+    for (long i = 0; i < (long)width * height; i++) {
+        if (index[i] >= 1 << depth) return false;
+    }
+    
+    encoding->bytes = calloc(height, encoding->rowBytes);
+    encoding->mask = calloc(height, encoding->rowBytes);
+    if (encoding->bytes == NULL || encoding->mask == NULL) return false;
+    
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            if (index[y * width + x] >= 0) setPixel(encoding, x, y, (unsigned)index[y * width + x]);
+        }
+    }
+    
+    return chooseKey(encoding, height);
+}
+
+static bool isRowMatch(const Encoding *encoding, int row, const uint8_t *data) {
+    const uint8_t *bytes = encoding->bytes + row * encoding->rowBytes;
+    const uint8_t *mask = encoding->mask + row * encoding->rowBytes;
+    
+    for (long i = 0; i < encoding->rowBytes; i++) {
+        if ((data[i] ^ bytes[i]) & mask[i]) return false;
+    }
+    return true;
+}
+
+/*
+ Checks the rows of the reference around a key found at position, trying every row stride
+ from the width of the reference up. Returns the smallest stride all rows match at, or 0.
+ */
+static long matchStride(DataSource *source, const Encoding *encoding, int height, long position, long *top) {
+    long length = dataSourceLength(source);
+    long keyRowStart = position - encoding->keyColumn;
+    if (keyRowStart < 0 || keyRowStart + encoding->rowBytes > length) return 0;
+    
+    long first = keyRowStart - encoding->keyRow * (long)MAX_STRIDE;
+    long last = keyRowStart + (height - 1 - encoding->keyRow) * (long)MAX_STRIDE + encoding->rowBytes;
+    if (first < 0) first = 0;
+    if (last > length) last = length;
+    
+    const uint8_t *data = dataSourceBytes(source, first, last - first);
+    if (data == NULL) return 0;
+    data -= first;
+    
+    if (!isRowMatch(encoding, encoding->keyRow, data + keyRowStart)) return 0;
+    if (height == 1) {
+        *top = keyRowStart;
+        return encoding->rowBytes;
+    }
+    
+    // The neighbouring row is checked on its own first, most strides fail on it.
+    int other = encoding->keyRow + 1 < height ? encoding->keyRow + 1 : encoding->keyRow - 1;
+    
+    for (long stride = encoding->rowBytes; stride <= MAX_STRIDE; stride += encoding->unitBytes) {
+        long start = keyRowStart - encoding->keyRow * stride;
+        if (start < first) break;
+        if (start + (height - 1) * stride + encoding->rowBytes > last) break;
+        
+        if (!isRowMatch(encoding, other, data + start + other * stride)) continue;
+        
+        int row = 0;
+        while (row < height && isRowMatch(encoding, row, data + start + row * stride)) row++;
+        if (row == height) {
+            *top = start;
+            return stride;
+        }
+    }
+    return 0;
+}
+
+int searchImage(DataSource *source, const uint32_t *pixel, int width, int height, const RenderPalette *palette, RenderMatch *matches, int count) {
+    long length = dataSourceLength(source);
+    int16_t *index = NULL;
+    int16_t *mono = NULL;
+    Encoding *encodings = NULL;
+    Hit *hits = NULL;
+    long hitCapacity = 4096;
+    int encodingCount = 0;
+    int found = -1;
+    
+    if (width < 1 || height < 1 || count < 1) {
+        errno = EINVAL;
+        return -1;
+    }
+    
+    index = malloc((size_t)width * height * sizeof(int16_t));
+    mono = malloc((size_t)width * height * sizeof(int16_t));
+    encodings = calloc(LAYOUT_COUNT, sizeof(Encoding));
+    hits = malloc(hitCapacity * sizeof(Hit));
+    if (index == NULL || mono == NULL || encodings == NULL || hits == NULL) goto cleanup;
+    
+    // Pixels are mapped once per color, a reference seldom has more than a few.
+    uint32_t lastColor = 0;
+    int lastIndex = closestIndex(0, palette);
+    for (long i = 0; i < (long)width * height; i++) {
+        // Monochrome pixels are drawn white when set and transparent when clear, whatever the palette.
+        unsigned brightness = (pixel[i] & 0xFF) + (pixel[i] >> 8 & 0xFF) + (pixel[i] >> 16 & 0xFF);
+        mono[i] = pixel[i] >> 24 >= 128 && brightness >= 3 * 128;
+        
+        if (pixel[i] >> 24 < 128) {
+            index[i] = -1;
+            continue;
+        }
+        
+        if ((pixel[i] & 0xFFFFFF) != lastColor) {
+            lastColor = pixel[i] & 0xFFFFFF;
+            lastIndex = closestIndex(lastColor, palette);
+        }
+        index[i] = (int16_t)lastIndex;
+    }
+    
+    // The first two bytes of every key, so most positions are passed over after one lookup.
+    uint64_t prefix[65536 / 64] = {0};
+    
+    for (int l = 0; l < LAYOUT_COUNT; l++) {
+        Encoding *encoding = &encodings[encodingCount];
+        const int16_t *indices = layouts[l].bitsPerPixel == 1 ? mono : index;
+        if (encodeReference(encoding, &layouts[l], indices, width, height)) {
+            unsigned key = (unsigned)encoding->key[0] << 8 | encoding->key[1];
+            prefix[key >> 6] |= (uint64_t)1 << (key & 63);
+            encodingCount++;
+        } else {
+            free(encoding->bytes);
+            free(encoding->mask);
+        }
+    }
+    
+    found = 0;
+    for (long start = 0; start + MIN_KEY <= length && found < count; start += CHUNK_BYTES) {
+        long positions = length - MIN_KEY + 1 - start;
+        if (positions > CHUNK_BYTES) positions = CHUNK_BYTES;
+        
+        long available = length - start < positions + MAX_KEY ? length - start : positions + MAX_KEY;
+        const uint8_t *bytes = dataSourceBytes(source, start, available);
+        if (bytes == NULL) {
+            errno = EIO;
+            found = -1;
+            goto cleanup;
+        }
+        
+        long hitCount = 0;
+        for (long i = 0; i < positions; i++) {
+            unsigned key = (unsigned)bytes[i] << 8 | bytes[i + 1];
+            if ((prefix[key >> 6] & (uint64_t)1 << (key & 63)) == 0) continue;
+            
+            for (int e = 0; e < encodingCount; e++) {
+                if (i + encodings[e].keyLength > available) continue;
+                if (memcmp(bytes + i, encodings[e].key, encodings[e].keyLength) != 0) continue;
+                
+                if (hitCount == hitCapacity) {
+                    Hit *grown = realloc(hits, (size_t)hitCapacity * 2 * sizeof(Hit));
+                    if (grown == NULL) {
+                        found = -1;
+                        goto cleanup;
+                    }
+                    hits = grown;
+                    hitCapacity *= 2;
+                }
+                hits[hitCount++] = (Hit){start + i, e};
+            }
+        }
+        
+        // Checking a hit reads other parts of the source, so bytes is no longer used after this.
+        for (long h = 0; h < hitCount && found < count; h++) {
+            const Encoding *encoding = &encodings[hits[h].encoding];
+            long top;
+            long stride = matchStride(source, encoding, height, hits[h].position, &top);
+            if (stride == 0) continue;
+            
+            RenderGeometry geometry = {
+                .width = (int)(stride / encoding->unitBytes * encoding->unitPixels),
+                .height = height,
+                .bitsPerPixel = encoding->layout.bitsPerPixel,
+                .planeCount = encoding->layout.planeCount,
+                .bigEndian = encoding->layout.bigEndian,
+                .tileWidth = 1,
+                .tileHeight = 1
+            };
+            if (!isValidGeometry(&geometry)) continue;
+            
+            matches[found++] = (RenderMatch){top, geometry};
+        }
+    }
+    
+cleanup:
+    for (int e = 0; e < encodingCount; e++) {
+        free(encodings[e].bytes);
+        free(encodings[e].mask);
+    }
+    free(encodings);
+    free(hits);
+    free(index);
+    free(mono);
+    return found;
+}
@@ -0,0 +1,71 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef search_h
+#define search_h
+
+#include "render.h"
+#include "datasource.h"
+
+/*
+ Finds where a small reference image, a sprite or a crop of a screenshot, is stored.
+ 
+ The reference is mapped to the palette and encoded the way every packed and planar layout
+ of the kernels would store it, transparent pixels and pixels past its right edge left as
+ bits that match anything. Each encoding contributes a key of 2 to 8 bytes taken from
+ whichever of its rows has the most varied whole bytes, every key is looked for in a single
+ pass over the source, and each hit is checked against the remaining rows at every row
+ stride up to 8192 bytes. The left edge of the reference has to start a byte, or plane
+ group, of the layout, and a row needs two whole bytes, 16 pixels in 1-bit layouts.
+ */
+
+typedef struct {
+    long offset;                // Start of the top row of the reference in the source
+    RenderGeometry geometry;    // Layout it was found in, as wide as the distance between its rows
+} RenderMatch;
+
+/* Set up for C function definitions, even when using C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /*
+     Looks for the reference in the source and fills matches with at most count places, in the
+     order they are stored.
+     
+     Parameters
+     pixel
+     Reference image as width * height pixels, pixels with an alpha below 128 match anything,
+     except in 1-bit layouts which draw clear bits transparent.
+     palette
+     Colors of the indices, each pixel is taken as the index of the closest one.
+     
+     Returns the number of matches written, or -1 and sets errno on failure.
+     */
+    int searchImage(DataSource *source, const uint32_t *pixel, int width, int height, const RenderPalette *palette, RenderMatch *matches, int count);
+
+/* Ends C function definitions when using C++ */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* search_h */
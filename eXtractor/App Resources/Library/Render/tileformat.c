@@ -0,0 +1,136 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#include "tileformat.h"
+
+/*
+ Each byte of a plane spread to one byte a pixel, 1 for a set bit, leftmost pixel first,
+ so the indices of a whole row are built 8 at a time by shifting and adding planes.
+ */
+#define BIT(b, n)   ((b) >> (7 - (n)) & 1)
+#define BITS(b)     { BIT(b, 0), BIT(b, 1), BIT(b, 2), BIT(b, 3), BIT(b, 4), BIT(b, 5), BIT(b, 6), BIT(b, 7) }
+#define BYTE4(f, b) f(b), f(b + 1), f(b + 2), f(b + 3)
+#define BYTE16(f, b) BYTE4(f, b), BYTE4(f, b + 4), BYTE4(f, b + 8), BYTE4(f, b + 12)
+#define BYTE64(f, b) BYTE16(f, b), BYTE16(f, b + 16), BYTE16(f, b + 32), BYTE16(f, b + 48)
+#define BYTE256(f)  BYTE64(f, 0), BYTE64(f, 64), BYTE64(f, 128), BYTE64(f, 192)
+
+static const uint8_t spreadBits[256][8] = { BYTE256(BITS) };
+
+static inline uint64_t spreadPlane(uint8_t byte, int plane) {
+    uint64_t bits;
+    memcpy(&bits, spreadBits[byte], sizeof(bits));
+    return bits << plane;
+}
+
+/*
+ The tile formats, one descriptor each:
+ 
+ X(layout, rowBytes, offset of plane 0, offset of plane 1, ...)
+ 
+ The byte holding plane p of row r is at (offset of plane p) + r * rowBytes from the start
+ of the tile, the leftmost pixel in its most significant bit, plane 0 the least significant
+ bit of the index. A tile is 8 bytes a plane, so adding a console is a line here and a
+ RenderLayout for it.
+ */
+#define TILE_FORMATS(X) \
+    X(RenderLayoutGameBoyTiles,         2, 0, 1) \
+    X(RenderLayoutNESTiles,             1, 0, 8) \
+    X(RenderLayoutSNES4BitTiles,        2, 0, 1, 16, 17) \
+    X(RenderLayoutSNES8BitTiles,        2, 0, 1, 16, 17, 32, 33, 48, 49) \
+    X(RenderLayoutMasterSystemTiles,    4, 0, 1, 2, 3)
+
+#define PLANE_COUNT(...)    (sizeof((const uint8_t[]){ __VA_ARGS__ }))
+
+/*
+ A decoder for the tiles of one descriptor, the plane offsets and row stride are constants
+ so the loops over rows and planes unroll into straight loads, shifts and ors.
+ */
+#define TILE_DECODER(layout, rowBytes, ...) \
+    static void layout##ToIndices(const uint8_t *tile, uint8_t *index, long stride) { \
+        static const uint8_t offset[] = { __VA_ARGS__ }; \
+        for (int r = 0; r < TILE_FORMAT_SIZE; r++) { \
+            uint64_t row = 0; \
+            for (int p = 0; p < (int)PLANE_COUNT(__VA_ARGS__); p++) { \
+                row |= spreadPlane(tile[offset[p] + r * (rowBytes)], p); \
+            } \
+            memcpy(index + r * stride, &row, sizeof(row)); \
+        } \
+    }
+
+TILE_FORMATS(TILE_DECODER)
+
+typedef void (*TileDecoder)(const uint8_t *tile, uint8_t *index, long stride);
+
+typedef struct {
+    RenderLayout layout;
+    int bits;
+    TileDecoder decoder;
+} TileFormat;
+
+#define TILE_FORMAT_ENTRY(layout, rowBytes, ...)  { layout, (int)PLANE_COUNT(__VA_ARGS__), layout##ToIndices },
+
+static const TileFormat tileFormats[] = {
+    TILE_FORMATS(TILE_FORMAT_ENTRY)
+};
+
+static const TileFormat *findTileFormat(RenderLayout layout) {
+    for (size_t i = 0; i < sizeof(tileFormats) / sizeof(tileFormats[0]); i++) {
+        if (tileFormats[i].layout == layout) return &tileFormats[i];
+    }
+    return NULL;
+}
+
+// MARK: - Public Functions
+
+int tileFormatBits(RenderLayout layout) {
+    const TileFormat *format = findTileFormat(layout);
+    return format ? format->bits : 0;
+}
+
+void tilesToIndices(RenderLayout layout, const uint8_t *bytes, int count, int padding, uint8_t *index, long stride) {
+    const TileFormat *format = findTileFormat(layout);
+    if (format == NULL) return;
+    
+    for (int i = 0; i < count; i++) {
+        format->decoder(bytes, index + i * TILE_FORMAT_SIZE, stride);
+        bytes += format->bits * TILE_FORMAT_SIZE + padding;
+    }
+}
+
+void tilesToPixelData(RenderLayout layout, const uint8_t *bytes, int count, int padding, const uint32_t *colors, uint32_t *pixel, long stride) {
+    const TileFormat *format = findTileFormat(layout);
+    uint8_t index[TILE_FORMAT_SIZE * TILE_FORMAT_SIZE];
+    if (format == NULL) return;
+    
+    for (int i = 0; i < count; i++) {
+        format->decoder(bytes, index, TILE_FORMAT_SIZE);
+        for (int r = 0; r < TILE_FORMAT_SIZE; r++) {
+            const uint8_t *row = index + r * TILE_FORMAT_SIZE;
+            uint32_t *out = pixel + r * stride + i * TILE_FORMAT_SIZE;
+            for (int c = 0; c < TILE_FORMAT_SIZE; c++) {
+                out[c] = colors[row[c]];
+            }
+        }
+        bytes += format->bits * TILE_FORMAT_SIZE + padding;
+    }
+}
@@ -0,0 +1,60 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#ifndef tileformat_h
+#define tileformat_h
+
+#include "render.h"
+
+/*
+ Console tiles of 8 by 8 pixels whose bitplanes are stored neither packed nor as words
+ of interleaved planes. Each format is a descriptor in tileformat.c, the offset of the
+ byte holding each plane of a row, which is expanded at build time into a decoder of
+ its own with every loop unrolled and no branch per pixel.
+ */
+
+#define TILE_FORMAT_SIZE 8      // Width and height of every tile
+
+/* Set up for C function definitions, even when using C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /*
+     Bits per pixel of the tiles of the layout, 0 when the layout is not a tile format.
+     */
+    int tileFormatBits(RenderLayout layout);
+    
+    /*
+     Decodes count tiles, each followed by padding bytes, into one row of tiles from left to right.
+     The layout has to be a tile format.
+     */
+    void tilesToIndices(RenderLayout layout, const uint8_t *bytes, int count, int padding, uint8_t *index, long stride);
+    void tilesToPixelData(RenderLayout layout, const uint8_t *bytes, int count, int padding, const uint32_t *colors, uint32_t *pixel, long stride);
+
+/* Ends C function definitions when using C++ */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* tileformat_h */
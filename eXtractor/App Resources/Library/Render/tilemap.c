@@ -0,0 +1,313 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#include "tilemap.h"
+#include "parallel.h"
+#include "trace.h"
+#include "tileformat.h"
+
+#include <errno.h>
+#include <limits.h>
+
+struct RenderTileset {
+    RenderGeometry geometry;    // A single tile
+    long count;
+    int indexBits;              // Bits of each palette index, 0 when the tiles hold pixels
+    uint8_t *index;             // count tiles of tileWidth * tileHeight indices, one after another
+    uint32_t *pixel;            // Or pixels, when the geometry is not indexed
+};
+
+typedef struct {
+    const RenderTileset *tileset;
+    const RenderTilemap *map;
+    const uint8_t *entries;
+    const uint32_t *colors;
+    int x;
+    int y;
+    int width;
+    int height;
+    uint32_t *pixel;
+    long stride;
+} TilemapRows;
+
+// The geometry of a single tile, console tiles being 8 by 8 pixels whatever the tile size.
+static RenderGeometry singleTile(const RenderGeometry *geometry) {
+    RenderGeometry tile = *geometry;
+    
+    if (tileFormatBits(geometry->layout) > 0) {
+        tile.tileWidth = TILE_FORMAT_SIZE;
+        tile.tileHeight = TILE_FORMAT_SIZE;
+    }
+    tile.width = tile.tileWidth;
+    tile.height = tile.tileHeight;
+    return tile;
+}
+
+static int lowestBit(uint16_t mask) {
+    int shift = 0;
+    
+    if (mask == 0) return 0;
+    while ((mask & 1) == 0) {
+        mask >>= 1;
+        shift++;
+    }
+    return shift;
+}
+
+static uint16_t readEntry(const RenderTilemap *map, const uint8_t *entry) {
+    if (map->bytesPerEntry == 1) return entry[0];
+    return map->bigEndian ? (uint16_t)(entry[0] << 8 | entry[1]) : (uint16_t)(entry[1] << 8 | entry[0]);
+}
+
+/*
+ Copies one row of a tile, from its column first to last, mirrored when flipped.
+ */
+static void copyIndexRow(const uint8_t *index, const uint32_t *colors, int bank, int first, int last, int tileWidth, bool hFlip, uint32_t *pixel) {
+    if (hFlip) {
+        for (int c = first; c < last; c++) {
+            *pixel++ = colors[(index[tileWidth - 1 - c] + bank) & 0xFF];
+        }
+    } else {
+        for (int c = first; c < last; c++) {
+            *pixel++ = colors[(index[c] + bank) & 0xFF];
+        }
+    }
+}
+
+static void copyPixelRow(const uint32_t *source, int first, int last, int tileWidth, bool hFlip, uint32_t *pixel) {
+    if (hFlip) {
+        for (int c = first; c < last; c++) {
+            *pixel++ = source[tileWidth - 1 - c];
+        }
+    } else {
+        memcpy(pixel, source + first, (size_t)(last - first) * sizeof(uint32_t));
+    }
+}
+
+/*
+ Draws the part of one row of tiles within the rectangle.
+ */
+static void renderTilemapRow(void *context, size_t index) {
+    const TilemapRows *rows = context;
+    const RenderTileset *tileset = rows->tileset;
+    const RenderTilemap *map = rows->map;
+    int tileWidth = tileset->geometry.tileWidth;
+    int tileHeight = tileset->geometry.tileHeight;
+    int bankShift = lowestBit(map->paletteMask);
+    
+    // Rows of the rectangle this row of tiles covers.
+    int row = rows->y / tileHeight + (int)index;
+    int top = row * tileHeight > rows->y ? row * tileHeight : rows->y;
+    int bottom = (row + 1) * tileHeight < rows->y + rows->height ? (row + 1) * tileHeight : rows->y + rows->height;
+    
+    for (int x = rows->x; x < rows->x + rows->width; ) {
+        int column = x / tileWidth;
+        int first = x - column * tileWidth;
+        int last = rows->x + rows->width - column * tileWidth < tileWidth ? rows->x + rows->width - column * tileWidth : tileWidth;
+        uint32_t *pixel = rows->pixel + (top - rows->y) * rows->stride + (x - rows->x);
+        
+        long tile = -1;
+        uint16_t entry = 0;
+        if (row < map->height && column < map->width) {
+            entry = readEntry(map, rows->entries + ((long)row * map->width + column) * map->bytesPerEntry);
+            tile = entry & map->indexMask;
+            if (tile >= tileset->count) tile = -1;
+        }
+        
+        if (tile < 0) {
+            for (int y = top; y < bottom; y++, pixel += rows->stride) {
+                memset(pixel, 0, (size_t)(last - first) * sizeof(uint32_t));
+            }
+            x += last - first;
+            continue;
+        }
+        
+        bool hFlip = (entry & map->hFlipMask) != 0;
+        bool vFlip = (entry & map->vFlipMask) != 0;
+        int bank = tileset->indexBits < 8 ? ((entry & map->paletteMask) >> bankShift) << tileset->indexBits : 0;
+        long size = (long)tileWidth * tileHeight;
+        
+        for (int y = top; y < bottom; y++, pixel += rows->stride) {
+            int r = y - row * tileHeight;
+            if (vFlip) r = tileHeight - 1 - r;
+            
+            if (tileset->index != NULL) {
+                copyIndexRow(tileset->index + tile * size + (long)r * tileWidth, rows->colors, bank, first, last, tileWidth, hFlip, pixel);
+            } else {
+                copyPixelRow(tileset->pixel + tile * size + (long)r * tileWidth, first, last, tileWidth, hFlip, pixel);
+            }
+        }
+        x += last - first;
+    }
+}
+
+// MARK: - Public Functions
+
+void setTilemapFormat(RenderTilemap *map, RenderTilemapFormat format) {
+    map->bytesPerEntry = 2;
+    map->bigEndian = false;
+    map->hFlipMask = 0;
+    map->vFlipMask = 0;
+    map->paletteMask = 0;
+    
+    switch (format) {
+        case RenderTilemap8Bit:
+            map->bytesPerEntry = 1;
+            map->indexMask = 0xFF;
+            break;
+            
+        case RenderTilemap16Bit:
+            map->indexMask = 0xFFFF;
+            break;
+            
+        case RenderTilemapSNES:
+            map->indexMask = 0x03FF;
+            map->paletteMask = 0x1C00;
+            map->hFlipMask = 0x4000;
+            map->vFlipMask = 0x8000;
+            break;
+            
+        case RenderTilemapMegaDrive:
+            map->bigEndian = true;
+            map->indexMask = 0x07FF;
+            map->hFlipMask = 0x0800;
+            map->vFlipMask = 0x1000;
+            map->paletteMask = 0x6000;
+            break;
+            
+        case RenderTilemapCommanderX16:
+            map->indexMask = 0x03FF;
+            map->hFlipMask = 0x0400;
+            map->vFlipMask = 0x0800;
+            map->paletteMask = 0xF000;
+            break;
+            
+        case RenderTilemapSpectrumNext:
+            map->indexMask = 0x00FF;
+            map->vFlipMask = 0x0400;
+            map->hFlipMask = 0x0800;
+            map->paletteMask = 0xF000;
+            break;
+    }
+}
+
+long bytesPerTilemap(const RenderTilemap *map) {
+    return (long)map->width * map->height * map->bytesPerEntry;
+}
+
+long bytesPerTile(const RenderGeometry *geometry) {
+    RenderGeometry tile = singleTile(geometry);
+    return bytesPerImage(&tile);
+}
+
+RenderTileset *createTileset(const RenderGeometry *geometry, const RenderPalette *palette, const uint8_t *bytes, long count) {
+    // The tiles as one image a tile wide, each tile the next row of tiles.
+    RenderGeometry tile = singleTile(geometry);
+    RenderGeometry strip = tile;
+    int pictureWidth, pictureHeight;
+    long pictureBytes;
+    
+    if (count < 1 || count > INT_MAX / tile.tileHeight || pictureSize(geometry, &pictureWidth, &pictureHeight, &pictureBytes) ||
+        tile.tileWidth < 2 || tile.tileHeight < 2) {
+        errno = EINVAL;
+        return NULL;
+    }
+    strip.height = tile.tileHeight * (int)count;
+    if (isValidGeometry(&strip) == false) {
+        errno = EINVAL;
+        return NULL;
+    }
+    
+    RenderTileset *tileset = calloc(1, sizeof(RenderTileset));
+    if (tileset == NULL) return NULL;
+    
+    tileset->geometry = tile;
+    tileset->count = count;
+    
+    size_t pixels = (size_t)strip.width * (size_t)strip.height;
+    uint64_t start = traceBegin();
+    if (isIndexedGeometry(&strip)) {
+        tileset->indexBits = tileFormatBits(strip.layout);
+        if (tileset->indexBits == 0) tileset->indexBits = strip.planeCount > 1 ? strip.planeCount : strip.bitsPerPixel;
+        tileset->index = malloc(pixels);
+        if (tileset->index) renderToIndices(&strip, bytes, tileset->index, strip.width);
+    } else {
+        tileset->pixel = malloc(pixels * sizeof(uint32_t));
+        if (tileset->pixel) renderToPixelData(&strip, palette, NULL, bytes, tileset->pixel, strip.width);
+    }
+    traceEnd("decode tileset", start);
+    
+    if (tileset->index == NULL && tileset->pixel == NULL) {
+        free(tileset);
+        errno = ENOMEM;
+        return NULL;
+    }
+    traceAdd(TraceCounterBytesDecoded, (long)bytesPerImage(&strip));
+    return tileset;
+}
+
+void closeTileset(RenderTileset *tileset) {
+    if (tileset == NULL) return;
+    
+    free(tileset->index);
+    free(tileset->pixel);
+    free(tileset);
+}
+
+bool isTilesetForGeometry(const RenderTileset *tileset, const RenderGeometry *geometry) {
+    const RenderGeometry *a = &tileset->geometry;
+    RenderGeometry tile = singleTile(geometry);
+    geometry = &tile;
+    
+    if (a->layout != geometry->layout || a->bitsPerPixel != geometry->bitsPerPixel || a->planeCount != geometry->planeCount) return false;
+    if (a->alphaPlane != geometry->alphaPlane || a->maskPlane != geometry->maskPlane) return false;
+    if (a->bigEndian != geometry->bigEndian || a->pixelFormat != geometry->pixelFormat) return false;
+    return a->tileWidth == geometry->tileWidth && a->tileHeight == geometry->tileHeight && a->padding == geometry->padding;
+}
+
+long tilesetCount(const RenderTileset *tileset) {
+    return tileset->count;
+}
+
+void renderTilemapRegion(const RenderTileset *tileset, const RenderTilemap *map, const RenderPalette *palette, const uint8_t *entries, int x, int y, int width, int height, uint32_t *pixel, long stride) {
+    uint32_t colors[256];
+    
+    if (width < 1 || height < 1) return;
+    if (tileset->index != NULL) buildIndexColors(&tileset->geometry, palette, colors);
+    
+    TilemapRows rows = {
+        .tileset = tileset,
+        .map = map,
+        .entries = entries,
+        .colors = colors,
+        .x = x,
+        .y = y,
+        .width = width,
+        .height = height,
+        .pixel = pixel,
+        .stride = stride
+    };
+    int tileHeight = tileset->geometry.tileHeight;
+    parallelFor((size_t)((y + height - 1) / tileHeight - y / tileHeight + 1), &rows, renderTilemapRow);
+    traceAdd(TraceCounterPixelsWritten, (long)width * height);
+}
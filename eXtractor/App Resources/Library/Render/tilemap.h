@@ -0,0 +1,121 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#ifndef tilemap_h
+#define tilemap_h
+
+#include "render.h"
+
+/*
+ Levels drawn from a tilemap, a grid of tile indices with optional flip and palette bits,
+ against a tileset stored elsewhere in the data.
+ 
+ Every tile of the tileset is decoded once, into palette indices when the geometry is indexed
+ and into pixels otherwise, and the map is then drawn by copying tiles out of that cache, so
+ a whole level costs little more than copying its pixels.
+ */
+
+typedef enum {
+    RenderTilemap8Bit,          // One byte a tile, as the NES, Game Boy and Master System name tables
+    RenderTilemap16Bit,         // Little-endian words, a tile each
+    RenderTilemapSNES,          // Little-endian vhopppcc cccccccc
+    RenderTilemapMegaDrive,     // Big-endian pccvhnnn nnnnnnnn
+    RenderTilemapCommanderX16,  // Index low byte, then ppppvhnn
+    RenderTilemapSpectrumNext   // Index byte, then ppppxymu, rotation and ULA priority ignored
+} RenderTilemapFormat;
+
+typedef struct {
+    int width;                  // Map width in tiles
+    int height;                 // Map height in tiles
+    int bytesPerEntry;          // 1 or 2
+    bool bigEndian;             // Entries of 2 bytes stored high byte first
+    uint16_t indexMask;
+    uint16_t hFlipMask;
+    uint16_t vFlipMask;
+    uint16_t paletteMask;       // Palette bank, moves the indices of a tile by bank << bits per pixel
+} RenderTilemap;
+
+typedef struct RenderTileset RenderTileset;
+
+/* Set up for C function definitions, even when using C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /*
+     Sets the entry size and bits of the map for the format, leaving its width and height.
+     */
+    void setTilemapFormat(RenderTilemap *map, RenderTilemapFormat format);
+    
+    /*
+     Number of source bytes the entries of the whole map take.
+     */
+    long bytesPerTilemap(const RenderTilemap *map);
+    
+    /*
+     Number of source bytes from one tile of the geometry to the next, padding included.
+     */
+    long bytesPerTile(const RenderGeometry *geometry);
+    
+    /*
+     Decodes count tiles, of tileWidth by tileHeight pixels laid out as the geometry describes,
+     or 8 by 8 for the console tile layouts, one after another from bytes. The palette is only used when the geometry is not indexed,
+     such a tileset has to be created again after the palette changes.
+     Returns NULL and sets errno on failure.
+     */
+    RenderTileset *createTileset(const RenderGeometry *geometry, const RenderPalette *palette, const uint8_t *bytes, long count);
+    
+    void closeTileset(RenderTileset *tileset);
+    
+    /*
+     Returns true when the tileset was decoded with the layout of tiles the geometry describes,
+     its width and height aside.
+     */
+    bool isTilesetForGeometry(const RenderTileset *tileset, const RenderGeometry *geometry);
+    
+    /*
+     Number of tiles decoded.
+     */
+    long tilesetCount(const RenderTileset *tileset);
+    
+    /*
+     Draws the rectangle x, y, width, height of the level, the map being width * tileWidth
+     by height * tileHeight pixels. Every pixel of the rectangle is written, those of tiles
+     the tileset does not hold, or outside the map, are cleared.
+     
+     Parameters
+     entries
+     Start of the map, bytesPerTilemap(map) bytes must be readable.
+     pixel
+     Destination of the top left pixel of the rectangle.
+     stride
+     Distance in pixels between two destination rows.
+     */
+    void renderTilemapRegion(const RenderTileset *tileset, const RenderTilemap *map, const RenderPalette *palette, const uint8_t *entries, int x, int y, int width, int height, uint32_t *pixel, long stride);
+
+/* Ends C function definitions when using C++ */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* tilemap_h */
@@ -0,0 +1,180 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "trace.h"
+
+#include <stdatomic.h>
+#include <time.h>
+
+#define EVENT_COUNT (1 << 16)       // Most recent events kept
+
+typedef struct {
+    atomic_uint_fast64_t sequence;  // Number of the event stored, plus one, 0 while being written
+    const char *name;               // NULL for a sample of the counters
+    uint64_t start;
+    uint64_t duration;
+    int thread;
+    long counters[TraceCounterCount];
+} TraceEvent;
+
+static TraceEvent events[EVENT_COUNT];
+static atomic_uint_fast64_t next;
+static atomic_long counters[TraceCounterCount];
+static atomic_bool tracing;
+static atomic_int threads;
+static uint64_t epoch;
+static _Thread_local int thread;
+
+static const char *counterNames[TraceCounterCount] = {
+    "bytes decoded",
+    "pixels written",
+    "palette redraws"
+};
+
+// MARK: - Private Functions
+
+static uint64_t nanoseconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int threadNumber(void) {
+    if (thread == 0) thread = atomic_fetch_add(&threads, 1) + 1;
+    return thread;
+}
+
+static TraceEvent *claimEvent(uint64_t *number) {
+    *number = atomic_fetch_add(&next, 1);
+    TraceEvent *event = &events[*number & (EVENT_COUNT - 1)];
+    atomic_store(&event->sequence, 0);
+    return event;
+}
+
+static void publishEvent(TraceEvent *event, uint64_t number) {
+    atomic_store_explicit(&event->sequence, number + 1, memory_order_release);
+}
+
+// MARK: - Public Functions
+
+void setTracing(bool enabled) {
+    if (enabled) {
+        atomic_store(&tracing, false);
+        for (int i = 0; i < EVENT_COUNT; i++) {
+            atomic_store(&events[i].sequence, 0);
+        }
+        for (int i = 0; i < TraceCounterCount; i++) {
+            atomic_store(&counters[i], 0);
+        }
+        atomic_store(&next, 0);
+        epoch = nanoseconds();
+    }
+    atomic_store(&tracing, enabled);
+}
+
+bool isTracing(void) {
+    return atomic_load_explicit(&tracing, memory_order_relaxed);
+}
+
+uint64_t traceBegin(void) {
+    if (isTracing() == false) return 0;
+    return nanoseconds();
+}
+
+uint64_t traceEnd(const char *name, uint64_t start) {
+    if (start == 0 || isTracing() == false) return 0;
+    
+    uint64_t end = nanoseconds();
+    uint64_t number;
+    TraceEvent *event = claimEvent(&number);
+    
+    event->name = name;
+    event->start = start;
+    event->duration = end - start;
+    event->thread = threadNumber();
+    publishEvent(event, number);
+    return end - start;
+}
+
+void traceAdd(TraceCounter counter, long amount) {
+    if (isTracing() == false) return;
+    atomic_fetch_add_explicit(&counters[counter], amount, memory_order_relaxed);
+}
+
+void traceCounters(void) {
+    if (isTracing() == false) return;
+    
+    uint64_t number;
+    TraceEvent *event = claimEvent(&number);
+    
+    event->name = NULL;
+    event->start = nanoseconds();
+    event->duration = 0;
+    event->thread = threadNumber();
+    for (int i = 0; i < TraceCounterCount; i++) {
+        event->counters[i] = atomic_load(&counters[i]);
+    }
+    publishEvent(event, number);
+}
+
+long traceTotal(TraceCounter counter) {
+    return atomic_load(&counters[counter]);
+}
+
+bool writeTrace(const char *path) {
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL) return false;
+    
+    uint64_t last = atomic_load(&next);
+    uint64_t first = last > EVENT_COUNT ? last - EVENT_COUNT : 0;
+    bool comma = false;
+    
+    fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    
+    // Oldest first, skipping any event still being written or already written over.
+    for (uint64_t number = first; number < last; number++) {
+        const TraceEvent *event = &events[number & (EVENT_COUNT - 1)];
+        if (atomic_load_explicit(&event->sequence, memory_order_acquire) != number + 1) continue;
+        if (event->start < epoch) continue;
+        
+        double timestamp = (double)(event->start - epoch) / 1000.0;
+        if (comma) fprintf(fp, ",\n");
+        comma = true;
+        
+        if (event->name) {
+            fprintf(fp, "{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                    event->name, event->thread, timestamp, (double)event->duration / 1000.0);
+        } else {
+            fprintf(fp, "{\"name\": \"work\", \"ph\": \"C\", \"pid\": 1, \"ts\": %.3f, \"args\": {", timestamp);
+            for (int i = 0; i < TraceCounterCount; i++) {
+                fprintf(fp, "%s\"%s\": %ld", i ? ", " : "", counterNames[i], event->counters[i]);
+            }
+            fprintf(fp, "}}");
+        }
+    }
+    
+    fprintf(fp, "\n]}\n");
+    
+    bool success = ferror(fp) == 0;
+    if (fclose(fp) != 0) success = false;
+    return success;
+}
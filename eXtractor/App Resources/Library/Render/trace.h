@@ -0,0 +1,92 @@
+/*
+Copyright © 2026 Insoft. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef trace_h
+#define trace_h
+
+#include "common.h"
+
+/*
+ Lightweight timing of the phases of a frame, or of any other work, to find out where the
+ time goes.
+ 
+ Each phase is recorded as a complete event in a ring of the most recent events, along with
+ counters of the work done, and written as Chrome trace event JSON that chrome://tracing and
+ Perfetto open. Any thread may record. While tracing is off a phase only costs a flag test.
+ */
+
+typedef enum {
+    TraceCounterBytesDecoded,
+    TraceCounterPixelsWritten,
+    TraceCounterPaletteRedraws,
+    TraceCounterCount
+} TraceCounter;
+
+/* Set up for C function definitions, even when using C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /*
+     Starts or stops recording, starting drops every event and counter recorded before.
+     */
+    void setTracing(bool enabled);
+    
+    bool isTracing(void);
+    
+    /*
+     Returns the start time of a phase in nanoseconds, 0 when tracing is off.
+     */
+    uint64_t traceBegin(void);
+    
+    /*
+     Records the phase that began at start, returns its duration in nanoseconds.
+     
+     Parameters
+     name
+     Name of the phase, only the pointer is kept so it must stay valid, a string literal.
+     */
+    uint64_t traceEnd(const char *name, uint64_t start);
+    
+    /*
+     Adds amount to the counter, does nothing when tracing is off.
+     */
+    void traceAdd(TraceCounter counter, long amount);
+    
+    /*
+     Records the value of every counter at this moment, drawn as a graph by the trace viewers.
+     */
+    void traceCounters(void);
+    
+    long traceTotal(TraceCounter counter);
+    
+    /*
+     Writes the recorded events as Chrome trace event JSON. Returns false if the file could not be written.
+     */
+    bool writeTrace(const char *path);
+
+/* Ends C function definitions when using C++ */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* trace_h */
@@ -76,11 +76,51 @@ class AppDelegate: NSObject, NSApplicationDelegate {
     }
     
     @IBAction private func firstPalette(_ sender: NSMenuItem) {
-        Singleton.sharedInstance()?.image.firstAtariSTPalette()
+        Singleton.sharedInstance()?.image.firstStoredPalette()
     }
     
     @IBAction private func nextPalette(_ sender: NSMenuItem) {
-        Singleton.sharedInstance()?.image.nextAtariSTPalette()
+        Singleton.sharedInstance()?.image.nextStoredPalette()
+    }
+    
+    @IBAction private func previousPalette(_ sender: NSMenuItem) {
+        Singleton.sharedInstance()?.image.previousStoredPalette()
+    }
+    
+    @IBAction private func findImage(_ sender: NSMenuItem) {
+        let openPanel = NSOpenPanel()
+        
+        openPanel.title = "eXtractor"
+        openPanel.canChooseFiles = true
+        openPanel.canChooseDirectories = false
+        openPanel.canCreateDirectories = false
+        
+        let modalresponse = openPanel.runModal()
+        if modalresponse == .OK {
+            if let url = openPanel.url, let reference = NSImage(contentsOf: url)?.cgImage(forProposedRect: nil, context: nil, hints: nil) {
+                _ = Singleton.sharedInstance()?.image.findImage(reference)
+            }
+        }
+        
+        updateAllMenus()
+    }
+    
+    @IBAction private func findNextImage(_ sender: NSMenuItem) {
+        Singleton.sharedInstance()?.image.findNextImage()
+        updateAllMenus()
+    }
+    
+    @IBAction private func nextTapeBlock(_ sender: NSMenuItem) {
+        Singleton.sharedInstance()?.mainScene.nextTapeBlock()
+    }
+    
+    @IBAction private func previousTapeBlock(_ sender: NSMenuItem) {
+        Singleton.sharedInstance()?.mainScene.previousTapeBlock()
+    }
+    
+    @IBAction private func snapshotView(_ sender: NSMenuItem) {
+        Singleton.sharedInstance()?.mainScene.showSnapshotView(sender.tag)
+        updateAllMenus()
     }
     
     @IBAction private func planeCount(_ sender: NSMenuItem) {
@@ -156,10 +196,12 @@ class AppDelegate: NSObject, NSApplicationDelegate {
                 image.setSize(CGSize(width: 640, height: 200))
                 image.setTileWithWidthOf(1, andHightOf: 1)
                 if let palette = Singleton.sharedInstance()?.image.palette {
+                    palette.beginUpdates()
                     if let filePath = Bundle.main.path(forResource: "Atari STE GEM Desktop", ofType: "act") {
                         palette.load(withContentsOfFile: filePath)
                     }
                     palette.setColorCount(4)
+                    palette.endUpdates()
                 }
                 image.alphaPlane = false
                 image.setAspectRatio(0.5)
@@ -170,14 +212,64 @@ class AppDelegate: NSObject, NSApplicationDelegate {
                 image.setSize(CGSize(width: 640, height: 400))
                 image.setTileWithWidthOf(1, andHightOf: 1)
                 if let palette = Singleton.sharedInstance()?.image.palette {
+                    palette.beginUpdates()
                     if let filePath = Bundle.main.path(forResource: "Atari STE GEM Desktop", ofType: "act") {
                         palette.load(withContentsOfFile: filePath)
                     }
                     palette.setColorCount(2)
+                    palette.endUpdates()
                 }
                 image.alphaPlane = false
                 image.setAspectRatio(1.0)
                 
+            case 64: // Commodore 64 Sprites, 24x21 with a spare byte after each
+                image.setPlaneCount(1)
+                image.setBitsPerPixel(1)
+                image.setSize(CGSize(width: 24, height: 21 * 8))
+                image.setTileWithWidthOf(24, andHightOf: 21)
+                image.setPadding(1)
+                if let palette = Singleton.sharedInstance()?.image.palette {
+                    if let filePath = Bundle.main.path(forResource: "Commodore 64", ofType: "act") {
+                        palette.load(withContentsOfFile: filePath)
+                    }
+                }
+                image.alphaPlane = false
+                image.setAspectRatio(1.0)
+                
+            case 65: // Commodore 64 Multicolor Sprites, 12x21 double width pixels
+                image.setPlaneCount(1)
+                image.setBitsPerPixel(2)
+                image.setSize(CGSize(width: 12, height: 21 * 8))
+                image.setTileWithWidthOf(12, andHightOf: 21)
+                image.setPadding(1)
+                if let palette = Singleton.sharedInstance()?.image.palette {
+                    if let filePath = Bundle.main.path(forResource: "Commodore 64", ofType: "act") {
+                        palette.load(withContentsOfFile: filePath)
+                    }
+                }
+                image.alphaPlane = false
+                image.setAspectRatio(2.0)
+                
+            case 32: // Game Boy Tiles, the 384 tiles of VRAM
+                image.layout = .gameBoyTiles
+                image.setSize(CGSize(width: 128, height: 192))
+                image.setPadding(0)
+                if let palette = Singleton.sharedInstance()?.image.palette {
+                    if let filePath = Bundle.main.path(forResource: "Game Boy", ofType: "act") {
+                        palette.load(withContentsOfFile: filePath)
+                    }
+                }
+                image.setAspectRatio(1.0)
+                
+            case 33: // Mega Drive Tiles, packed 4 bits per pixel so no tile layout of their own
+                image.setPlaneCount(1)
+                image.setBitsPerPixel(4)
+                image.setSize(CGSize(width: 256, height: 256))
+                image.setTileWithWidthOf(8, andHightOf: 8)
+                image.setPadding(0)
+                image.alphaPlane = false
+                image.setAspectRatio(1.0)
+                
             case 16:
                 image.setPlaneCount(1)
                 image.setBitsPerPixel(16)
@@ -226,13 +318,13 @@ class AppDelegate: NSObject, NSApplicationDelegate {
     
     @IBAction private func pageUp(_ sender: NSMenuItem) {
         if let image = Singleton.sharedInstance()?.image {
-            image.setOffset(image.offset - image.bytesPerLine * Int(image.size.height))
+            image.setOffset(image.offset - Int(image.selected))
         }
     }
     
     @IBAction private func pageDown(_ sender: NSMenuItem) {
         if let image = Singleton.sharedInstance()?.image {
-            image.setOffset(image.offset + image.bytesPerLine * Int(image.size.height))
+            image.setOffset(image.offset + Int(image.selected))
         }
     }
     
@@ -274,6 +366,11 @@ class AppDelegate: NSObject, NSApplicationDelegate {
         updateAllMenus()
     }
     
+    @IBAction private func detectGeometry(_ sender: NSMenuItem) {
+        Singleton.sharedInstance()?.image.detectGeometry()
+        updateAllMenus()
+    }
+    
     @IBAction private func padding(_ sender: NSMenuItem) {
         if let image = Singleton.sharedInstance()?.image {
             image.setPadding(Int(sender.tag))
@@ -349,6 +446,28 @@ class AppDelegate: NSObject, NSApplicationDelegate {
         }
     }
     
+    @IBAction private func exportTrace(_ sender: NSMenuItem) {
+        let savePanel = NSSavePanel()
+        
+        savePanel.title = "eXtractor"
+        savePanel.canCreateDirectories = true
+        savePanel.nameFieldStringValue = "\(NSApp.windows.first?.title ?? "name").json"
+        
+        let modalresponse = savePanel.runModal()
+        if modalresponse == .OK {
+            if let url = savePanel.url {
+                Singleton.sharedInstance()?.mainScene.saveTrace(at: url)
+            }
+        }
+    }
+    
+    @IBAction private func frameTimings(_ sender: NSMenuItem) {
+        if let mainScene = Singleton.sharedInstance()?.mainScene {
+            mainScene.toggleFrameTimings()
+            sender.state = mainScene.showsFrameTimings() ? .on : .off
+        }
+    }
+    
     @IBAction private func imageWidth(_ sender: NSMenuItem) {
         Singleton.sharedInstance()?.image.setSize(CGSize(width: CGFloat(sender.tag), height: (Singleton.sharedInstance()?.image.size.height)!))
         updateAllMenus()
@@ -376,6 +495,32 @@ class AppDelegate: NSObject, NSApplicationDelegate {
                         image.setBitsPerPixel(16) // bitsPerPlane!
                     }
                 }
+                
+            case 2: // ZX Spectrum Screen
+                image.layout = .zxScreen
+                
+            case 3: // C64 Hires Bitmap
+                image.layout = .c64Hires
+                image.setAspectRatio(1.0)
+                
+            case 4: // C64 Multicolor Bitmap
+                image.layout = .c64Multicolor
+                image.setAspectRatio(2.0)
+                
+            case 5: // Game Boy Tiles
+                image.layout = .gameBoyTiles
+                
+            case 6: // NES Tiles
+                image.layout = .nesTiles
+                
+            case 7: // SNES 4bpp Tiles
+                image.layout = .snes4BitTiles
+                
+            case 8: // SNES 8bpp Tiles
+                image.layout = .snes8BitTiles
+                
+            case 9: // Master System Tiles
+                image.layout = .masterSystemTiles
             default:
                 break
             }
@@ -384,6 +529,14 @@ class AppDelegate: NSObject, NSApplicationDelegate {
         updateAllMenus()
     }
     
+    // The tiles at the offset become the tileset, move to the map and size it in tiles.
+    @IBAction private func tilemap(_ sender: NSMenuItem) {
+        if let image = Singleton.sharedInstance()?.image {
+            image.tilemap = ImageTilemap(rawValue: sender.tag) ?? .off
+        }
+        updateAllMenus()
+    }
+    
     @IBAction func pixelFormat(_ sender: NSMenuItem) {
         if let image = Singleton.sharedInstance()?.image {
 
@@ -399,6 +552,18 @@ class AppDelegate: NSObject, NSApplicationDelegate {
                 
             case 1555:
                 image.pixelFormat = .ARGB555
+                
+            case -555:
+                image.pixelFormat = .BGR555
+                
+            case -565:
+                image.pixelFormat = .BGR565
+                
+            case 444:
+                image.pixelFormat = .RGB444
+                
+            case 4444:
+                image.pixelFormat = .ARGB4444
 
             default:
                 image.pixelFormat = .RGB555
@@ -536,6 +701,12 @@ class AppDelegate: NSObject, NSApplicationDelegate {
                         menu.item(withTitle: "Game Palette")?.state = image.palette.game ? .on : .off
                     }
                 }
+                
+                // Snapshot memory, neither is on when no snapshot is open.
+                if let view = Singleton.sharedInstance()?.mainScene.snapshotView() {
+                    menu.item(withTitle: "48K Memory")?.state = view == 0 ? .on : .off
+                    menu.item(withTitle: "128K Banks")?.state = view == 1 ? .on : .off
+                }
             }
             
             // Big Edian
@@ -546,7 +717,24 @@ class AppDelegate: NSObject, NSApplicationDelegate {
             
             // Pixel Arrangement
             if let menu = mainMenu.item(at: 2)?.submenu?.item(withTitle: "Pixel Arrangement")?.submenu {
-                if image.planeCount == 1 {
+                menu.item(withTitle: "ZX Spectrum Screen")?.state = image.layout == .zxScreen ? .on : .off
+                menu.item(withTitle: "C64 Hires Bitmap")?.state = image.layout == .c64Hires ? .on : .off
+                menu.item(withTitle: "C64 Multicolor Bitmap")?.state = image.layout == .c64Multicolor ? .on : .off
+                menu.item(withTitle: "Game Boy Tiles")?.state = image.layout == .gameBoyTiles ? .on : .off
+                menu.item(withTitle: "NES Tiles")?.state = image.layout == .nesTiles ? .on : .off
+                menu.item(withTitle: "SNES 4bpp Tiles")?.state = image.layout == .snes4BitTiles ? .on : .off
+                menu.item(withTitle: "SNES 8bpp Tiles")?.state = image.layout == .snes8BitTiles ? .on : .off
+                menu.item(withTitle: "Master System Tiles")?.state = image.layout == .masterSystemTiles ? .on : .off
+                
+                if image.layout != .linear {
+                    // Screens, bitmaps and console tiles have a layout of their own, bitmap then attributes or colors, or bitplanes.
+                    menu.item(withTitle: "Planar")?.state = .off
+                    menu.item(withTitle: "Packed")?.state = .off
+                    
+                    mainMenu.item(at: 2)?.submenu?.item(withTitle: "Color Depth")?.isEnabled = false
+                    mainMenu.item(at: 2)?.submenu?.item(withTitle: "Planes")?.isEnabled = false
+                    
+                } else if image.planeCount == 1 {
                     // Packed...
                     menu.item(withTitle: "Planar")?.state = .off
                     menu.item(withTitle: "Packed")?.state = .on
@@ -583,12 +771,24 @@ class AppDelegate: NSObject, NSApplicationDelegate {
                     }
                 }
                 
+                if let menu = menu.item(withTitle: "Tilemap")?.submenu {
+                    for item in menu.items {
+                        item.state = item.tag == image.tilemap.rawValue ? .on : .off
+                    }
+                }
+                // Pictures are not drawn from a tilemap, console tiles are.
+                menu.item(withTitle: "Tilemap")?.isEnabled = image.layout == .linear || image.layout.rawValue >= ImageLayout.gameBoyTiles.rawValue
+                
                 if let menu = menu.item(withTitle: "Pixel Format")?.submenu {
                     if let image = Singleton.sharedInstance()?.image {
                         menu.item(withTitle: "RGB555")?.state = image.pixelFormat == .RGB555 ? .on : .off
                         menu.item(withTitle: "RGB565")?.state = image.pixelFormat == .RGB565 ? .on : .off
                         menu.item(withTitle: "RGBA555")?.state = image.pixelFormat == .RGBA555 ? .on : .off
                         menu.item(withTitle: "ARGB555")?.state = image.pixelFormat == .ARGB555 ? .on : .off
+                        menu.item(withTitle: "BGR555")?.state = image.pixelFormat == .BGR555 ? .on : .off
+                        menu.item(withTitle: "BGR565")?.state = image.pixelFormat == .BGR565 ? .on : .off
+                        menu.item(withTitle: "RGB444")?.state = image.pixelFormat == .RGB444 ? .on : .off
+                        menu.item(withTitle: "ARGB4444")?.state = image.pixelFormat == .ARGB4444 ? .on : .off
                     }
                 }
                 if let image = Singleton.sharedInstance()?.image {
@@ -29,7 +29,35 @@ typedef NS_ENUM(NSInteger, ImagePixelFormat) {
     ImagePixelFormatRGB555,
     ImagePixelFormatRGB565,
     ImagePixelFormatRGBA555,
-    ImagePixelFormatARGB555
+    ImagePixelFormatARGB555,
+    ImagePixelFormatBGR555,
+    ImagePixelFormatBGR565,
+    ImagePixelFormatRGB444,
+    ImagePixelFormatARGB4444
+};
+
+// Layouts of pictures decoded where they are stored, stacked one above the other, or of console tiles, see RenderLayout.
+typedef NS_ENUM(NSInteger, ImageLayout) {
+    ImageLayoutLinear,
+    ImageLayoutZXScreen,            // ZX Spectrum screens of 6912 bytes
+    ImageLayoutC64Hires,            // Commodore 64 bitmaps and screen RAM
+    ImageLayoutC64Multicolor,       // Commodore 64 bitmaps, screen RAM, color RAM and background, as saved by Koala Painter
+    ImageLayoutGameBoyTiles,        // 8 by 8 tiles of 2 bits per pixel, the two planes of each row interleaved
+    ImageLayoutNESTiles,            // 8 by 8 tiles of 2 bits per pixel, the two planes one after the other
+    ImageLayoutSNES4BitTiles,       // 8 by 8 tiles of 4 bits per pixel, two pairs of Game Boy planes
+    ImageLayoutSNES8BitTiles,       // 8 by 8 tiles of 8 bits per pixel, four pairs of Game Boy planes
+    ImageLayoutMasterSystemTiles    // 8 by 8 tiles of 4 bits per pixel, the four planes of each row interleaved
+};
+
+// Formats of the map of tile indices drawn against the tileset, see RenderTilemapFormat.
+typedef NS_ENUM(NSInteger, ImageTilemap) {
+    ImageTilemapOff,
+    ImageTilemap8Bit,
+    ImageTilemap16Bit,
+    ImageTilemapSNES,
+    ImageTilemapMegaDrive,
+    ImageTilemapCommanderX16,
+    ImageTilemapSpectrumNext
 };
 
 @interface Image: SKNode
@@ -50,27 +78,41 @@ typedef NS_ENUM(NSInteger, ImagePixelFormat) {
 @property (readonly) NSInteger padding;
 @property (nonatomic) NSUInteger tileWidth;
 @property (nonatomic) NSUInteger tileHeight;
+@property (nonatomic) ImageLayout layout;       // Rows of pixels laid out as the other properties describe, or pictures of a fixed layout
+@property (nonatomic) ImageTilemap tilemap;     // The data at the offset drawn as a map of the tiles at tilesetOffset
+@property (readonly) NSInteger tilesetOffset;   // Offset when the map was turned on, its tiles laid out as the other properties describe
 
 @property (readonly) Palette *palette;
 
-@property (readonly) NSData* data;
 @property (readonly) NSUInteger zoom;
 @property (readonly) NSInteger offset;
 @property (readonly) NSUInteger selected;
 @property (readonly) NSUInteger bytes;
 
+@property (nonatomic) NSUInteger cacheSize;     // Bytes of decoded pages kept for going back to them
+@property (readonly) NSUInteger cacheHits;      // Tiles drawn from the cache
+@property (readonly) NSUInteger cacheMisses;    // Tiles decoded from the data
+@property (readonly) NSString *frameTimings;    // Time each phase of the last frame took, empty unless tracing
+
 // MARK: - Class Init
 
 -(id)initWithSize:(CGSize)size;
 
 // MARK: - Class Instance Methods
 
--(void)firstAtariSTPalette;
--(void)nextAtariSTPalette;
+-(void)firstStoredPalette;
+-(void)nextStoredPalette;
+-(void)previousStoredPalette;
+-(void)detectGeometry;      // Guesses width, bits per pixel, planes and padding from the bytes at the offset
+-(NSInteger)findImage:(CGImageRef)reference NS_SWIFT_NAME(findImage(_:));   // Shows the first place the reference is stored, returns the number of places
+-(void)findNextImage;
 -(void)modifyWithContentsOfURL:(NSURL*)url;
+-(const void *)bytesAtOffset:(NSInteger)offset length:(NSInteger)length; // Valid until the next call on the image
+-(void)modifyBytesAtOffset:(NSInteger)offset length:(NSInteger)length withBlock:(void (^)(void *bytes))block;
 
 
 -(void)updateWithDelta:(NSTimeInterval)delta;
+-(void)panBy:(CGPoint)delta;      // Moves the view across an image larger than the screen, in image pixels
 -(void)saveImageAtURL:(NSURL *)url;
 
 
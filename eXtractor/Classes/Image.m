@@ -35,19 +35,39 @@ typedef struct {
 
 #pragma pack()   /* restore original alignment from stack */
 
-@interface Image()
+typedef NS_ENUM(NSInteger, FramePhase) {
+    FramePhasePalette,
+    FramePhaseLabels,
+    FramePhaseBorder,
+    FramePhaseDraw,
+    FramePhaseCount
+};
+
+@interface Image() {
+    uint64_t _phaseTime[FramePhaseCount];   // Nanoseconds each phase of the last frame took while tracing
+}
 
 
 // MARK: - Private Properties
 
 @property SKMutableTexture *mutableTexture;
-@property NSMutableData *mutableData;
-@property NSMutableData *scratchData;
+@property DataSource *source;
+@property RenderCanvas *canvas;
+@property RenderTileset *tileset;   // Decoded on first use, dropped whenever the data changes
+@property NSUInteger tilesetChangeCount;    // Palette the tiles were decoded with, when they hold pixels
+@property NSMutableData *paletteData;
+@property NSUInteger paletteChangeCount;
+@property CGPoint viewOrigin;       // Top left pixel of the image shown when larger than the texture
+@property NSTimeInterval flashTime; // Since the ink and paper of ZX screen FLASH cells last swapped
+@property BOOL flashInverted;
 
 
 @property BOOL changes;
 
-@property NSInteger paletteOffset;
+@property PaletteIndex *paletteIndex;     // Built on first use, dropped whenever the data changes
+@property NSInteger paletteCursor;
+@property NSData *imageMatches;     // RenderMatch of every place the last reference was found
+@property NSInteger imageCursor;
 
 @end
 
@@ -82,17 +102,25 @@ typedef struct {
     return self;
 }
 
+- (void)dealloc {
+    closeDataSource(_source);
+    closeCanvas(_canvas);
+    closeTileset(_tileset);
+    closePaletteIndex(_paletteIndex);
+}
+
 - (void)setupWithSize:(CGSize)size {
     NSUInteger lengthInBytes = (NSUInteger)size.width * (NSUInteger)size.height * sizeof(UInt32);
     
     self.mutableTexture = [[SKMutableTexture alloc] initWithSize:size];
-    self.mutableData = [[NSMutableData alloc] initWithCapacity:(NSUInteger)2^32];
-    self.mutableData.length = lengthInBytes;
+    self.source = createDataSource(lengthInBytes);
     
-    self.scratchData = [[NSMutableData alloc] initWithCapacity:lengthInBytes];
-    self.scratchData.length = lengthInBytes;
+    // Room for the pages of a good many offsets and geometries, more whenever the view needs it.
+    _cacheSize = 128 * 1024 * 1024;
+    self.canvas = createCanvas(_cacheSize);
     
-    _data = (NSData*)self.mutableData;
+    self.paletteData = [[NSMutableData alloc] initWithLength:sizeof(RenderPalette)];
+    self.paletteChangeCount = NSUIntegerMax;
     
     
     
@@ -136,78 +164,187 @@ typedef struct {
 
 // MARK: - Public Instance Methods
 
-- (void)firstAtariSTPalette {
-    self.paletteOffset = 0;
-    [self findAtariSTPalette];
+- (void)firstStoredPalette {
+    [self findStoredPaletteFrom:0 step:1];
 }
 
-- (void)nextAtariSTPalette {
-    self.paletteOffset += 2;
-    [self findAtariSTPalette];
+- (void)nextStoredPalette {
+    [self findStoredPaletteFrom:self.paletteCursor + 1 step:1];
 }
 
-- (void)findAtariSTPalette {
-    const UInt8 *bytes = (const UInt8 *)self.mutableData.bytes + self.paletteOffset;
-    NSInteger limit = self.mutableData.length - sizeof(UInt16) * 16;
+- (void)previousStoredPalette {
+    [self findStoredPaletteFrom:self.paletteCursor - 1 step:-1];
+}
 
-    while (self.paletteOffset <= limit) {
-        const UInt16* pal = ( const UInt16* )bytes;
-        if (self.palette.game == YES && pal[0] != 0) {
-            self.paletteOffset++;
-            bytes++;
-            continue;
-        }
-        if ([Palette isAtariSteFormat:( const UInt16* )bytes] == YES) {
-            for (int i=0; i<16; i++) {
-                [self.palette setRgbColor:[Palette colorFrom12BitRgb:pal[i]] atIndex:i];
-            }
-            [self.palette setColorCount:16];
-            [self.palette setTransparentIndex:0];
-            return;
-        } else if ([Palette isAtariStFormat:( const UInt16* )bytes] == YES) {
-            for (int i=0; i<16; i++) {
-                [self.palette  setRgbColor:[Palette colorFrom9BitRgb:pal[i]] atIndex:i];
-            }
-            [self.palette setColorCount:16];
-            [self.palette setTransparentIndex:0];
-            return;
-        }
-        self.paletteOffset++;
-        bytes++;
+- (void)detectGeometry {
+    NSInteger length = dataSourceLength(self.source) - self.offset;
+    RenderHypothesis hypothesis;
+    
+    if (length <= 0) return;
+    if (detectGeometry(self.source, self.offset, &hypothesis, 1) == 0) return;
+    
+    const RenderGeometry *geometry = &hypothesis.geometry;
+    self.alphaPlane = NO;
+    self.maskPlane = NO;
+    [self setTileWithWidthOf:1 andHightOf:1];
+    [self setPlaneCount:(UInt32)geometry->planeCount];
+    [self setBitsPerPixel:(UInt32)geometry->bitsPerPixel];
+    [self setPadding:geometry->padding];
+    [self setSize:CGSizeMake(geometry->width, geometry->height)];
+}
+
+- (NSInteger)findImage:(CGImageRef)reference {
+    size_t width = CGImageGetWidth(reference);
+    size_t height = CGImageGetHeight(reference);
+    NSMutableData *pixelData = [NSMutableData dataWithLength:width * height * sizeof(UInt32)];
+    
+    // [A B G R] as the kernels draw, transparent pixels match anything.
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = CGBitmapContextCreate(pixelData.mutableBytes, width, height, 8, width * sizeof(UInt32), colorSpace, kCGImageAlphaPremultipliedLast | kCGBitmapByteOrder32Big);
+    CGColorSpaceRelease(colorSpace);
+    if (context == NULL) return 0;
+    CGContextDrawImage(context, CGRectMake(0, 0, width, height), reference);
+    CGContextRelease(context);
+    
+    NSMutableData *matches = [NSMutableData dataWithLength:256 * sizeof(RenderMatch)];
+    int count = searchImage(self.source, pixelData.bytes, (int)width, (int)height, [self renderPalette], matches.mutableBytes, 256);
+    if (count <= 0) {
+        self.imageMatches = nil;
+        return 0;
     }
     
+    matches.length = count * sizeof(RenderMatch);
+    self.imageMatches = matches;
+    self.imageCursor = 0;
+    [self showImageMatch];
+    return count;
+}
+
+- (void)findNextImage {
+    if (self.imageMatches == nil) return;
     
+    self.imageCursor = (self.imageCursor + 1) % (NSInteger)(self.imageMatches.length / sizeof(RenderMatch));
+    [self showImageMatch];
+}
+
+// Atari ST, STE and ZX Spectrum Next palettes of 16 colors, in the order they are stored.
+- (void)findStoredPaletteFrom:(NSInteger)cursor step:(NSInteger)step {
+    if (self.paletteIndex == NULL) {
+        self.paletteIndex = createPaletteIndex(self.source, PaletteFormatAtariST | PaletteFormatAtariSTE | PaletteFormatNext);
+        if (self.paletteIndex == NULL) return;
+    }
     
-    self.changes = YES;
+    for (; cursor >= 0 && cursor < self.paletteIndex->count; cursor += step) {
+        const PaletteCandidate *candidate = &self.paletteIndex->candidates[cursor];
+        if (self.palette.game == YES && candidate->backgroundBlack == NO) continue;
+        
+        const UInt16* pal = ( const UInt16* )dataSourceBytes(self.source, candidate->offset, sizeof(UInt16) * 16);
+        if (pal == NULL) return;
+        
+        UInt32 colors[16];
+        for (int i=0; i<16; i++) {
+            switch (candidate->format) {
+                case PaletteFormatAtariST:
+                    colors[i] = [Palette colorFrom9BitRgb:pal[i]];
+                    break;
+                    
+                case PaletteFormatNext:
+                    colors[i] = [Palette colorFrom9BitNextRgb:pal[i]];
+                    break;
+                    
+                default:
+                    colors[i] = [Palette colorFrom12BitRgb:pal[i]];
+                    break;
+            }
+        }
+        [self.palette beginUpdates];
+        [self.palette setRgbColors:colors count:16];
+        [self.palette setColorCount:16];
+        [self.palette setTransparentIndex:0];
+        [self.palette endUpdates];
+        self.paletteCursor = cursor;
+        return;
+    }
 }
 
 -(void)modifyWithContentsOfURL:(NSURL*)url {
-    NSData *data = [NSData dataWithContentsOfURL:url];
-    self.mutableData.length = data.length;
-    [self.mutableData setData:data];
+    DataSource *source = openDataSource(url.fileSystemRepresentation);
+    if (source == NULL) return;
+    
+    closeDataSource(self.source);
+    self.source = source;
+    invalidateCanvas(self.canvas);
+    [self dropPaletteIndex];
+    [self dropTileset];
+    
+    // Views jump around the file, so don't let the kernel read ahead of them.
+    adviseDataSource(self.source, DataSourceAccessRandom, 0, 0);
     [self setOffset:0];
+    self.changes = YES;
 }
 
+-(const void *)bytesAtOffset:(NSInteger)offset length:(NSInteger)length {
+    return dataSourceBytes(self.source, offset, length);
+}
+
+-(void)modifyBytesAtOffset:(NSInteger)offset length:(NSInteger)length withBlock:(void (^)(void *bytes))block {
+    void *bytes = beginDataSourceWrite(self.source, offset, length);
+    if (bytes == NULL) return;
+    
+    block(bytes);
+    endDataSourceWrite(self.source, offset, length);
+    invalidateCanvas(self.canvas);
+    [self dropPaletteIndex];
+    [self dropTileset];
+    self.changes = YES;
+}
 
 
+
+// The whole image is saved, not just the part of it in view.
 -(void)saveImageAtURL:(NSURL *)url {
-    [self.mutableTexture modifyPixelDataWithBlock:^(void *pixelData, size_t lengthInBytes) {
-        CGImageRef imageRef = [Extenions createCGImageFromPixelData:pixelData ofSize:self.mutableTexture.size];
-        [Extenions writeCGImage:imageRef to:url];
-    }];
+    if (self.tilemap != ImageTilemapOff) {
+        [self saveTilemapAtURL:url];
+        return;
+    }
+    
+    RenderGeometry geometry = [self geometry];
+    if (geometry.height < 1) return;
+    
+    const UInt8 *bytes = dataSourceBytes(self.source, self.offset, bytesPerImage(&geometry));
+    if (bytes == NULL) return;
+    
+    NSMutableData *pixelData = [[NSMutableData alloc] initWithLength:(NSUInteger)geometry.width * (NSUInteger)geometry.height * sizeof(UInt32)];
+    renderToPixelData(&geometry, [self renderPalette], NULL, bytes, pixelData.mutableBytes, geometry.width);
+    
+    CGImageRef imageRef = [Extenions createCGImageFromPixelData:pixelData.bytes ofSize:CGSizeMake(geometry.width, geometry.height)];
+    [Extenions writeCGImage:imageRef to:url];
 }
 
 -(void)updateWithDelta:(NSTimeInterval)delta {
+    uint64_t frame = traceBegin();
+    uint64_t start = traceBegin();
+    
     if ([self.palette updateWithDelta:delta] == YES) {
         self.changes = YES;
     }
     
-    
+    // FLASH cells swap their ink and paper every 16 frames of the 50Hz display, only their colors change.
+    if (self.layout == ImageLayoutZXScreen) {
+        self.flashTime += delta;
+        if (self.flashTime >= 16.0 / 50.0) {
+            self.flashTime = 0.0;
+            self.flashInverted = !self.flashInverted;
+            self.changes = YES;
+        }
+    }
+    _phaseTime[FramePhasePalette] = traceEnd("palette cycling", start);
     
     
     
     if (self.changes == NO) return;
     
+    start = traceBegin();
     ViewController *viewController = (ViewController *)NSApplication.sharedApplication.windows.firstObject.contentViewController;
     
     viewController.widthText.stringValue = [NSString stringWithFormat:@"%d", (int)self.size.width];
@@ -223,678 +360,280 @@ typedef struct {
     }
     
     viewController.infoText.stringValue = [NSString stringWithFormat:@"%ld bytes selected at offset %ld out of %ld bytes", self.selected, self.offset, self.bytes];
+    _phaseTime[FramePhaseLabels] = traceEnd("labels", start);
+    
     
     
+    RenderGeometry geometry = [self geometry];
+    CGRect view = [self visibleRect];
     
+    // Each line of a map is a row of tiles.
+    NSInteger lineHeight = self.tilemap != ImageTilemapOff ? (NSInteger)self.tileHeight : 1;
+    adviseDataSource(self.source, DataSourceAccessWillNeed, self.offset + (NSInteger)view.origin.y / lineHeight * self.bytesPerLine, (NSInteger)view.size.height / lineHeight * self.bytesPerLine);
+    
+    /*
+     Tiles are decoded as they come into view, the palette only colors those of indexed images again.
+     The canvas writes every pixel of the image in view, so only the border around it is cleared.
+     */
     [self.mutableTexture modifyPixelDataWithBlock:^(void *pixelData, size_t lengthInBytes) {
-        memset(pixelData, 0, lengthInBytes);
-      
+        uint64_t start = traceBegin();
+        [self clearBorderOfPixelData:pixelData];
+        self->_phaseTime[FramePhaseBorder] = traceEnd("clear border", start);
         
-        if (self.planeCount > 1) {
-            if (self.bitsPerPixel == 8) {
-                [self planer8BitToPixelData:pixelData];
-            }
-            if (self.bitsPerPixel == 16) {
-                if (self.maskPlane == YES) {
-                    [self mask16BitToPixelData:pixelData];
-                } else {
-                    [self planer16BitToPixelData:pixelData];
-                }
-            }
-        }
-        
-        if (self.planeCount <= 1) {
-            if (self.bitsPerPixel == 1) {
-                [self packed1BitToPixelData:pixelData];
-            }
-            if (self.bitsPerPixel == 2) {
-                [self packed2BitToPixelData:pixelData];
-            }
-            if (self.bitsPerPixel == 4) {
-                [self packed4BitToPixelData:pixelData];
-            }
-            if (self.bitsPerPixel == 8) {
-                [self packed8BitToPixelData:pixelData];
-            }
+        start = traceBegin();
+        if (self.tilemap != ImageTilemapOff) {
+            [self drawTilemapInRect:view ofPixelData:pixelData];
+        } else {
+            drawCanvas(self.canvas, self.source, self.offset, &geometry, [self renderPalette], self.palette.changeCount,
+                       (int)view.origin.x, (int)view.origin.y, (int)view.size.width, (int)view.size.height,
+                       [self originOfPixelData:pixelData], (long)self.mutableTexture.size.width);
         }
-        
+        self->_phaseTime[FramePhaseDraw] = traceEnd("draw", start);
     }];
     
-   
-    if (self.planeCount <= 1) {
-        if (self.bitsPerPixel == 24) {
-            if (self.alphaPlane) {
-                [self packed32Bit];
-            }
-            if (!self.alphaPlane) {
-                [self packed24Bit];
-            }
-            [self renderTexture];
-        }
-        
-        if (self.bitsPerPixel == 16) {
-            [self render16KImageDataToScratchData];
-            [self renderTexture];
-        }
-        
-    }
-    
     self.changes = NO;
+    traceEnd("frame", frame);
+    traceCounters();
 }
 
-- (void)renderTexture {
-    [self.mutableTexture modifyPixelDataWithBlock:^(void *pixelData, size_t lengthInBytes) {
-        memset(pixelData, 0, lengthInBytes);
-        if (self.tileWidth > 1 && self.tileHeight > 1) {
-            [self renderAsTilesToPixelData:pixelData];
-        } else {
-            [self renderAsImageToPixelData:pixelData];
-        }
-    }];
+-(NSString *)frameTimings {
+    if (isTracing() == NO) return @"";
+    
+    return [NSString stringWithFormat:@"palette %.2f ms  labels %.2f ms  border %.2f ms  draw %.2f ms  decoded %ld bytes  written %ld pixels  palette redraws %ld",
+            _phaseTime[FramePhasePalette] / 1e6, _phaseTime[FramePhaseLabels] / 1e6, _phaseTime[FramePhaseBorder] / 1e6, _phaseTime[FramePhaseDraw] / 1e6,
+            traceTotal(TraceCounterBytesDecoded), traceTotal(TraceCounterPixelsWritten), traceTotal(TraceCounterPaletteRedraws)];
 }
 
-- (void)renderAsImageToPixelData:(void *)pixelData {
-    NSUInteger s = self.mutableTexture.size.width;
-    NSUInteger l = self.mutableTexture.size.height;
-    
-    NSUInteger w = self.size.width;
-    NSUInteger h = self.size.height;
-    
-    UInt32 *src = (UInt32 *)self.scratchData.bytes;
-    UInt32 *dst = (UInt32 *)pixelData;
-    
-    for (NSUInteger r = (l - h) / 2; r < l - (l - h) / 2; ++r) {
-        for (NSUInteger c = (s - w) / 2; c < s - (s - w) / 2; ++c) {
-            dst[r * s + c] = *src++;
-        }
-    }
+-(void)panBy:(CGPoint)delta {
+    self.viewOrigin = CGPointMake(self.viewOrigin.x + delta.x, self.viewOrigin.y + delta.y);
+    self.changes = YES;
 }
 
-- (void)renderAsTilesToPixelData:(void *)pixelData {
-    NSUInteger s = self.mutableTexture.size.width;
-    NSUInteger l = self.mutableTexture.size.height;
-    
-    NSUInteger w = self.size.width;
-    NSUInteger h = self.size.height;
+- (NSInteger)deltaWidth {
+    if (self.tileWidth > 1) {
+        return self.tileWidth;
+    }
     
-    UInt32 *src = (UInt32 *)self.scratchData.bytes;
-    UInt32 *dst = (UInt32 *)pixelData;
+    if (self.planeCount > 1) {
+        return self.bitsPerPixel;
+    }
     
-    for (NSUInteger r = (l - h) / 2; r < l - (l - h) / 2; r += self.tileHeight) {
-        for (NSUInteger c = (s - w) / 2; c < s - (s - w) / 2; c += self.tileWidth) {
-            for (NSUInteger y = 0; y < self.tileHeight; y++) {
-                for (NSUInteger x = 0; x < self.tileWidth; x++) {
-                    dst[(r + y) * s + c + x] = *src++;
-                }
-            }
-        }
+    if (self.bitsPerPixel <= 8) {
+        return 8 / self.bitsPerPixel;
     }
+    
+    return 1;
 }
 
-- (void)packed1BitToPixelData:(void *)pixelData {
-    UInt32 *pixel = pixelData;
-    const unsigned char *bytes = self.mutableData.bytes + self.offset;
-    
-    NSUInteger s = self.mutableTexture.size.width;
-    NSUInteger l = self.mutableTexture.size.height;
-    
-    NSUInteger w = self.size.width;
-    NSUInteger h = self.size.height;
-    
-    UInt8 data;
-    
-    if (self.tileWidth > 1 && self.tileHeight > 1) {
-        for (NSUInteger r = (l - h) / 2; r < l - (l - h) / 2; r+=self.tileHeight) {
-            for (NSUInteger c = (s - w) / 2; c < s - (s - w) / 2; c+=self.tileWidth) {
-                for (NSUInteger y = 0; y < self.tileHeight; y++) {
-                    for (NSUInteger x = 0; x < self.tileWidth; x++) {
-                        data = bytes[0];
-                        NSUInteger b = x % 8;
-                        pixel[(r + y) * s + c + x] = (data & 1 << (7 - b)) ? 0xffffffff : 0;
-                        if (b == 7) bytes += 1;
-                    }
-                }
-            }
-        }
-    } else {
-        for (NSUInteger r = (l - h) / 2; r < l - (l - h) / 2; ++r) {
-            for (NSUInteger c = (s - w) / 2; c < s - (s - w) / 2; c+=8) {
-                data = bytes[0];
-                for (NSUInteger b = 0; b <= 7; b++) {
-                    pixel[r * s + c + b] = (data & 1 << (7 - b)) ? 0xffffffff : 0;
-                }
-                bytes += 1;
-            }
-        }
-    }
+// MARK: - Private Methods
+
+// Lays the image out as the current match is stored, with the reference at the top left.
+- (void)showImageMatch {
+    const RenderMatch *match = (const RenderMatch *)self.imageMatches.bytes + self.imageCursor;
+    
+    self.alphaPlane = NO;
+    self.maskPlane = NO;
+    [self setTileWithWidthOf:1 andHightOf:1];
+    [self setPlaneCount:(UInt32)match->geometry.planeCount];
+    [self setBitsPerPixel:(UInt32)match->geometry.bitsPerPixel];
+    [self setBigEndian:match->geometry.bigEndian];
+    [self setPadding:0];
+    [self setSize:CGSizeMake(match->geometry.width, self.size.height)];
+    [self setOffset:match->offset];
 }
-/*
-- (void)packed2Bit {
-    UInt8 *src = (UInt8 *)self.mutableData.bytes + self.offset;
-    UInt32 *dst = (UInt32 *)self.scratchData.bytes;
-    NSUInteger length = (NSUInteger)self.size.width * (NSUInteger)self.size.height;
-    NSUInteger blockSize = self.tileWidth / 4 * self.tileHeight;
-    
-    while (length) {
-        for (NSUInteger i = 0; i < blockSize; i++) {
-            UInt8 data = *src;
-            for (NSUInteger n = 0; n < 4; n++) {
-                NSUInteger indexColor = data & 0b11;
-                if (indexColor == self.palette.transparentIndex && self.alphaPlane == YES) {
-                    dst[3 - n] = 0;
-                } else {
-                    dst[3 - n] = [self.palette rgbColorAtIndex:indexColor];
-                }
-                data >>= 2;
-            }
-            dst += 4;
-            src += 1;
-        }
-        src += self.padding;
-        length -= blockSize;
-    }
+
+- (void)dropPaletteIndex {
+    closePaletteIndex(self.paletteIndex);
+    self.paletteIndex = NULL;
+    self.paletteCursor = 0;
 }
-*/
-     
-- (void)packed2BitToPixelData:(void *)pixelData {
-    UInt32 *pixel = pixelData;
-    const unsigned char *bytes = self.mutableData.bytes + self.offset;
-    
-    NSUInteger s = self.mutableTexture.size.width;
-    NSUInteger l = self.mutableTexture.size.height;
-    
-    NSUInteger w = self.size.width;
-    NSUInteger h = self.size.height;
-    
-    UInt8 data;
-    
-    for (NSUInteger r = (l - h) / 2; r < l - (l - h) / 2; ++r) {
-        for (NSUInteger c = (s - w) / 2; c < s - (s - w) / 2; c+=4) {
-            data = bytes[0];
-            for (NSUInteger i = 0; i < 4; i++) {
-                NSUInteger index = data & 0b11;
-                UInt32 rgb = [self.palette rgbColorAtIndex:index];
-                if (index == self.palette.transparentIndex && self.alphaPlane == YES) {
-                    rgb = 0;
-                }
-                pixel[r * s + c + 1 - i] = rgb;
-                data >>= 2;
-            }
-            bytes += 1;
-        }
-    }
+
+- (void)dropTileset {
+    closeTileset(self.tileset);
+    self.tileset = NULL;
 }
 
-- (void)packed4BitToPixelData:(void *)pixelData {
-    UInt32 *pixel = pixelData;
-    const unsigned char *bytes = self.mutableData.bytes + self.offset;
-    
-    NSUInteger s = self.mutableTexture.size.width;
-    NSUInteger l = self.mutableTexture.size.height;
-    
-    NSUInteger w = self.size.width;
-    NSUInteger h = self.size.height;
-    
-    UInt8 data;
-    if (self.tileWidth > 1 && self.tileHeight > 1) {
-        for (NSUInteger r = (l - h) / 2; r < l - (l - h) / 2; r+=self.tileHeight) {
-            for (NSUInteger c = (s - w) / 2; c < s - (s - w) / 2; c+=self.tileWidth) {
-                for (NSUInteger y = 0; y < self.tileHeight; y++) {
-                    for (NSUInteger x = 0; x < self.tileWidth; x++) {
-                        data = bytes[0];
-                        for (NSUInteger i = 0; i < 2; i++) {
-                            NSUInteger index = data & 0b1111;
-                            UInt32 rgb = [self.palette rgbColorAtIndex:index];
-                            if (index == self.palette.transparentIndex && self.alphaPlane == YES) {
-                                rgb = 0;
-                            }
-                            pixel[(r + y) * s + c + x + 1 - i] = rgb;
-                            data >>= 4;
-                        }
-                        bytes += 1;
-                    }
-                }
-            }
-        }
-    } else {
-        for (NSUInteger r = (l - h) / 2; r < l - (l - h) / 2; ++r) {
-            for (NSUInteger c = (s - w) / 2; c < s - (s - w) / 2; c+=2) {
-                data = bytes[0];
-                for (NSUInteger i = 0; i < 2; i++) {
-                    NSUInteger index = data & 0b1111;
-                    UInt32 rgb = [self.palette rgbColorAtIndex:index];
-                    if (index == self.palette.transparentIndex && self.alphaPlane == YES) {
-                        rgb = 0;
-                    }
-                    pixel[r * s + c + 1 - i] = rgb;
-                    data >>= 4;
-                }
-                bytes += 1;
-            }
-        }
-    }
+// Layout of a single tile of the tileset.
+- (RenderGeometry)tileGeometry {
+    RenderGeometry geometry = [self geometry];
+    geometry.width = (int)self.tileWidth;
+    geometry.height = (int)self.tileHeight;
+    return geometry;
 }
 
-- (void)packed8BitToPixelData:(void *)pixelData {
-    UInt32 *pixel = pixelData;
-    const unsigned char *bytes = self.mutableData.bytes + self.offset;
-    
-    NSUInteger s = self.mutableTexture.size.width;
-    NSUInteger l = self.mutableTexture.size.height;
-    
-    NSUInteger w = self.size.width;
-    NSUInteger h = self.size.height;
-    
-    if (self.tileWidth > 1 && self.tileHeight > 1) {
-        for (NSUInteger r = (l - h) / 2; r < l - (l - h) / 2; r+=self.tileHeight) {
-            for (NSUInteger c = (s - w) / 2; c < s - (s - w) / 2; c+=self.tileWidth) {
-                for (NSUInteger y = 0; y < self.tileHeight; y++) {
-                    for (NSUInteger x = 0; x < self.tileWidth; x++) {
-                        int i;
-                        i = [self.palette rgbColorAtIndex:bytes[0]];
-                        if (self.palette.transparentIndex == i && self.alphaPlane == YES) {
-                            i = 0;
-                        }
-                        pixel[(r + y) * s + c + x] = i;
-                        bytes += 1;
-                    }
-                }
-            }
-        }
-    } else {
-        for (NSUInteger r = (l - h) / 2; r < l - (l - h) / 2; ++r) {
-            for (NSUInteger c = (s - w) / 2; c < s - (s - w) / 2; ++c) {
-                int i;
-                i = [self.palette rgbColorAtIndex:bytes[0]];
-                if (self.palette.transparentIndex == i && self.alphaPlane == YES) {
-                    i = 0;
-                }
-                pixel[r * s + c] = i;
-                bytes += 1;
-            }
-        }
-    }
-    
-    
+// Map of the tiles in view, clipped to the rows the data from the offset holds.
+- (RenderTilemap)renderTilemap {
+    RenderTilemap map = {
+        .width = (int)(self.size.width / self.tileWidth),
+        .height = (int)(self.size.height / self.tileHeight)
+    };
+    
+    // Every ImageTilemap but off is the RenderTilemapFormat before it.
+    setTilemapFormat(&map, (RenderTilemapFormat)(self.tilemap - 1));
+    NSInteger available = dataSourceLength(self.source) - self.offset;
+    map.height = (int)MIN((NSInteger)map.height, MAX(available, 0) / (map.width * map.bytesPerEntry));
+    return map;
 }
 
-- (UInt32)toColorFromRGB555:(UInt16) color {
-    // [A0 R4 R3 R2 R1 R0 G4 G3] | [G2 G1 G0 B4 B3 B2 B1 B0]
+// Decodes every tile the map is able to index, again only after the layout of the tiles, the data or, for tiles of pixels, the palette has changed.
+- (BOOL)prepareTileset {
+    RenderGeometry geometry = [self tileGeometry];
+    const RenderPalette *palette = [self renderPalette];
     
-    UInt32 a = color & 0b1000000000000000;
-    UInt32 r = color & 0b0111110000000000;
-    UInt32 g = color & 0b0000001111100000;
-    UInt32 b = color & 0b0000000000011111;
+    if (self.tileset != NULL && isTilesetForGeometry(self.tileset, &geometry)) {
+        if (isIndexedGeometry(&geometry) || self.tilesetChangeCount == self.palette.changeCount) return YES;
+    }
+    [self dropTileset];
     
-    UInt32 rgb = (r >> 10) | (g << 6) | (b << 19);
-    // [A7...0 B7...0 G7...0 R7...0]
-    return 0xFF000000 | rgb | ((rgb >> 5) & 0x070707);
-}
-
-- (UInt32)toColorFromRGB565:(UInt16) color {
-    // [R4 R3 R2 R1 R0 G5 G4 G3] | [G2 G1 G0 B4 B3 B2 B1 B0]
+    RenderTilemap map = [self renderTilemap];
+    long tileBytes = bytesPerTile(&geometry);
+    long count = tileBytes > 0 ? MIN((long)map.indexMask + 1, (dataSourceLength(self.source) - self.tilesetOffset) / tileBytes) : 0;
+    if (count < 1) return NO;
     
-    UInt32 r = color & 0b1111100000000000;
-    UInt32 g = color & 0b0000011111100000;
-    UInt32 b = color & 0b0000000000011111;
+    const UInt8 *bytes = dataSourceBytes(self.source, self.tilesetOffset, count * tileBytes);
+    if (bytes == NULL) return NO;
     
-    UInt32 rgb = (r >> 8) | (g << 5) | (b << 19);
-    // [A7...0 B7...0 G7...0 R7...0]
-    return 0xFF000000 | rgb | ((rgb >> 5) & 0x070707);
+    self.tileset = createTileset(&geometry, palette, bytes, count);
+    self.tilesetChangeCount = self.palette.changeCount;
+    return self.tileset != NULL;
 }
 
-- (UInt32)toColorFromRGBA555:(UInt16) color {
-    // [A0 R4 R3 R2 R1 R0 G4 G3] | [G2 G1 G0 B4 B3 B2 B1 B0]
+- (void)drawTilemapInRect:(CGRect)rect ofPixelData:(void *)pixelData {
+    UInt32 *pixel = [self originOfPixelData:pixelData];
+    long stride = (long)self.mutableTexture.size.width;
     
-    UInt32 a = color & 0b0000000000000001;
-    UInt32 r = color & 0b1111100000000000;
-    UInt32 g = color & 0b0000011111000000;
-    UInt32 b = color & 0b0000000000111110;
+    RenderTilemap map = [self renderTilemap];
+    if ([self prepareTileset] == YES && map.height > 0) {
+        const UInt8 *entries = dataSourceBytes(self.source, self.offset, bytesPerTilemap(&map));
+        if (entries != NULL) {
+            renderTilemapRegion(self.tileset, &map, [self renderPalette], entries,
+                                (int)rect.origin.x, (int)rect.origin.y, (int)rect.size.width, (int)rect.size.height, pixel, stride);
+            return;
+        }
+    }
     
-    UInt32 rgb = (r >> 8) | (g << 5) | (b << 18);
-    // [A7...0 B7...0 G7...0 R7...0]
-    return (a * 0xFF000000) | rgb | ((rgb >> 5) & 0x070707);
+    for (NSInteger row = 0; row < (NSInteger)rect.size.height; row++) {
+        memset(pixel + row * stride, 0, (size_t)rect.size.width * sizeof(UInt32));
+    }
 }
 
-- (UInt32)toColorFromARGB555:(UInt16) color {
-    // [A0 R4 R3 R2 R1 R0 G4 G3] | [G2 G1 G0 B4 B3 B2 B1 B0]
+// The whole level is saved, not just the part of it in view.
+- (void)saveTilemapAtURL:(NSURL *)url {
+    RenderTilemap map = [self renderTilemap];
+    if (map.height < 1 || [self prepareTileset] == NO) return;
     
-    UInt32 a = color & 0b1000000000000000;
-    UInt32 r = color & 0b0111110000000000;
-    UInt32 g = color & 0b0000001111100000;
-    UInt32 b = color & 0b0000000000011111;
+    const UInt8 *entries = dataSourceBytes(self.source, self.offset, bytesPerTilemap(&map));
+    if (entries == NULL) return;
     
-    UInt32 rgb = (r >> 10) | (g << 6) | (b << 19);
-    // [A7...0 B7...0 G7...0 R7...0]
-    return (a * 0x1FE00) | rgb | ((rgb >> 5) & 0x070707);
-}
-
-- (void)render16KImageDataToScratchData {
-    UInt8 *sourceData = (UInt8 *)self.mutableData.bytes + self.offset;
-    UInt32 *destinationScratchData = (UInt32 *)self.scratchData.bytes;
-    NSUInteger length = (NSUInteger)self.size.width * (NSUInteger)self.size.height;
-    NSUInteger blockSize = self.tileWidth * self.tileHeight;
+    int width = map.width * (int)self.tileWidth;
+    int height = map.height * (int)self.tileHeight;
+    NSMutableData *pixelData = [[NSMutableData alloc] initWithLength:(NSUInteger)width * (NSUInteger)height * sizeof(UInt32)];
+    renderTilemapRegion(self.tileset, &map, [self renderPalette], entries, 0, 0, width, height, pixelData.mutableBytes, width);
     
-    while (length) {
-        for (NSUInteger i = 0; i < blockSize; i++) {
-            UInt16 channels;
-            
-            channels = (self.bigEndian) ? CFSwapInt16BigToHost(*((UInt16 *)sourceData)) : CFSwapInt16LittleToHost(*((UInt16 *)sourceData));
-            if (self.pixelFormat == ImagePixelFormatRGB555) *destinationScratchData = [self toColorFromRGB555:channels];
-            if (self.pixelFormat == ImagePixelFormatRGB565) *destinationScratchData = [self toColorFromRGB565:channels];
-            if (self.pixelFormat == ImagePixelFormatRGBA555) *destinationScratchData = [self toColorFromRGBA555:channels];
-            if (self.pixelFormat == ImagePixelFormatARGB555) *destinationScratchData = [self toColorFromARGB555:channels];
-            
-            if (self.alphaPlane == YES) {
-                *destinationScratchData |= 0xFF000000;
-            }
-            
-            destinationScratchData += 1;
-            sourceData += 2;
-        }
-        sourceData += self.padding;
-        length -= blockSize;
-    }
+    CGImageRef imageRef = [Extenions createCGImageFromPixelData:pixelData.bytes ofSize:CGSizeMake(width, height)];
+    [Extenions writeCGImage:imageRef to:url];
 }
 
-
-
-
-- (void)packed24Bit {
-    UInt8 *src = (UInt8 *)self.mutableData.bytes + self.offset;
-    UInt32 *dst = (UInt32 *)self.scratchData.bytes;
-    NSUInteger length = (NSUInteger)self.size.width * (NSUInteger)self.size.height;
-    NSUInteger blockSize = self.tileWidth * self.tileHeight;
-  
-    while (length) {
-        for (NSUInteger i = 0; i < blockSize; i++) {
-            TriColor *triColor = (TriColor *)src;
-            *dst++ = (UInt32)triColor->redChannel | (UInt32)triColor->greenChannel << 8 | (UInt32)triColor->blueChannel << 16 | 0xFF000000;
-            src += 3;
-        }
-        src += self.padding;
-        length -= blockSize;
+// Geometry for the C pixel kernels, clipped so that no kernel reads past the end of the data.
+- (RenderGeometry)geometry {
+    RenderGeometry geometry = {
+        .width = (int)self.size.width,
+        .height = (int)self.size.height,
+        .bitsPerPixel = (int)self.bitsPerPixel,
+        .planeCount = (int)self.planeCount,
+        .alphaPlane = self.alphaPlane,
+        .maskPlane = self.maskPlane,
+        .bigEndian = self.bigEndian,
+        .pixelFormat = (RenderPixelFormat)self.pixelFormat,
+        .tileWidth = (int)self.tileWidth,
+        .tileHeight = (int)self.tileHeight,
+        .padding = (int)self.padding,
+        .layout = (RenderLayout)self.layout,
+        .flashInverted = self.flashInverted
+    };
+    
+    NSInteger available = dataSourceLength(self.source) - self.offset;
+    int step = geometry.tileWidth > 1 && geometry.tileHeight > 1 ? geometry.tileHeight : 1;
+    int pictureWidth, pictureHeight;
+    long pictureBytes;
+    if (pictureSize(&geometry, &pictureWidth, &pictureHeight, &pictureBytes)) step = pictureHeight;
+    
+    if (geometry.planeCount <= 1 || geometry.maskPlane == NO) {
+        // Worked out in whole rows, as images can be far taller than the view.
+        RenderGeometry strip = geometry;
+        strip.height = step;
+        long bytesPerStrip = bytesPerImage(&strip);
+        long excess = bytesPerStrip > 0 ? geometry.height / step - MAX(available, 0) / bytesPerStrip : 0;
+        if (excess > 0) geometry.height -= excess * step;
     }
-}
-
-
-- (void)packed32Bit {
-    UInt8 *src = (UInt8 *)self.mutableData.bytes + self.offset;
-    UInt32 *dst = (UInt32 *)self.scratchData.bytes;
-    NSUInteger length = (NSUInteger)self.size.width * (NSUInteger)self.size.height;
-    NSUInteger blockSize = self.tileWidth * self.tileHeight;
-    
-    while (length) {
-        for (NSUInteger i = 0; i < blockSize; i++) {
-            *dst++ = *(UInt32 *)src;
-            src += 4;
-        }
-        src += self.padding;
-        length -= blockSize;
+    while (geometry.height > 0 && bytesPerImage(&geometry) > available) {
+        geometry.height -= step;
     }
+    
+    return geometry;
 }
 
-     /*
-- (void)planer8Bit {
-    UInt8 *src = (UInt8 *)self.mutableData.bytes + self.offset;
-    UInt32 *dst = (UInt32 *)self.scratchData.bytes;
-    NSUInteger length = (NSUInteger)self.size.width * (NSUInteger)self.size.height;
-    NSUInteger blockSize = self.tileWidth / 4 * self.tileHeight;
-    
-    
-    while (length) {
-        for (NSUInteger i = 0; i < blockSize; i++) {
-            if (self.alphaPlane == YES) {
-                UInt8 plane = *src++;
-                UInt8 mask = 1 << 7;
-                for (int n = 0; n < 8; n++) {
-                    if (plane & mask) {
-                        dst[n] = 0;
-                    } else {
-                        dst[n] = 0xFF000000;
-                    }
-                    
-                    mask >>= 1;
-                }
-            }
-            
-            UInt8 mask = 1 << 7;
-            for (int n = 0; n < 8; n++) {
-                UInt32 i = 0;
-                for (UInt32 p = 0; p < self.planeCount; p++) {
-                    if (src[p] & mask) {
-                        i |= (1 << p);
-                    }
-                }
-                dst[n] = self.planeCount > 1 ? [self.palette rgbColorAtIndex:i] : (0xFFFFFF * i) | 0xFF000000;
-                mask >>= 1;
-            }
-            dst += 8;
-            src += self.planeCount;
+// Palette for the C pixel kernels, only copied again after the palette has changed.
+- (const RenderPalette *)renderPalette {
+    RenderPalette *palette = (RenderPalette *)self.paletteData.mutableBytes;
+    
+    if (self.paletteChangeCount != self.palette.changeCount) {
+        for (NSUInteger i = 0; i < 256; i++) {
+            palette->rgb[i] = [self.palette rgbColorAtIndex:i];
         }
-        src += self.padding;
-        length -= blockSize;
+        palette->colorCount = (int)self.palette.colorCount;
+        palette->transparentIndex = (int)self.palette.transparentIndex;
+        self.paletteChangeCount = self.palette.changeCount;
+        traceAdd(TraceCounterPaletteRedraws, 1);
     }
-}
-*/
-- (void)planer8BitToPixelData:(void *)pixelData {
-        UInt32 *pixel = pixelData;
-        const unsigned char *bytes = self.mutableData.bytes + self.offset;
-        
-        NSUInteger s = self.mutableTexture.size.width;
-        NSUInteger l = self.mutableTexture.size.height;
-        
-        NSUInteger w = self.size.width;
-        NSUInteger h = self.size.height;
-        
-        NSUInteger step_c = self.bitsPerPixel;
-        
-        if (self.tileWidth > 1) {
-            step_c =  self.bitsPerPixel * (self.tileWidth / self.bitsPerPixel);
-        }
-        
-        for (NSUInteger r = (l - h) / 2; r < l - (l - h) / 2; r+=self.tileHeight) {
-            for (NSUInteger c = (s - w) / 2; c < s - (s - w) / 2; c+=step_c) {
-                
-                for (NSUInteger y = 0; y < self.tileHeight; y++) {
-                    for (NSUInteger x = 0; x < self.tileWidth; x+=self.bitsPerPixel) {
-                
-                        UInt8 *planeData = (UInt8 *)bytes;
-                        
-                        if (self.alphaPlane == YES) {
-                            for (int n = self.bitsPerPixel - 1; n >= 0; n--) {
-                                UInt8 plane = *planeData;
-                                
-                                if (plane & (1 << n)) {
-                                    pixel[(r + y) * s + c + x + self.bitsPerPixel - 1 - n] = 0;
-                                } else {
-                                    pixel[(r + y) * s + c + x + self.bitsPerPixel - 1 - n] = 0xFF000000;
-                                }
-                            }
-                            bytes += self.bitsPerPixel / 8;
-                        }
-                        
-                        for (int n = self.bitsPerPixel - 1; n >= 0; n--) {
-                            int colorIndex = 0;
-                            
-                            for (int p=0; p<(int)self.planeCount; p++) {
-                                UInt8 plane = planeData[p];
-   
-                                if (plane & (1 << n)) {
-                                    colorIndex |= (1 << p);
-                                }
-                            }
-                            UInt32 color = [self.palette rgbColorAtIndex:colorIndex];
-                            if (self.alphaPlane == YES && colorIndex == 0) {
-                                color &= 0x00FFFFFF;
-                            }
-                            pixel[(r + y) * s + c + x + self.bitsPerPixel - 1 - n] = self.planeCount > 1 ? color : (0xFFFFFF * colorIndex) | 0xFF000000;
-                        }
-                        
-                        bytes += self.bitsPerPixel / 8 * self.planeCount;
-                    }
-                }
-                bytes += self.padding;
-            }
-        }
-
+    
+    return palette;
 }
 
-- (void)planer16BitToPixelData:(void *)pixelData {
-    UInt32 *pixel = pixelData;
-    const unsigned char *bytes = self.mutableData.bytes + self.offset;
-    
-    NSUInteger s = self.mutableTexture.size.width;
-    NSUInteger l = self.mutableTexture.size.height;
-    
-    NSUInteger w = self.size.width;
-    NSUInteger h = self.size.height;
+// The part of the image in view, the whole image when it fits within the texture. Keeps the view within the image.
+- (CGRect)visibleRect {
+    CGFloat w = MIN(self.size.width, self.mutableTexture.size.width);
+    CGFloat h = MIN(self.size.height, self.mutableTexture.size.height);
     
-    NSUInteger step_c = self.bitsPerPixel;
+    CGFloat x = MAX(0, MIN(self.viewOrigin.x, self.size.width - w));
+    CGFloat y = MAX(0, MIN(self.viewOrigin.y, self.size.height - h));
+    _viewOrigin = CGPointMake(x, y);
     
-    if (self.tileWidth > 1) {
-        step_c =  self.bitsPerPixel * (self.tileWidth / self.bitsPerPixel);
-    }
-    
-    for (NSUInteger r = (l - h) / 2; r < l - (l - h) / 2; r+=self.tileHeight) {
-        for (NSUInteger c = (s - w) / 2; c < s - (s - w) / 2; c+=step_c) {
-            
-            for (NSUInteger y = 0; y < self.tileHeight; y++) {
-                for (NSUInteger x = 0; x < self.tileWidth; x+=self.bitsPerPixel) {
-            
-                    UInt16 *planeData = (UInt16 *)bytes;
-                    
-                    if (self.alphaPlane == YES) {
-                        for (int n = self.bitsPerPixel - 1; n >= 0; n--) {
-                            //UInt16 plane = *planeData;
-                            
-                            UInt16 plane = (self.bigEndian) ? CFSwapInt16BigToHost(*planeData) : CFSwapInt16LittleToHost(*planeData);
-                            
-//#ifdef __LITTLE_ENDIAN__
-//                            plane = CFSwapInt16BigToHost(plane);
-//#endif
-                            if (plane & (1 << n)) {
-                                pixel[(r + y) * s + c + x + self.bitsPerPixel - 1 - n] = 0;
-                            } else {
-                                pixel[(r + y) * s + c + x + self.bitsPerPixel - 1 - n] = 0xFF000000;
-                            }
-                        }
-                        bytes += self.bitsPerPixel / 8;
-                    }
-                    
-                    for (int n = self.bitsPerPixel - 1; n >= 0; n--) {
-                        int colorIndex = 0;
-                        
-                        for (int p=0; p<(int)self.planeCount; p++) {
-                            //UInt16 plane = planeData[p];
-                            UInt16 plane = (self.bigEndian) ? CFSwapInt16BigToHost(planeData[p]) : CFSwapInt16LittleToHost(planeData[p]);
-//#ifdef __LITTLE_ENDIAN__
-//                            plane = CFSwapInt16BigToHost(plane);
-//#endif
-                            if (plane & (1 << n)) {
-                                colorIndex |= (1 << p);
-                            }
-                        }
-                        UInt32 color = [self.palette rgbColorAtIndex:colorIndex];
-                        if (self.alphaPlane == YES && colorIndex == 0) {
-                            color &= 0x00FFFFFF;
-                        }
-                        pixel[(r + y) * s + c + x + self.bitsPerPixel - 1 - n] = self.planeCount > 1 ? color : (0xFFFFFF * colorIndex) | 0xFF000000;
-                    }
-                    
-                    bytes += self.bitsPerPixel / 8 * self.planeCount;
-                }
-            }
-            bytes += self.padding;
-        }
-    }
-
+    return CGRectMake(floor(x), floor(y), w, h);
 }
 
-- (void)mask16BitToPixelData:(void *)pixelData {
-    UInt32 *pixel = pixelData;
-    const unsigned char *bytes = self.mutableData.bytes + self.offset;
-    
+// Top left pixel of the part of the image in view, centred within the texture.
+- (UInt32 *)originOfPixelData:(void *)pixelData {
     NSUInteger s = self.mutableTexture.size.width;
     NSUInteger l = self.mutableTexture.size.height;
     
-    NSUInteger w = self.size.width;
-    NSUInteger h = self.size.height / 2;
-    
-    for (NSUInteger r = (l - h) / 2; r < l - (l - h) / 2; ++r) {
-        for (NSUInteger c = (s - w) / 2; c < s - (s - w) / 2; ++c) {
-            UInt16 *planeData = (UInt16 *)bytes;
-            
-            for (int n=(int)self.bitsPerPixel - 1; n >= 0; n--) {
-                int colorIndex = 0;
-                
-                for (int p=0; p<(int)self.planeCount; p++) {
-                    UInt16 plane = (self.bigEndian) ? CFSwapInt16BigToHost(planeData[p]) : CFSwapInt16LittleToHost(planeData[p]);
-//                    UInt16 plane = planeData[p];
-//#ifdef __LITTLE_ENDIAN__
-//                    plane = CFSwapInt16BigToHost(plane);
-//#endif
-                    if (plane & (1 << n)) {
-                        colorIndex |= (1 << p);
-                    }
-                }
-                UInt32 color = [self.palette rgbColorAtIndex:colorIndex];
-                if (self.alphaPlane == YES && colorIndex == 0) {
-                    color &= 0x00FFFFFF;
-                }
-                pixel[(r - h / 2) * s + c + self.bitsPerPixel - 1 - n] = self.planeCount > 1 ? color : (0xFFFFFF * colorIndex) | 0xFF000000;
-            }
-            
-            c += self.bitsPerPixel - 1;
-            bytes += self.bitsPerPixel / 8 * self.planeCount;
-        }
-    }
+    NSUInteger w = MIN(self.size.width, s);
+    NSUInteger h = MIN(self.size.height, l);
     
-    for (NSUInteger r = (l - h) / 2; r < l - (l - h) / 2; ++r) {
-        for (NSUInteger c = (s - w) / 2; c < s - (s - w) / 2; ++c) {
-            
-            for (int n=(int)self.bitsPerPixel - 1; n >= 0; n--) {
-                int colorIndex = 0;
-                UInt16 *planeData = (UInt16 *)bytes;
-                UInt16 plane = (self.bigEndian) ? CFSwapInt16BigToHost(*planeData) : CFSwapInt16LittleToHost(*planeData);
-//                UInt16 plane = *planeData;
-//#ifdef __LITTLE_ENDIAN__
-//                plane = CFSwapInt16BigToHost(plane);
-//#endif
-                if (plane & (1 << n)) {
-                    colorIndex |= 15;
-                }
-                
-                UInt32 color = [self.palette rgbColorAtIndex:colorIndex];
-                pixel[(r + h / 2) * s + c + self.bitsPerPixel - 1 - n] = self.planeCount > 1 ? color : (0xFFFFFF * colorIndex) | 0xFF000000;
-            }
-            
-            c += self.bitsPerPixel - 1;
-            bytes += 2;
-        }
-    }
+    return (UInt32 *)pixelData + (l - h) / 2 * s + (s - w) / 2;
 }
 
-- (NSInteger)deltaWidth {
-    if (self.tileWidth > 1) {
-        return self.tileWidth;
-    }
+// Clears the texture around the part of the image in view, see originOfPixelData.
+- (void)clearBorderOfPixelData:(void *)pixelData {
+    NSUInteger s = self.mutableTexture.size.width;
+    NSUInteger l = self.mutableTexture.size.height;
     
-    if (self.planeCount > 1) {
-        return self.bitsPerPixel;
-    }
+    NSUInteger w = MIN(self.size.width, s);
+    NSUInteger h = MIN(self.size.height, l);
+    NSUInteger top = (l - h) / 2;
+    NSUInteger left = (s - w) / 2;
     
-    if (self.bitsPerPixel <= 8) {
-        return 8 / self.bitsPerPixel;
+    UInt32 *pixel = (UInt32 *)pixelData;
+    memset(pixel, 0, top * s * sizeof(UInt32));
+    for (NSUInteger row = top; row < top + h; row++) {
+        memset(pixel + row * s, 0, left * sizeof(UInt32));
+        memset(pixel + row * s + left + w, 0, (s - left - w) * sizeof(UInt32));
     }
-    
-    return 1;
+    memset(pixel + (top + h) * s, 0, (l - top - h) * s * sizeof(UInt32));
 }
 
-// MARK: - Private Methods
-
 - (BOOL)isValidSize:(CGSize)size {
-    if (self.bytesPerLine * (NSInteger)size.height > self.mutableData.length) {
+    if (self.bytesPerLine * (NSInteger)size.height > dataSourceLength(self.source)) {
         return NO;
     }
     return YES;
@@ -970,6 +709,7 @@ typedef struct {
 }
 
 - (void)setBitsPerPixel:(UInt32)bitsPerPixel {
+    _layout = ImageLayoutLinear;
     _bitsPerPixel = bitsPerPixel > 0 ? bitsPerPixel : 1;
     if (self.planeCount > 1) {
         _bitsPerPixel = _bitsPerPixel > 7 ? _bitsPerPixel & 0xF8 : 8;
@@ -984,6 +724,7 @@ typedef struct {
 
 - (void)setPlaneCount:(UInt32)planeCount {
     if (planeCount >= 1 || planeCount <= 5) {
+        _layout = ImageLayoutLinear;
         _planeCount = planeCount;
         
         if (planeCount == 1) self.alphaPlane = NO;
@@ -1013,12 +754,40 @@ typedef struct {
     self.changes = YES;
 }
 
+// Choosing the planes or bits per pixel goes back to the linear layout, pictures are not drawn from a tilemap.
+- (void)setLayout:(ImageLayout)layout {
+    _layout = layout;
+    
+    RenderGeometry geometry = { .layout = (RenderLayout)layout };
+    int pictureWidth, pictureHeight;
+    long pictureBytes;
+    if (pictureSize(&geometry, &pictureWidth, &pictureHeight, &pictureBytes)) _tilemap = ImageTilemapOff;
+    
+    int bits = tileFormatBits((RenderLayout)layout);
+    if (bits > 0) {
+        // Console tiles are one plane of 8 by 8 pixels, the menus show their depth.
+        _planeCount = 1;
+        _bitsPerPixel = (UInt32)bits;
+        _alphaPlane = NO;
+        _maskPlane = NO;
+        _tileWidth = TILE_FORMAT_SIZE;
+        _tileHeight = TILE_FORMAT_SIZE;
+    }
+    self.flashTime = 0.0;
+    self.flashInverted = NO;
+    [self setSize:self.size];
+    self.changes = YES;
+}
+
 - (void)setTileWithWidthOf:(NSUInteger)width andHightOf:(NSUInteger)height  {
+    // Console tiles are always 8 by 8.
+    if (tileFormatBits((RenderLayout)self.layout) > 0) return;
     
     self.changes = YES;
     if (width == 0 || height == 0) {
         _tileWidth = 1;
         _tileHeight = 1;
+        _tilemap = ImageTilemapOff;
         return;
     }
     
@@ -1027,29 +796,84 @@ typedef struct {
     
     if (self.tileWidth == 1 && self.tileHeight > 1) _tileWidth = _tileHeight;
     if (self.tileWidth > 1 && self.tileHeight == 1) _tileHeight = self.tileWidth;
+    if (self.tileWidth == 1) _tilemap = ImageTilemapOff;
     
     [self setSize:CGSizeMake((NSUInteger)self.size.width / width * width, (NSUInteger)self.size.height / height * height)];
 }
 
+// The tileset is the tiles at the offset, 8 by 8 pixels unless already tiled, turning the map off goes back to it.
+- (void)setTilemap:(ImageTilemap)tilemap {
+    if (tilemap != ImageTilemapOff && self.layout != ImageLayoutLinear && tileFormatBits((RenderLayout)self.layout) == 0) return;
+    
+    ImageTilemap previous = _tilemap;
+    if (previous == ImageTilemapOff && tilemap != ImageTilemapOff) {
+        _tilesetOffset = self.offset;
+        if (self.tileWidth < 2 || self.tileHeight < 2) {
+            _tileWidth = 8;
+            _tileHeight = 8;
+        }
+    }
+    
+    _tilemap = tilemap;
+    [self setSize:self.size];
+    if (previous != ImageTilemapOff && tilemap == ImageTilemapOff) [self setOffset:self.tilesetOffset];
+    self.changes = YES;
+}
+
 - (void)setSize:(CGSize)size {
-    if (size.width > 800 || size.height > 600) return;
+    if (self.tilemap != ImageTilemapOff) {
+        // Whole tiles only, and no more rows of them than the data holds.
+        NSInteger columns = MAX((NSInteger)size.width / (NSInteger)self.tileWidth, 1);
+        NSInteger rows = MAX((NSInteger)size.height / (NSInteger)self.tileHeight, 1);
+        RenderTilemap map = { .width = (int)columns };
+        setTilemapFormat(&map, (RenderTilemapFormat)(self.tilemap - 1));
+        rows = MAX(MIN(rows, dataSourceLength(self.source) / (columns * map.bytesPerEntry)), 1);
+        
+        _size = CGSizeMake(columns * self.tileWidth, rows * self.tileHeight);
+        self.changes = YES;
+        return;
+    }
+    
+    if (tileFormatBits((RenderLayout)self.layout) > 0) {
+        // Whole tiles only, and no more rows of them than the data holds.
+        NSInteger columns = MAX((NSInteger)size.width / TILE_FORMAT_SIZE, 1);
+        NSInteger rows = MAX((NSInteger)size.height / TILE_FORMAT_SIZE, 1);
+        RenderGeometry strip = { .width = (int)columns * TILE_FORMAT_SIZE, .height = TILE_FORMAT_SIZE,
+            .padding = (int)self.padding, .layout = (RenderLayout)self.layout };
+        rows = MAX(MIN(rows, dataSourceLength(self.source) / bytesPerImage(&strip)), 1);
+        
+        _size = CGSizeMake(columns * TILE_FORMAT_SIZE, rows * TILE_FORMAT_SIZE);
+        self.changes = YES;
+        return;
+    }
+    
+    RenderGeometry layout = { .layout = (RenderLayout)self.layout };
+    int pictureWidth, pictureHeight;
+    long pictureBytes;
+    if (pictureSize(&layout, &pictureWidth, &pictureHeight, &pictureBytes)) {
+        // Whole pictures only, a step of any size adds or removes one.
+        NSInteger pictures = (NSInteger)size.height / pictureHeight;
+        if (pictures == (NSInteger)self.size.height / pictureHeight && size.height > self.size.height) pictures++;
+        pictures = MIN(pictures, dataSourceLength(self.source) / (pictureBytes + (NSInteger)self.padding));
+        
+        _size = CGSizeMake(pictureWidth, MAX(pictures, 1) * pictureHeight);
+        self.changes = YES;
+        return;
+    }
     
     if ([self isValidSize:size] == NO) {
         
         for (CGFloat width = size.width; width > 1; width --) {
             _size.width = width;
-            for (CGFloat height = size.height; height > 1; height --) {
-                _size.height = height;
-                if (self.bytesPerLine * (NSInteger)height <= self.mutableData.length) return;
+            // The tallest image of this width the data still holds.
+            NSInteger height = self.bytesPerLine > 0 ? dataSourceLength(self.source) / self.bytesPerLine : 0;
+            if (height > 1) {
+                _size.height = MIN(size.height, (CGFloat)height);
+                return;
             }
         }
     }
     
-    [self.mutableTexture modifyPixelDataWithBlock:^(void *pixelData, size_t lengthInBytes) {
-        memset(pixelData, 0, lengthInBytes);
-    }];
-    
-    
     _size = size;
     
     if (self.bitsPerPixel == 0) return;
@@ -1057,9 +881,6 @@ typedef struct {
     if (self.size.height < 8.0) {
         _size.height = 8.0;
     }
-    if (self.size.height > self.mutableTexture.size.height) {
-        _size.height = self.mutableTexture.size.height;
-    }
     
     if (self.planeCount == 1) {
         if (self.bitsPerPixel <= 8) {
@@ -1089,7 +910,11 @@ typedef struct {
 }
 
 - (void)setDataLength:(NSUInteger)length {
-    self.mutableData.length = length;
+    setDataSourceLength(self.source, (long)length);
+    invalidateCanvas(self.canvas);
+    [self dropPaletteIndex];
+    [self dropTileset];
+    self.changes = YES;
 }
 
 - (void)setAspectRatio:(CGFloat)aspectRatio {
@@ -1112,19 +937,45 @@ typedef struct {
         return;
     }
     
-    if (_offset > self.mutableData.length - (NSInteger)self.size.height * [self bytesPerLine]) {
-        _offset = (NSInteger)(self.mutableData.length - (NSInteger)self.size.height * [self bytesPerLine]);
+    if (_offset > dataSourceLength(self.source) - (NSInteger)self.selected) {
+        _offset = (NSInteger)(dataSourceLength(self.source) - (NSInteger)self.selected);
     }
 }
 
+- (void)setCacheSize:(NSUInteger)cacheSize {
+    _cacheSize = cacheSize;
+    setCanvasBudget(self.canvas, cacheSize);
+}
+
 // MARK: - Public Getters
 
+-(NSUInteger)cacheHits {
+    RenderCanvasStatistics statistics;
+    canvasStatistics(self.canvas, &statistics);
+    return statistics.hits;
+}
+
+-(NSUInteger)cacheMisses {
+    RenderCanvasStatistics statistics;
+    canvasStatistics(self.canvas, &statistics);
+    return statistics.misses;
+}
+
 -(NSUInteger)selected {
+    if (self.tilemap != ImageTilemapOff) {
+        return (NSUInteger)[self bytesPerLine] * ((NSUInteger)self.size.height / self.tileHeight);
+    }
+    if (self.layout != ImageLayoutLinear) {
+        // Pictures and console tiles are not a whole number of bytes a line, and padding follows every one of them.
+        RenderGeometry geometry = { .width = (int)self.size.width, .height = (int)self.size.height,
+            .padding = (int)self.padding, .layout = (RenderLayout)self.layout };
+        return (NSUInteger)bytesPerImage(&geometry);
+    }
     return (NSUInteger)[self bytesPerLine] * (NSUInteger)self.size.height;
 }
 
 -(NSUInteger)bytes {
-    return self.mutableData.length;
+    return dataSourceLength(self.source);
 }
 
 -(NSInteger)bytesPerLine {
@@ -1133,6 +984,20 @@ typedef struct {
     
     if (self.bitsPerPixel < 1) _bitsPerPixel = 8;
     
+    // A row of tiles of the map.
+    if (self.tilemap != ImageTilemapOff) {
+        RenderTilemap map = { .width = (int)(width / (NSInteger)self.tileWidth) };
+        setTilemapFormat(&map, (RenderTilemapFormat)(self.tilemap - 1));
+        return map.width * map.bytesPerEntry;
+    }
+    
+    RenderGeometry layout = { .layout = (RenderLayout)self.layout };
+    int pictureWidth, pictureHeight;
+    long pictureBytes;
+    if (pictureSize(&layout, &pictureWidth, &pictureHeight, &pictureBytes)) {
+        return pictureBytes / pictureHeight;
+    }
+    
     if ([self isPlaner]) {
         // bitsPerPixel is regarded as bitsPerPlane in Planer Mode.
         n = self.bitsPerPixel / 8 * self.planeCount;
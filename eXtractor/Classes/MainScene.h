@@ -29,6 +29,13 @@ THE SOFTWARE.
 // MARK: - Class Instance Methods
 
 -(void)checkForKnownFormats;
+-(void)nextTapeBlock;
+-(void)previousTapeBlock;
+-(void)showSnapshotView:(NSInteger)view;    // A ZXSnapshotView of the memory of the snapshot that is open
+-(NSInteger)snapshotView;                   // -1 when no snapshot is open
+-(void)toggleFrameTimings;      // Shows the time each phase of a frame takes and starts a new trace
+-(BOOL)showsFrameTimings;
+-(void)saveTraceAtURL:(NSURL *)url;     // Chrome trace event JSON of the frames since the timings were shown
 
 // MARK:- Class Getter & Setters
 
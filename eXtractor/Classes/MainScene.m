@@ -30,6 +30,10 @@ THE SOFTWARE.
 //@property SKLabelNode *info;
 @property NSTimeInterval lastUpdateTime;
 @property Image *image;
+@property ZXTapeIndex *tapeIndex;      // Blocks of the tape that is open, laid out one after the other
+@property ZXSnapshot *snapshot;       // Memory of the snapshot that is open, shown in place of the file
+@property ZXSnapshotView snapshotMemory;
+@property SKLabelNode *timings;       // Frame timings overlay, only while tracing
 
 
 @end
@@ -51,6 +55,11 @@ THE SOFTWARE.
     
 }
 
+- (void)dealloc {
+    closeZXTapeIndex(_tapeIndex);
+    closeZXSnapshot(_snapshot);
+}
+
 // MARK: - Setup
 
 - (void)setup {
@@ -101,6 +110,15 @@ THE SOFTWARE.
 
 
 
+// MARK: - Mouse Events
+
+- (void)scrollWheel:(NSEvent *)theEvent {
+    CGFloat scale = MAX(self.image.zoom, 1);
+    [self.image panBy:CGPointMake(-theEvent.scrollingDeltaX / scale, -theEvent.scrollingDeltaY / scale)];
+}
+
+
+
 // MARK: - Update
 
 -(void)update:(CFTimeInterval)currentTime {
@@ -108,15 +126,129 @@ THE SOFTWARE.
     self.lastUpdateTime = currentTime;
     
     [self.image updateWithDelta:delta];
+    
+    if (self.timings) {
+        self.timings.text = self.image.frameTimings;
+    }
 }
 
 
 // MARK: - Class Public Methods
 
+-(void)toggleFrameTimings {
+    if (self.timings) {
+        setTracing(false);
+        [self.timings removeFromParent];
+        self.timings = nil;
+        return;
+    }
+    
+    setTracing(true);
+    self.timings = [SKLabelNode labelNodeWithFontNamed:@"Menlo"];
+    self.timings.fontSize = 11;
+    self.timings.fontColor = NSColor.whiteColor;
+    self.timings.horizontalAlignmentMode = SKLabelHorizontalAlignmentModeLeft;
+    self.timings.verticalAlignmentMode = SKLabelVerticalAlignmentModeTop;
+    self.timings.position = CGPointMake(8, self.size.height - 8);
+    self.timings.zPosition = 1;
+    [self addChild:self.timings];
+}
+
+-(BOOL)showsFrameTimings {
+    return self.timings != nil;
+}
+
+-(void)saveTraceAtURL:(NSURL *)url {
+    writeTrace(url.fileSystemRepresentation);
+}
+
+-(void)nextTapeBlock {
+    if (self.tapeIndex == NULL) return;
+    
+    long block = zxTapeBlockAtViewOffset(self.tapeIndex, self.image.offset);
+    if (block + 1 < self.tapeIndex->count) {
+        [self.image setOffset:self.tapeIndex->blocks[block + 1].viewOffset];
+    }
+}
+
+-(void)previousTapeBlock {
+    if (self.tapeIndex == NULL) return;
+    
+    // Back to the start of the block first, then to the block before it.
+    long block = zxTapeBlockAtViewOffset(self.tapeIndex, self.image.offset);
+    if (block < 0) return;
+    if (self.tapeIndex->blocks[block].viewOffset == self.image.offset && block > 0) block--;
+    [self.image setOffset:self.tapeIndex->blocks[block].viewOffset];
+}
+
+-(void)showSnapshotView:(NSInteger)view {
+    if (self.snapshot == NULL) return;
+    
+    ZXSnapshot *snapshot = self.snapshot;
+    long length = zxSnapshotViewLength((ZXSnapshotView)view);
+    [self.image setDataLength:length];
+    [self.image modifyBytesAtOffset:0 length:length withBlock:^(void *bytes) {
+        copyZXSnapshotView(snapshot, (ZXSnapshotView)view, bytes);
+    }];
+    self.snapshotMemory = (ZXSnapshotView)view;
+    
+    // Straight to the screen on show, the 48K starts with it, a 128K machine may be showing bank 7.
+    if (view == ZXSnapshotViewBanks) {
+        [self.image setOffset:(snapshot->shadowScreen ? 7 : 5) * ZX_BANK_BYTES];
+    } else {
+        [self.image setOffset:0];
+    }
+}
+
+-(NSInteger)snapshotView {
+    return self.snapshot == NULL ? -1 : self.snapshotMemory;
+}
+
+/*
+ Walks the chain of a .TAP file a block at a time, most files that are not a tape are given
+ up on after a block or two rather than read whole.
+ */
+-(BOOL)isTapFileOfLength:(NSUInteger)length {
+    long offset = 0;
+    
+    while (offset + 2 <= (long)length) {
+        const void *block = [self.image bytesAtOffset:offset length:MIN(3, (long)length - offset)];
+        if (block == NULL) return NO;
+        
+        offset = nextZXTapBlock(block, offset, length);
+        if (offset < 0) return NO;
+    }
+    return offset > 0 && offset == (long)length;
+}
+
 -(void)checkForKnownFormats {
     [self.image.palette reset];
+    closeZXTapeIndex(self.tapeIndex);
+    self.tapeIndex = NULL;
+    closeZXSnapshot(self.snapshot);
+    self.snapshot = NULL;
     
-    if (isZXTapeFormat(self.image.data.bytes, self.image.data.length) == true) {
+    // Headers are all that is needed to recognise most formats, only the length is checked beyond them.
+    NSUInteger length = self.image.bytes;
+    const void *bytes = [self.image bytesAtOffset:0 length:MIN(length, 1024)];
+    if (bytes == NULL) return;
+    
+    // A .TAP file has no signature, only a chain of blocks running through the whole file.
+    BOOL tape = isZXTapeFormat(bytes, length);
+    if (tape == NO) tape = [self isTapFileOfLength:length];
+    bytes = [self.image bytesAtOffset:0 length:MIN(length, 1024)];
+    
+    if (tape == YES) {
+        // Only the data of the tape is shown, without its headers, checksums and timing blocks.
+        self.tapeIndex = createZXTapeIndex([self.image bytesAtOffset:0 length:length], length);
+        if (self.tapeIndex != NULL && self.tapeIndex->count > 0) {
+            ZXTapeIndex *index = self.tapeIndex;
+            [self.image modifyBytesAtOffset:0 length:length withBlock:^(void *bytes) {
+                compactZXTape(index, bytes);
+            }];
+            [self.image setDataLength:index->viewLength];
+        }
+        
         [self.image setSize:CGSizeMake(64, 64)];
         [self.image setPlaneCount:1];
         [self.image setBitsPerPixel:1];
@@ -128,16 +260,40 @@ THE SOFTWARE.
         return;
     }
     
-    if (isNEOchromeFormat(self.image.data.bytes, self.image.data.length) == true) {
-        NEOchrome *neo = (NEOchrome *)self.image.data.bytes;
+    // Neither snapshot format has a signature, a .SNA has the length of one and a .Z80 a chain of blocks.
+    BOOL snapshotFormat = isZXSnaFormat(bytes, length);
+    if (snapshotFormat == NO && length <= ZX_Z80_MAX_BYTES) snapshotFormat = isZXZ80Format([self.image bytesAtOffset:0 length:length], length);
+    if (snapshotFormat == YES) {
+        // The memory is unpacked over the file, which is left as it was on disk.
+        self.snapshot = createZXSnapshot([self.image bytesAtOffset:0 length:length], length);
+        if (self.snapshot != NULL) {
+            [self.image setLayout:ImageLayoutZXScreen];
+            [self.image setSize:CGSizeMake(ZX_SCREEN_WIDTH, ZX_SCREEN_HEIGHT)];
+            [self showSnapshotView:self.snapshot->is128K ? ZXSnapshotViewBanks : ZXSnapshotView48K];
+            
+            NSString *filePath = [NSBundle.mainBundle pathForResource:@"ZX Spectrum" ofType:@"act"];
+            if (filePath != nil) {
+                [self.image.palette loadWithContentsOfFile:filePath];
+            }
+            [self.image setScale:3.0];
+            return;
+        }
+        bytes = [self.image bytesAtOffset:0 length:MIN(length, 1024)];
+    }
+    
+    if (isNEOchromeFormat(bytes, length) == true) {
+        NEOchrome *neo = (NEOchrome *)bytes;
         
-        // Palette
-        for (NSInteger i=0; i<256; i++) {
-            UInt32 color = [Palette colorFrom12BitRgb:neo->palette[i]];
-            [self.image.palette setRgbColor:color atIndex:i];
+        // Palette, the 16 colors of the header as a single change.
+        UInt32 colors[16];
+        for (NSInteger i=0; i<16; i++) {
+            colors[i] = [Palette colorFrom12BitRgb:neo->palette[i]];
         }
+        [self.image.palette beginUpdates];
+        [self.image.palette setRgbColors:colors count:16];
         [self.image.palette setColorCount:16];
         [self.image.palette setTransparentIndex:256];
+        [self.image.palette endUpdates];
         
         if (CFSwapInt16BigToHost(neo->colorAniLimits) & 0x8000) { /// Palette Animation!
             [self.image.palette setColorAnimationWith:(CFSwapInt16BigToHost(neo->colorAniLimits) >> 4) & 0xF
@@ -155,19 +311,62 @@ THE SOFTWARE.
         return;
     }
     
-    if (isDegasFormat(self.image.data.bytes, self.image.data.length) == true) {
-        Degas *degas = (Degas *)self.image.data.bytes;
+    // Compressed files are unpacked before anything is changed, a file that fails is left to the other formats.
+    const void *file = length <= DEGAS_MAX_BYTES ? [self.image bytesAtOffset:0 length:length] : NULL;
+    BOOL degasFormat = file != NULL && isDegasFormat(file, length);
+    NSMutableData *degasImage = nil;
+    if (degasFormat == YES && isDegasCompressed(file)) {
+        degasImage = [NSMutableData dataWithLength:DEGAS_IMAGE_BYTES];
+        degasFormat = unpackDegas(file, length, degasImage.mutableBytes);
+    }
+    bytes = [self.image bytesAtOffset:0 length:MIN(length, 1024)];
+    
+    if (degasFormat == YES) {
+        Degas *degas = (Degas *)bytes;
         
-        // Palette
-        for (NSInteger i=0; i<256; i++) {
-            UInt32 color = [Palette colorFrom12BitRgb:degas->palette[i]];
-            [self.image.palette setRgbColor:color atIndex:i];
+        // Palette, the 16 colors of the header as a single change.
+        UInt32 colors[16];
+        for (NSInteger i=0; i<16; i++) {
+            colors[i] = [Palette colorFrom12BitRgb:degas->palette[i]];
         }
+        [self.image.palette beginUpdates];
+        [self.image.palette setRgbColors:colors count:16];
         [self.image.palette setColorCount:16];
         [self.image.palette setTransparentIndex:256];
+        [self.image.palette endUpdates];
+        
+        UInt16 resolution = CFSwapInt16BigToHost(degas->resolution);
+        long animationOffset = degasAnimationOffset(bytes, length);
+        
+        if (animationOffset >= 0) { /// DEGAS Elite, the first channel that is on is the one cycled.
+            const DegasAnimation *animation = [self.image bytesAtOffset:animationOffset length:sizeof(DegasAnimation)];
+            for (NSInteger i=0; animation != NULL && i<4; i++) {
+                SInt16 left = CFSwapInt16BigToHost(animation->leftLimit[i]);
+                SInt16 right = CFSwapInt16BigToHost(animation->rightLimit[i]);
+                SInt16 direction = CFSwapInt16BigToHost(animation->direction[i]);
+                SInt16 delay = 128 - CFSwapInt16BigToHost(animation->delay[i]);
+                
+                if (direction == 1 || left < 0 || right > 15 || left >= right) continue;
+                
+                // Delays are in 1/60ths of a second, the palette steps in 1/50ths.
+                NSTimeInterval speed = MAX(1.0, delay * 50.0 / 60.0);
+                [self.image.palette setColorAnimationWith:left
+                                               rightLimit:right
+                                                 withStep:1
+                                               cycleSpeed:direction == 0 ? speed : -speed];
+                break;
+            }
+        }
+        
+        if (degasImage != nil) { /// Compressed, unpacked in place of the packed data.
+            [self.image setDataLength:sizeof(Degas) + DEGAS_IMAGE_BYTES];
+            [self.image modifyBytesAtOffset:sizeof(Degas) length:DEGAS_IMAGE_BYTES withBlock:^(void *bytes) {
+                memcpy(bytes, degasImage.bytes, DEGAS_IMAGE_BYTES);
+            }];
+        }
         
         // Image
-        switch (CFSwapInt16BigToHost(degas->resolution) & 3) {
+        switch (resolution & 3) {
             case 0:
                 [self.image setPlaneCount:4];
                 [self.image setBitsPerPixel:16];
@@ -195,15 +394,11 @@ THE SOFTWARE.
         return;
     }
     
-    if (isZXSpectrumFormat(self.image.data.bytes, self.image.data.length) == true) {
-        // Image
-        [self.image setDataLength:49152];
-        convertZXSpectrumScreenToIndexedColor(self.image.data.bytes);
-        
-        [self.image setPlaneCount:1];
-        [self.image setBitsPerPixel:8];
+    if (isZXSpectrumFormat(bytes, length) == true) {
+        // Image, decoded where it is stored so the file is left as it was.
+        [self.image setLayout:ImageLayoutZXScreen];
+        [self.image setSize:CGSizeMake(ZX_SCREEN_WIDTH, ZX_SCREEN_HEIGHT)];
         [self.image setOffset:0];
-        [self.image setSize:CGSizeMake(256, 192)];
         
         NSString *filePath = [NSBundle.mainBundle pathForResource:@"ZX Spectrum" ofType:@"act"];
         if (filePath != nil) {
@@ -212,6 +407,22 @@ THE SOFTWARE.
         [self.image setScale:3.0];
         return;
     }
+    
+    if (isKoalaFormat(bytes, length) == true || isArtStudioFormat(bytes, length) == true) {
+        // Image, after the load address, decoded where it is stored with its colors from screen and color RAM.
+        BOOL multicolor = isKoalaFormat(bytes, length);
+        [self.image setLayout:multicolor ? ImageLayoutC64Multicolor : ImageLayoutC64Hires];
+        [self.image setSize:CGSizeMake(multicolor ? C64_MULTICOLOR_WIDTH : C64_BITMAP_WIDTH, C64_BITMAP_HEIGHT)];
+        [self.image setOffset:2];
+        
+        NSString *filePath = [NSBundle.mainBundle pathForResource:@"Commodore 64" ofType:@"act"];
+        if (filePath != nil) {
+            [self.image.palette loadWithContentsOfFile:filePath];
+        }
+        [self.image setAspectRatio:multicolor ? 2.0 : 1.0];
+        [self.image setScale:3.0];
+        return;
+    }
 }
 
 
@@ -31,6 +31,7 @@ THE SOFTWARE.
 @property (readonly) NSUInteger transparentIndex;
 @property (readonly) UInt8  * _Nonnull  bytes;
 @property BOOL game;
+@property (readonly) NSUInteger changeCount; // Bumped whenever a color, the color count or the transparent index changes
 
 // MARK: - Class Instance Methods
 
@@ -39,7 +40,14 @@ THE SOFTWARE.
 -(void)saveAsPhotoshopActAtPath:( NSString* _Nonnull )path;
 -(UInt32)colorAtIndex:(NSUInteger)index;
 -(UInt32)rgbColorAtIndex:(NSUInteger)index;
--(BOOL)updateWithDelta:(NSTimeInterval)delta;
+-(BOOL)updateWithDelta:(NSTimeInterval)delta; // Also redraws the swatch once when any color changed since the last frame
+
+/*
+ Colors, the color count and the transparent index set between beginUpdates and the
+ matching endUpdates count as one change, calls may be nested.
+ */
+-(void)beginUpdates;
+-(void)endUpdates;
 
 
 // MARK: - Class Methods
@@ -57,6 +65,7 @@ THE SOFTWARE.
 // MARK:- Class Setters
 
 -(void)setRgbColor:( UInt32 )rgb atIndex:(NSUInteger)index;
+-(void)setRgbColors:( const UInt32* _Nonnull )rgb count:(NSUInteger)count; // Colors 0 to count - 1, as one change
 -(void)setColorWithRed:(UInt8)r green:(UInt8)g blue:(UInt8)b atIndex:(NSUInteger)index;
 -(void)setColorAnimationWith:(NSUInteger)leftLimit rightLimit:(NSUInteger)right withStep:(NSInteger)steps cycleSpeed:(NSTimeInterval)speed ;
 -(void)setColorCount:(NSUInteger)count;
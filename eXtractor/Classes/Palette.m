@@ -38,6 +38,10 @@ THE SOFTWARE.
 @property NSTimeInterval cycleSpeed; // Number of 50Hz cycles :- PAL
 @property BOOL changes;
 
+@property NSUInteger updateDepth;   // Nesting of beginUpdates
+@property BOOL pendingChange;       // A change made within beginUpdates, counted by endUpdates
+@property BOOL swatchChanged;       // The swatch is redrawn on the next frame
+
 @end
 
 
@@ -82,6 +86,8 @@ THE SOFTWARE.
 
 -(void)loadWithContentsOfFile:( NSString* _Nonnull )file {
     NSData *data = [NSData dataWithContentsOfFile:file];
+    
+    [self beginUpdates];
 
     if ( data.length >= 768 ) { // ACT
         UInt8* byte = ( UInt8* )data.bytes;
@@ -119,8 +125,8 @@ THE SOFTWARE.
         }
     }
     
-    
-    self.changes = YES;
+    self.pendingChange = YES;
+    [self endUpdates];
 }
 
 -(void)saveAsPhotoshopActAtPath:( NSString* _Nonnull )path {
@@ -195,46 +201,41 @@ THE SOFTWARE.
 -(BOOL)updateWithDelta:(NSTimeInterval)delta {
     self.frameCount += delta * 50.0;
     
-    BOOL changes = self.changes;
-    self.changes = NO;
-    
     if (self.frameCount >= fabs(self.cycleSpeed)) {
         self.frameCount = 0.0;
-        if (self.colorSteps == 0) {
-            return changes;
+        if (self.colorSteps != 0) {
+            [self beginUpdates];
+            [self cycleColors];
+            [self endUpdates];
         }
-        for (NSInteger s=0; s<self.colorSteps; s++) {
-            /*
-            if (self.cycleSpeed > 0.0) {
-                UInt32 tmpColor = [self rgbColorAtIndex:self.lowerLimit];
-                for (NSUInteger i=self.lowerLimit; i<self.upperLimit; i++) {
-                    [self setRgbColor:[self rgbColorAtIndex:i + 1] atIndex:i];
-                }
-                [self setRgbColor:tmpColor atIndex:self.upperLimit];
-            }
-            
-            if (self.cycleSpeed < 0.0) {
-                UInt32 tmpColor = [self rgbColorAtIndex:self.upperLimit];
-                for (NSUInteger i=self.upperLimit; i>self.lowerLimit; i--) {
-                    [self setRgbColor:[self rgbColorAtIndex:i - 1] atIndex:i];
-                }
-                [self setRgbColor:tmpColor atIndex:self.lowerLimit];
-            }
-             */
-            NSInteger d = self.cycleSpeed >  0.0 ? 1 : -1;
-            NSInteger i = d == 1 ? self.lowerLimit : self.upperLimit;
-            NSInteger j = d == 1 ? self.upperLimit : self.lowerLimit;
-            UInt32 t = [self rgbColorAtIndex:i];
-            for (; i!=j; i+=d) {
-                [self setRgbColor:[self rgbColorAtIndex:i + d] atIndex:i];
-            }
-            [self setRgbColor:t atIndex:j];
-        }
-        return YES;
     }
+    
+    BOOL changes = self.changes;
+    self.changes = NO;
+    
+    if (self.swatchChanged == YES && self.updateDepth == 0) {
+        self.swatchChanged = NO;
+        [Colors redrawPalette:self.mutableData.bytes colorCount:self.colorCount];
+    }
+    
     return changes;
 }
 
+-(void)beginUpdates {
+    self.updateDepth++;
+}
+
+-(void)endUpdates {
+    if (self.updateDepth == 0) return;
+    self.updateDepth--;
+    
+    if (self.updateDepth == 0 && self.pendingChange == YES) {
+        self.pendingChange = NO;
+        _changeCount++;
+        self.changes = YES;
+    }
+}
+
 // MARK: - Public Class Methods
 
 // ZX Spectrum NEXT :- R2 R1 R0 G2 G1 G0 B1 B0
@@ -355,8 +356,16 @@ THE SOFTWARE.
 
 -(void)setRgbColor:( UInt32 )rgb atIndex:(NSUInteger)index {
     *( UInt32* )( self.mutableData.mutableBytes + ( ( index & 255 ) * sizeof(UInt32) ) ) = rgb | 0xFF000000;
-    [Colors redrawPalette:self.mutableData.bytes colorCount:self.colorCount];
-    self.changes = YES;
+    [self colorsChanged];
+}
+
+-(void)setRgbColors:( const UInt32* _Nonnull )rgb count:(NSUInteger)count {
+    UInt32 *pal = self.mutableData.mutableBytes;
+    
+    for (NSUInteger i = 0; i < count && i < 256; i++) {
+        pal[i] = rgb[i] | 0xFF000000;
+    }
+    [self colorsChanged];
 }
 
 -(void)setColorWithRed:(UInt8)r green:(UInt8)g blue:(UInt8)b atIndex:(NSUInteger)index {
@@ -364,8 +373,7 @@ THE SOFTWARE.
     if (index == _transparentIndex) {
         *( UInt32* )( self.mutableData.mutableBytes + ( ( index & 255 ) * sizeof(UInt32) ) ) &= 0x00FFFFFF;
     }
-    [Colors redrawPalette:self.mutableData.bytes colorCount:self.colorCount];
-    self.changes = YES;
+    [self colorsChanged];
 }
 
 -(void)setColorAnimationWith:(NSUInteger)leftLimit rightLimit:(NSUInteger)right withStep:(NSInteger)steps cycleSpeed:(NSTimeInterval)speed {
@@ -377,11 +385,60 @@ THE SOFTWARE.
 
 -(void)setColorCount:(NSUInteger)count {
     _colorCount = count < 1 ? 256 : count;
-    [Colors redrawPalette:self.mutableData.bytes colorCount:self.colorCount];
+    [self colorsChanged];
 }
 
 -(void)setTransparentIndex:(NSUInteger)index {
     _transparentIndex = index & 255;
+    if (self.updateDepth > 0) {
+        self.pendingChange = YES;
+        return;
+    }
+    _changeCount++;
+}
+
+// MARK: - Private Instance Methods
+
+// Counts a change of the colors, or defers it to endUpdates.
+-(void)colorsChanged {
+    self.swatchChanged = YES;
+    
+    if (self.updateDepth > 0) {
+        self.pendingChange = YES;
+        return;
+    }
+    _changeCount++;
+    self.changes = YES;
+}
+
+-(void)cycleColors {
+    for (NSInteger s=0; s<self.colorSteps; s++) {
+        /*
+        if (self.cycleSpeed > 0.0) {
+            UInt32 tmpColor = [self rgbColorAtIndex:self.lowerLimit];
+            for (NSUInteger i=self.lowerLimit; i<self.upperLimit; i++) {
+                [self setRgbColor:[self rgbColorAtIndex:i + 1] atIndex:i];
+            }
+            [self setRgbColor:tmpColor atIndex:self.upperLimit];
+        }
+        
+        if (self.cycleSpeed < 0.0) {
+            UInt32 tmpColor = [self rgbColorAtIndex:self.upperLimit];
+            for (NSUInteger i=self.upperLimit; i>self.lowerLimit; i--) {
+                [self setRgbColor:[self rgbColorAtIndex:i - 1] atIndex:i];
+            }
+            [self setRgbColor:tmpColor atIndex:self.lowerLimit];
+        }
+         */
+        NSInteger d = self.cycleSpeed >  0.0 ? 1 : -1;
+        NSInteger i = d == 1 ? self.lowerLimit : self.upperLimit;
+        NSInteger j = d == 1 ? self.upperLimit : self.lowerLimit;
+        UInt32 t = [self rgbColorAtIndex:i];
+        for (; i!=j; i+=d) {
+            [self setRgbColor:[self rgbColorAtIndex:i + d] atIndex:i];
+        }
+        [self setRgbColor:t atIndex:j];
+    }
 }
 
 // MARK:- Private Class Methods